@@ -13,8 +13,16 @@
 
 #include <HeapAllocator.hpp>
 
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+
 #include "ELFParser.hpp"
+#include "Lz4.hpp"
+#include "MemoryOps.hpp"
 #include "kernel.h"
+#include "module_api.h"
+#include "ModuleValidation.hpp"
 
 typedef void (*TaskFunction)(void *);
 
@@ -44,43 +52,51 @@ struct TaskControlBlock
     uint32_t enterCycles;
     uint32_t exitCycles;
     uint64_t executionTime;
+    struct ModuleControlBlock *module; // Owning module, nullptr for other tasks
     char name[20u];
 };
 
 typedef struct TaskControlBlock TaskControlBlock;
 
-// Must match module ProgramInfo
-typedef struct ProgramInfoBin
-{
-    uint32_t stackPointer;
-    uint32_t entryPoint; // offset from image base; code is Thumb PIE
-    uint32_t vectors[74];
-    uint32_t section_data_start_addr; // offset in image of .data load
-    uint32_t section_data_dest_addr;
-    uint32_t section_data_size;
-    uint32_t section_bss_start_addr;
-    uint32_t section_bss_size;
-    uint32_t reserved[22];
-    uint32_t vtor_offset;
-    uint32_t msp_limit;
-} ProgramInfoBin;
-
-// Optional descriptor directly following ProgramInfo in our module format
-typedef struct __attribute__((packed)) ModuleDescriptorBin
-{
-    uint32_t magic; // 'MODU' 0x4D4F4455
-    uint16_t desc_version;
-    uint16_t _r0;
-    uint32_t api_version;
-    uint8_t name[32];
+// Code image shared by every task instance of the same static-base module
+struct ModuleImage
+{
+    ModuleImage *next;
+    uint8_t *code;
+    uint32_t size;
+    uint32_t crc;
+    uint32_t refs;
+    uint8_t name[32u];
     uint8_t semver_major;
     uint8_t semver_minor;
     uint16_t semver_patch;
-    uint32_t build_timestamp;
-    uint32_t image_size; // total size of BIN
-    uint32_t entry;      // address; ignore for BIN loader
-    uint32_t reserved[6];
-} ModuleDescriptorBin;
+};
+
+// Loaded module, owns its code image, its RAM region and every task it started
+struct ModuleControlBlock
+{
+    uint8_t *image;          // Private code image, nullptr when shared or executed in place
+    ModuleImage *shared;     // Cached code image of a static-base module
+    uint8_t *ram;            // .data, .bss and the main task stack
+    TaskControlBlock *task;  // Main task, its stack lives in ram
+    uint32_t tasks;          // Tasks of the module still alive
+    struct ModuleSwap *swap; // Pending Module::Replace of this module
+    uint8_t *state;          // State handed over by the replaced instance
+    uint32_t stateSize;
+    uint32_t id;             // Value of its ModuleHandle, never 0
+    ModuleControlBlock *next;
+};
+
+// Hand-over between Module::Replace and the main task of the replaced module,
+// lives on the stack of the replacing task
+struct ModuleSwap
+{
+    CRTOS::BinarySemaphore parked; // Signalled once the old main task reached its swap point
+    volatile bool claimed;         // Old main task took the swap, set under the mask
+    CRTOS::Result result;
+    uint8_t *state;
+    uint32_t stateSize;
+};
 
 typedef struct
 {
@@ -128,8 +144,51 @@ extern "C" void startFirstTask(void) __attribute__((naked));
 static inline void __DSB(void);
 static inline void __ISB(void);
 
-extern "C" void memcpy_optimized(void *d, void *s, uint32_t len);
-extern "C" void memset_optimized(void *d, uint32_t val, uint32_t len);
+#if MEMORY_OPS_HISTOGRAM
+static constexpr uint32_t COPY_HISTOGRAM_BUCKETS = 18u;
+
+struct CopyHistogram
+{
+    uint32_t calls[COPY_HISTOGRAM_BUCKETS];
+    uint32_t misaligned[COPY_HISTOGRAM_BUCKETS];
+};
+
+// Index 0 counts copies, index 1 fills
+static CopyHistogram sCopyHistogram[2u];
+
+static void countCopy(CopyHistogram &histogram, uint32_t len, uintptr_t addresses)
+{
+    uint32_t bucket = (len == 0u) ? 0u : (32u - (uint32_t)__builtin_clz(len));
+    if (bucket >= COPY_HISTOGRAM_BUCKETS)
+    {
+        bucket = COPY_HISTOGRAM_BUCKETS - 1u;
+    }
+
+    uint32_t mask = getInterruptMask();
+    histogram.calls[bucket]++;
+    if ((addresses & 3u) != 0u)
+    {
+        histogram.misaligned[bucket]++;
+    }
+    setInterruptMask(mask);
+}
+
+static void *probedCopy(void *dst, const void *src, uint32_t len)
+{
+    countCopy(sCopyHistogram[0u], len, (uintptr_t)dst | (uintptr_t)src);
+    return memcpy_optimized(dst, src, len);
+}
+
+static void *probedSet(void *dst, uint32_t val, uint32_t len)
+{
+    countCopy(sCopyHistogram[1u], len, (uintptr_t)dst);
+    return memset_optimized(dst, val, len);
+}
+
+// Every kernel call site below is counted before it reaches the routine
+#define memcpy_optimized(dst, src, len) probedCopy((dst), (src), (len))
+#define memset_optimized(dst, val, len) probedSet((dst), (val), (len))
+#endif
 
 static volatile uint32_t tickCount  = 0u;
 
@@ -137,13 +196,38 @@ static uint32_t MAX_TASK_PRIORITY   = 10u;
 static uint32_t sTickRate           = 1000u;
 static uint32_t sCoreClock          = 150000000u;
 
-static constexpr uint32_t MODULE_MAGIC          = 0x4D4F4455u; // 'MODU'
 static constexpr uint32_t DEFAULT_MODULE_LEN    = 4096u;
-static constexpr uint32_t DEFAULT_STACK_SIZE    = 1024u;
+static constexpr uint32_t DEFAULT_STACK_SIZE    = MODULE_DEFAULT_STACK_SIZE;
+// Unused stack words keep this pattern, see Task::GetFreeStack
+static constexpr uint32_t STACK_PAINT           = 0xDEADBEEFu;
 
 static HeapAllocator mem;
+static HeapAllocator kernelMem;
+
+// Kernel objects (TCBs, list nodes, CRC table) come from the reserved kernel
+// pool when InitMem was given one, so applications cannot starve the kernel.
+static HeapAllocator *sKernelHeap = &mem;
+
+static inline HeapAllocator &kernelHeap(void)
+{
+    return *sKernelHeap;
+}
+
+// Releases memory from whichever heap it was allocated from
+static inline void kernelDeallocate(void *ptr)
+{
+    if (kernelMem.owns(ptr))
+    {
+        kernelMem.deallocate(ptr);
+    }
+    else
+    {
+        mem.deallocate(ptr);
+    }
+}
 
 static bool isPendingTask(void);
+static CRTOS::Result createTask(TaskFunction function, const char *const name, uint32_t stackDepth, void *args, uint32_t prio, CRTOS::Task::TaskHandle *handle, HeapAllocator &stackHeap);
 
 volatile uint32_t switchTime = 0u;
 volatile uint32_t switchStartTime = 0u;
@@ -207,7 +291,7 @@ public:
 template <typename T>
 inline void ListInsertAtBeginning(Node<T> *&head, T *data)
 {
-    Node<T> *newNode = reinterpret_cast<Node<T> *>(mem.allocate(sizeof(Node<T>)));
+    Node<T> *newNode = reinterpret_cast<Node<T> *>(kernelHeap().allocate(sizeof(Node<T>)));
     if (__builtin_expect(newNode == nullptr, 0))
         return;
 
@@ -231,7 +315,7 @@ inline void ListInsertAtBeginning(Node<T> *&head, T *data)
 template <typename T>
 inline void ListInsertAtEnd(Node<T> *&head, T *data)
 {
-    Node<T> *newNode = reinterpret_cast<Node<T> *>(mem.allocate(sizeof(Node<T>)));
+    Node<T> *newNode = reinterpret_cast<Node<T> *>(kernelHeap().allocate(sizeof(Node<T>)));
     if (__builtin_expect(newNode == nullptr, 0))
         return;
 
@@ -277,7 +361,7 @@ inline void ListInsertAtPosition(Node<T> *&head, T *data, uint32_t position)
         return;
     }
 
-    Node<T> *newNode = reinterpret_cast<Node<T> *>(mem.allocate(sizeof(Node<T>)));
+    Node<T> *newNode = reinterpret_cast<Node<T> *>(kernelHeap().allocate(sizeof(Node<T>)));
     if (__builtin_expect(newNode == nullptr, 0))
         return;
 
@@ -293,7 +377,7 @@ inline void ListInsertAtPosition(Node<T> *&head, T *data, uint32_t position)
 
     if (__builtin_expect(current == nullptr, 0))
     {
-        mem.deallocate(newNode);
+        kernelDeallocate(newNode);
         return;
     }
 
@@ -336,7 +420,7 @@ inline void ListDeleteAtBeginning(Node<T> *&head)
         Node<T>::tail = head;
     }
 
-    mem.deallocate(nodeToDelete);
+    kernelDeallocate(nodeToDelete);
 }
 
 // O(1) delete at end using tail pointer
@@ -350,7 +434,7 @@ inline void ListDeleteAtEnd(Node<T> *&head)
 
     if (head->next == nullptr)
     {
-        mem.deallocate(head);
+        kernelDeallocate(head);
         head = nullptr;
         Node<T>::tail = nullptr;
         return;
@@ -376,7 +460,7 @@ inline void ListDeleteAtEnd(Node<T> *&head)
         Node<T>::tail->next = nullptr;
     }
 
-    mem.deallocate(nodeToDelete);
+    kernelDeallocate(nodeToDelete);
 }
 
 // Optimized delete at position
@@ -414,7 +498,7 @@ inline void ListDeleteAtPosition(Node<T> *&head, uint32_t position)
 
     current->prev->next = current->next;
     current->next->prev = current->prev;
-    mem.deallocate(current);
+    kernelDeallocate(current);
 }
 
 // Fast search function - no allocation needed
@@ -444,18 +528,6 @@ Node<unsigned long *> *Node<unsigned long *>::tail = nullptr;
 static Node<TaskControlBlock> *readyTaskList = nullptr;
 static Node<CRTOS::Timer::SoftwareTimer> *sTimerList = nullptr;
 
-uint32_t pStringLength(const char *buffer)
-{
-    const char *tmp = buffer;
-
-    while (*tmp != 0)
-    {
-        tmp++;
-    }
-
-    return (tmp - buffer) + 1;
-}
-
 CRTOS::Mutex::Mutex(void) : flag(ATOMIC_FLAG_INIT)
 {
 }
@@ -478,14 +550,40 @@ void CRTOS::Mutex::Unlock(void)
     setInterruptMask(irqMask);
 }
 
-CRTOS::Result CRTOS::Config::InitMem(void *pool, uint32_t size)
+CRTOS::Result CRTOS::Config::InitMem(void *pool, uint32_t size, uint32_t kernelSize)
 {
     if (pool == nullptr || size == 0u)
     {
         return CRTOS::Result::RESULT_NO_MEMORY;
     }
 
-    mem.init(pool, size);
+    uint32_t minimum = HeapAllocator::getMinimumPoolSize();
+
+    if (kernelSize == 0u)
+    {
+        if (size < minimum)
+        {
+            return CRTOS::Result::RESULT_BAD_PARAMETER;
+        }
+
+        mem.init(pool, size);
+        // Drop a pool left from an earlier split, kernelDeallocate must not match it
+        kernelMem = HeapAllocator();
+        sKernelHeap = &mem;
+
+        return CRTOS::Result::RESULT_SUCCESS;
+    }
+
+    // Kernel pool takes the beginning of the memory, keep the application pool 8-byte aligned
+    kernelSize = (kernelSize + 7u) & ~7u;
+    if (kernelSize < minimum || kernelSize >= size || size - kernelSize < minimum)
+    {
+        return CRTOS::Result::RESULT_BAD_PARAMETER;
+    }
+
+    kernelMem.init(pool, kernelSize);
+    mem.init((uint8_t *)pool + kernelSize, size - kernelSize);
+    sKernelHeap = &kernelMem;
 
     return CRTOS::Result::RESULT_SUCCESS;
 }
@@ -500,175 +598,251 @@ uint32_t CRTOS::Config::GetFreeMemory(void)
     return mem.getFreeMemory();
 }
 
-CRTOS::Result CRTOS::Timer::Init(SoftwareTimer *timer, uint32_t timeoutTicks, void (*callback)(void *), void *callbackArgs, bool autoReload)
+uint32_t CRTOS::Config::GetKernelAllocatedMemory(void)
 {
-    if (timer == nullptr || callback == nullptr)
+    return kernelHeap().getAllocatedMemory();
+}
+
+uint32_t CRTOS::Config::GetKernelFreeMemory(void)
+{
+    return kernelHeap().getFreeMemory();
+}
+
+CRTOS::Result CRTOS::Memory::AllocateMovable(uint32_t size, Handle &handle)
+{
+    if (size == 0u)
     {
         return CRTOS::Result::RESULT_BAD_PARAMETER;
     }
 
-    timer->timeoutTicks = timeoutTicks;
-    timer->elapsedTicks = 0u;
-    timer->isActive = false;
-    timer->callback = callback;
-    timer->callbackArgs = callbackArgs;
-    timer->autoReload = autoReload;
+    uint32_t mask = getInterruptMask();
+    handle = mem.allocateMovable(size);
+    setInterruptMask(mask);
 
-    ListInsertAtBeginning(sTimerList, timer);
+    if (handle == HeapAllocator::INVALID_HANDLE)
+    {
+        return CRTOS::Result::RESULT_NO_MEMORY;
+    }
 
     return CRTOS::Result::RESULT_SUCCESS;
 }
 
-CRTOS::Result CRTOS::Timer::Start(SoftwareTimer *timer)
+CRTOS::Result CRTOS::Memory::FreeMovable(Handle handle)
 {
-    if (timer == nullptr)
+    if (handle == HeapAllocator::INVALID_HANDLE)
     {
         return CRTOS::Result::RESULT_BAD_PARAMETER;
     }
-    if (timer->isActive == true)
+
+    CRTOS::Result result = CRTOS::Result::RESULT_SUCCESS;
+    uint32_t mask = getInterruptMask();
+
+    if (!mem.deallocateMovable(handle))
     {
-        return CRTOS::Result::RESULT_TIMER_ALREADY_ACTIVE;
+        result = mem.isLocked(handle) ? CRTOS::Result::RESULT_MEMORY_LOCKED : CRTOS::Result::RESULT_BAD_PARAMETER;
     }
 
-    timer->elapsedTicks = 0u;
-    timer->isActive = true;
+    setInterruptMask(mask);
 
-    return CRTOS::Result::RESULT_SUCCESS;
+    return result;
 }
 
-CRTOS::Result CRTOS::Timer::Stop(SoftwareTimer *timer)
+CRTOS::Result CRTOS::Memory::Lock(Handle handle, void *&ptr)
 {
-    if (timer == nullptr)
+    uint32_t mask = getInterruptMask();
+    ptr = mem.lock(handle);
+    setInterruptMask(mask);
+
+    if (ptr == nullptr)
     {
         return CRTOS::Result::RESULT_BAD_PARAMETER;
     }
-    if (timer->isActive == true)
-    {
-        return CRTOS::Result::RESULT_TIMER_ALREADY_STOPPED;
-    }
-
-    timer->isActive = false;
-    timer->elapsedTicks = 0u;
 
     return CRTOS::Result::RESULT_SUCCESS;
 }
 
-void CRTOS::Config::SetCoreClock(uint32_t clock)
+CRTOS::Result CRTOS::Memory::Unlock(Handle handle)
 {
-    if (clock > 1000000u)
+    if (handle == HeapAllocator::INVALID_HANDLE)
     {
-        sCoreClock = clock;
+        return CRTOS::Result::RESULT_BAD_PARAMETER;
     }
+
+    uint32_t mask = getInterruptMask();
+    mem.unlock(handle);
+    setInterruptMask(mask);
+
+    return CRTOS::Result::RESULT_SUCCESS;
 }
 
-void CRTOS::Config::SetTickRate(uint32_t ticks)
+// One block is moved per critical section, so interrupts wait for at most a single
+// block copy however fragmented the heap is
+uint32_t CRTOS::Memory::Compact(void)
 {
-    if (ticks < 1000000)
+    uint32_t moves = 0u;
+
+    for (;;)
     {
-        sTickRate = ticks;
+        uint32_t mask = getInterruptMask();
+        uint32_t moved = mem.compact(1u);
+        setInterruptMask(mask);
+
+        if (moved == 0u)
+        {
+            break;
+        }
+        moves += moved;
     }
+
+    return moves;
 }
 
-inline __attribute__((always_inline)) uint32_t getInterruptMask(void)
-{
-    uint32_t basepri, newBasepri;
+static constexpr uint32_t COPY_WORKER_STACK    = 256u;
+static constexpr uint32_t COPY_WORKER_PRIORITY = 1u;
+static constexpr uint32_t COPY_WORKER_POLL     = 100u;
 
-    __asm volatile(
-        "mrs %0, basepri    \n"
-        "mov %1, %2         \n"
-        "msr basepri, %1    \n"
-        "isb                \n"
-        "dsb                \n"
-        : "=r"(basepri), "=r"(newBasepri) : "i"(MAX_SYSCALL_IRQ_PRIO) : "memory");
+static CRTOS::Memory::CopyRequest *sCopyQueue = nullptr;
+static CRTOS::Memory::CopyRequest *sCopyActive = nullptr;
+static CRTOS::Memory::CopyRequest *sSoftwareCopy = nullptr;
+static CRTOS::Task::TaskHandle sCopyWorkerTask = nullptr;
+static CRTOS::BinarySemaphore sCopyWake;
 
-    return basepri;
+static void softwareCopyStart(CRTOS::Memory::CopyRequest *request)
+{
+    sSoftwareCopy = request;
+    sCopyWake.signal();
 }
 
-inline __attribute__((always_inline)) void setInterruptMask(uint32_t mask)
+static const CRTOS::Memory::CopyEngine sSoftwareCopyEngine = { softwareCopyStart };
+static const CRTOS::Memory::CopyEngine *sCopyEngine = &sSoftwareCopyEngine;
+
+// Software backend. Running just above IDLE, the copy takes CPU time nobody else
+// wants and leaves interrupts enabled.
+static void copyWorkerTask(void *)
 {
-    __asm__ volatile("msr basepri, %0" ::"r"(mask) : "memory");
+    for (;;)
+    {
+        uint32_t mask = getInterruptMask();
+        CRTOS::Memory::CopyRequest *request = sSoftwareCopy;
+        sSoftwareCopy = nullptr;
+        setInterruptMask(mask);
+
+        if (request == nullptr)
+        {
+            sCopyWake.wait(COPY_WORKER_POLL);
+            continue;
+        }
+
+        memcpy_optimized(request->dst, request->src, request->length);
+        CRTOS::Memory::CopyDone(request, CRTOS::Result::RESULT_SUCCESS);
+    }
 }
 
-uint32_t CRTOS::Task::EnterCriticalSection(void)
+// Creates the software backend task on first use, interrupts masked
+static CRTOS::Result createCopyWorker(void)
 {
-    uint32_t mask = getInterruptMask();
-    return mask;
+    if (sCopyWorkerTask != nullptr)
+    {
+        return CRTOS::Result::RESULT_SUCCESS;
+    }
+
+    CRTOS::Result result = createTask(copyWorkerTask, "Copy", COPY_WORKER_STACK, nullptr, COPY_WORKER_PRIORITY, &sCopyWorkerTask, kernelHeap());
+    if (result != CRTOS::Result::RESULT_SUCCESS)
+    {
+        sCopyWorkerTask = nullptr;
+        return result;
+    }
+
+    // Kernel service, not owned by a module that happened to ask for it first
+    TaskControlBlock *worker = (TaskControlBlock *)sCopyWorkerTask;
+    if (worker->module != nullptr)
+    {
+        worker->module->tasks--;
+        worker->module = nullptr;
+    }
+
+    return result;
 }
 
-void CRTOS::Task::ExitCriticalSection(uint32_t mask = 0u)
+// Hands the oldest queued request to the engine if it is idle, interrupts masked
+static void startNextCopy(void)
 {
-    setInterruptMask(mask);
+    if (sCopyActive != nullptr || sCopyQueue == nullptr)
+    {
+        return;
+    }
+
+    sCopyActive = sCopyQueue;
+    sCopyQueue = sCopyActive->next;
+    sCopyEngine->start(sCopyActive);
 }
 
-static bool isPendingTask(void)
+CRTOS::Result CRTOS::Memory::CopyAsync(void *dst, const void *src, uint32_t len, CopyRequest *request)
 {
-    Node<TaskControlBlock> *temp = readyTaskList;
-    while (temp != nullptr)
+    if (request == nullptr || dst == nullptr || src == nullptr)
     {
-        if (temp->data->state == TaskState::TASK_DELAYED)
-        {
-            if (tickCount >= temp->data->delayUpTo)
-            {
-                temp->data->state = TaskState::TASK_READY;
-            }
-        }
-        if (temp->data->state == TaskState::TASK_READY)
-        {
-            return true;
-        }
+        return CRTOS::Result::RESULT_BAD_PARAMETER;
+    }
 
-        temp = temp->next;
+    request->dst = dst;
+    request->src = src;
+    request->length = len;
+    request->result = CRTOS::Result::RESULT_COPY_PENDING;
+    request->next = nullptr;
+
+    if (len == 0u)
+    {
+        CopyDone(request, CRTOS::Result::RESULT_SUCCESS);
+        return CRTOS::Result::RESULT_SUCCESS;
     }
 
-    return false;
-}
+    CRTOS::Result result = CRTOS::Result::RESULT_SUCCESS;
+    uint32_t prevMask = getInterruptMask();
 
-bool isHigherPrioTaskPending(void)
-{
-    Node<TaskControlBlock> *temp = readyTaskList;
-    while (temp != nullptr)
+    do
     {
-        if (temp->data->state == TaskState::TASK_DELAYED)
+        if (sCopyEngine == &sSoftwareCopyEngine)
         {
-            if (tickCount >= temp->data->delayUpTo)
+            result = createCopyWorker();
+            if (result != CRTOS::Result::RESULT_SUCCESS)
             {
-                temp->data->state = TaskState::TASK_READY;
+                continue;
             }
         }
-        if ((temp->data->state == TaskState::TASK_READY) && (sCurrentTCB->priority < temp->data->priority))
+
+        CopyRequest **tail = &sCopyQueue;
+        while (*tail != nullptr)
         {
-            return true;
+            tail = &(*tail)->next;
         }
+        *tail = request;
 
-        temp = temp->next;
-    }
+        startNextCopy();
+    } while (0);
 
-    return false;
+    setInterruptMask(prevMask);
+
+    return result;
 }
 
-CRTOS::Result CRTOS::BinarySemaphore::signal(void)
+CRTOS::Result CRTOS::Memory::SetCopyEngine(const CopyEngine *engine)
 {
-    CRTOS::Result result = CRTOS::Result::RESULT_SUCCESS;
+    if (engine != nullptr && engine->start == nullptr)
+    {
+        return CRTOS::Result::RESULT_BAD_PARAMETER;
+    }
 
+    CRTOS::Result result = CRTOS::Result::RESULT_SUCCESS;
     uint32_t mask = getInterruptMask();
 
-    if (_val > 0)
+    if (engine == nullptr)
     {
-        result = CRTOS::Result::RESULT_SEMAPHORE_BUSY;
+        // Requests still queued behind the active one go to the worker as well
+        result = createCopyWorker();
     }
-    else
+    if (result == CRTOS::Result::RESULT_SUCCESS)
     {
-        if (listOfTasksWaitingToRecv != nullptr)
-        {
-            TaskControlBlock *tmp = *(TaskControlBlock **)(listOfTasksWaitingToRecv->data);
-            if (tmp->state == TaskState::TASK_BLOCKED_BY_SEMAPHORE)
-            {
-                tmp->state = TaskState::TASK_READY;
-            }
-            ListDeleteAtBeginning(listOfTasksWaitingToRecv);
-        }
-
-        _val = 1;
+        sCopyEngine = (engine != nullptr) ? engine : &sSoftwareCopyEngine;
     }
 
     setInterruptMask(mask);
@@ -676,794 +850,2685 @@ CRTOS::Result CRTOS::BinarySemaphore::signal(void)
     return result;
 }
 
-CRTOS::Result CRTOS::BinarySemaphore::wait(uint32_t ticks)
+void CRTOS::Memory::CopyDone(CopyRequest *request, Result result)
 {
-    CRTOS::Result result = CRTOS::Result::RESULT_SUCCESS;
-    uint32_t time = GetSystemTime();
-    uint32_t timeout = time + ticks;
-    bool isBlocked = false;
+    if (request == nullptr)
+    {
+        return;
+    }
 
-    for (;;)
+    // The caller may reuse the request once result is final, read what is needed first
+    BinarySemaphore *done = request->done;
+    void (*completion)(CopyRequest *) = request->completion;
+
+    uint32_t mask = getInterruptMask();
+    if (sCopyActive == request)
     {
-        uint32_t mask = getInterruptMask();
+        sCopyActive = nullptr;
+        startNextCopy();
+    }
+    request->result = result;
+    setInterruptMask(mask);
 
-        time = GetSystemTime();
+    if (completion != nullptr)
+    {
+        completion(request);
+    }
+    if (done != nullptr)
+    {
+        done->signal();
+    }
+}
 
-        if (_val > 0u)
-        {
-            _val = 0u;
-            setInterruptMask(mask);
-            return result;
-        }
-        else
-        {
-            if (ticks == 0u)
-            {
-                setInterruptMask(mask);
-                result = CRTOS::Result::RESULT_SEMAPHORE_TIMEOUT;
-                return result;
-            }
-
-            if (isBlocked == false)
-            {
-                sCurrentTCB->timeout = timeout;
-                sCurrentTCB->state = TaskState::TASK_BLOCKED_BY_SEMAPHORE;
-                uint32_t *tmp = (uint32_t *)sCurrentTCB;
-                ListInsertAtEnd(listOfTasksWaitingToRecv, &tmp);
-                isBlocked = true;
-            }
-        }
-
-        setInterruptMask(mask);
+#if MEMORY_OPS_DMA
+// LPC55S69 DMA0, memory to memory transfers started by software trigger
+static constexpr uint32_t DMA_CHANNELS       = 23u;
+static constexpr uint32_t DMA_MAX_TRANSFERS  = 1024u;
+static constexpr uint32_t DMA0_IRQ           = 1u;
+static constexpr uint32_t SYSCON_DMA0_BIT    = 1ul << 20u;
 
-        if (time < timeout)
-        {
-            if (_val > 0u)
-            {
-                mask = getInterruptMask();
-                if (listOfTasksWaitingToRecv != nullptr)
-                {
-                    TaskControlBlock *tmp = *(TaskControlBlock **)(listOfTasksWaitingToRecv->data);
-                    if (tmp->state == TaskState::TASK_BLOCKED_BY_SEMAPHORE)
-                    {
-                        tmp->state = TaskState::TASK_READY;
-                    }
-                    ListDeleteAtBeginning(listOfTasksWaitingToRecv);
-                }
-                setInterruptMask(mask);
+#define SYSCON_PRESETCTRLCLR0_REG ((volatile uint32_t *)0x40000140ul)
+#define SYSCON_AHBCLKCTRLSET0_REG ((volatile uint32_t *)0x40000220ul)
+#define NVIC_ISER0_REG ((volatile uint32_t *)0xE000E100ul)
+#define NVIC_IPR_REG ((volatile uint8_t *)0xE000E400ul)
 
-                if (isHigherPrioTaskPending() == true)
-                {
-                    *ICSR_REG = NVIC_PENDSV_BIT;
+typedef struct
+{
+    volatile uint32_t CFG;
+    volatile uint32_t CTLSTAT;
+    volatile uint32_t XFERCFG;
+    uint32_t reserved;
+} DMA_Channel_Type;
 
-                    __DSB();
-                    __ISB();
-                }
-            }
-        }
-        else
-        {
-            // Timeout occurred - remove ourselves from waiting list
-            mask = getInterruptMask();
+typedef struct
+{
+    volatile uint32_t CTRL;
+    volatile uint32_t INTSTAT;
+    volatile uint32_t SRAMBASE;
+    uint32_t reserved0[5];
+    volatile uint32_t ENABLESET0;
+    uint32_t reserved1;
+    volatile uint32_t ENABLECLR0;
+    uint32_t reserved2;
+    volatile uint32_t ACTIVE0;
+    uint32_t reserved3;
+    volatile uint32_t BUSY0;
+    uint32_t reserved4;
+    volatile uint32_t ERRINT0;
+    uint32_t reserved5;
+    volatile uint32_t INTENSET0;
+    uint32_t reserved6;
+    volatile uint32_t INTENCLR0;
+    uint32_t reserved7;
+    volatile uint32_t INTA0;
+    uint32_t reserved8;
+    volatile uint32_t INTB0;
+    uint32_t reserved9;
+    volatile uint32_t SETVALID0;
+    uint32_t reserved10;
+    volatile uint32_t SETTRIG0;
+    uint32_t reserved11;
+    volatile uint32_t ABORT0;
+    uint32_t reserved12[225];
+    DMA_Channel_Type CHANNEL[DMA_CHANNELS];
+} DMA_Type;
+
+#define DMA0 ((DMA_Type *)0x40082000ul)
+
+#define DMA_XFERCFG_CFGVALID (1ul << 0u)
+#define DMA_XFERCFG_SWTRIG (1ul << 2u)
+#define DMA_XFERCFG_CLRTRIG (1ul << 3u)
+#define DMA_XFERCFG_SETINTA (1ul << 4u)
+#define DMA_XFERCFG_WIDTH(shift) ((uint32_t)(shift) << 8u)
+#define DMA_XFERCFG_SRCINC_WIDTH (1ul << 12u)
+#define DMA_XFERCFG_DSTINC_WIDTH (1ul << 14u)
+#define DMA_XFERCFG_XFERCOUNT(count) (((uint32_t)(count) - 1u) << 16u)
+
+struct DmaDescriptor
+{
+    uint32_t xfercfg;
+    uint32_t srcEnd;
+    uint32_t dstEnd;
+    uint32_t link;
+};
 
-            // Find and remove current task from waiting list
-            Node<uint32_t *> *temp = listOfTasksWaitingToRecv;
-            if (temp != nullptr)
-            {
-                ListDeleteAtBeginning(listOfTasksWaitingToRecv);
-            }
+alignas(512) static DmaDescriptor sDmaDescriptors[DMA_CHANNELS];
+static uint32_t sDmaChannel = 0u;
+static CRTOS::Memory::CopyRequest *sDmaRequest = nullptr;
+static uint32_t sDmaCopied = 0u;
 
-            sCurrentTCB->state = TaskState::TASK_READY;
-            setInterruptMask(mask);
+// Starts the next piece of sDmaRequest, at most DMA_MAX_TRANSFERS words or bytes
+static void dmaStartChunk(void)
+{
+    uint32_t src = (uint32_t)sDmaRequest->src + sDmaCopied;
+    uint32_t dst = (uint32_t)sDmaRequest->dst + sDmaCopied;
+    uint32_t left = sDmaRequest->length - sDmaCopied;
+    uint32_t shift = (((src | dst | left) & 3u) == 0u) ? 2u : 0u;
+    uint32_t count = left >> shift;
 
-            result = CRTOS::Result::RESULT_SEMAPHORE_TIMEOUT;
-            return result;
-        }
+    if (count > DMA_MAX_TRANSFERS)
+    {
+        count = DMA_MAX_TRANSFERS;
     }
+
+    // Descriptors hold the address of the last element
+    DmaDescriptor &descriptor = sDmaDescriptors[sDmaChannel];
+    descriptor.srcEnd = src + ((count - 1u) << shift);
+    descriptor.dstEnd = dst + ((count - 1u) << shift);
+    descriptor.link = 0u;
+
+    sDmaCopied += count << shift;
+    DMA0->CHANNEL[sDmaChannel].XFERCFG = DMA_XFERCFG_CFGVALID | DMA_XFERCFG_SWTRIG | DMA_XFERCFG_CLRTRIG |
+                                         DMA_XFERCFG_SETINTA | DMA_XFERCFG_WIDTH(shift) |
+                                         DMA_XFERCFG_SRCINC_WIDTH | DMA_XFERCFG_DSTINC_WIDTH |
+                                         DMA_XFERCFG_XFERCOUNT(count);
 }
 
-void RestoreCtxOfTheFirstTask(void)
+static void dmaCopyStart(CRTOS::Memory::CopyRequest *request)
 {
-    sCurrentTCB->enterCycles = DWT->CYCCNT;
-    __asm volatile(
-        ".syntax unified                       \n"
-        // Read top of the stack
-        "ldr  r2, currentCtxTCB                \n"
-        "ldr  r1, [r2]                         \n"
-        "ldr  r0, [r1]                         \n"
-        // R1 = PSPLIM || R2 = EXC_RETURN
-        "ldm  r0!, {r1-r2}                     \n"
-        // Set current task PSPLIM
-        "msr  psplim, r1                       \n"
-        // Switch to PSP - thread mode
-        "movs r1, #2                           \n"
-        "msr  CONTROL, r1                      \n"
-        // Discard R4-R11
-        "ldm   r0!, {r4-r11}                   \n"
-        // Update current PSP
-        "msr  psp, r0                          \n"
-        "isb                                   \n"
-        "mov  r0, #0                           \n"
-        // Enable interrupts and exit
-        "msr  basepri, r0                      \n"
-        "bx   r2                               \n"
-        ".align 4                              \n"
-        "currentCtxTCB: .word sCurrentTCB      \n");
+    sDmaRequest = request;
+    sDmaCopied = 0u;
+    dmaStartChunk();
 }
 
-extern "C" void SVC_Handle_Subprocess(uint32_t *command)
+static const CRTOS::Memory::CopyEngine sDmaCopyEngine = { dmaCopyStart };
+
+extern "C" void DMA0_IRQHandler(void)
 {
-    uint32_t command_id = (uint32_t)(((uint8_t *)command[6u])[-2u]);
-    uint32_t *callerStack = command;
+    uint32_t bit = 1ul << sDmaChannel;
+    CRTOS::Memory::CopyRequest *request = sDmaRequest;
+    CRTOS::Result result = CRTOS::Result::RESULT_SUCCESS;
 
-    switch (command_id)
+    if ((DMA0->ERRINT0 & bit) != 0u)
     {
-        case SVC_Commands::COMMAND_TASK_DELAY:
-            CRTOS::Task::Delay(callerStack[0u]);
-            break;
-        case SVC_Commands::COMMAND_START_SCHEDULER:
-            RestoreCtxOfTheFirstTask();
-            break;
-        default:
-            break;
+        DMA0->ERRINT0 = bit;
+        result = CRTOS::Result::RESULT_BAD_PARAMETER;
+    }
+    else if ((DMA0->INTA0 & bit) != 0u)
+    {
+        DMA0->INTA0 = bit;
+        if (request != nullptr && sDmaCopied < request->length)
+        {
+            dmaStartChunk();
+            return;
+        }
+    }
+    else
+    {
+        return;
     }
-}
 
-void SVC_Handler(void)
-{
-    __asm volatile(
-        ".syntax unified                              \n"
-        "tst lr, #4                                   \n"
-        "ite eq                                       \n"
-        "mrseq r0, msp                                \n"
-        "mrsne r0, psp                                \n"
-        "ldr r1, SVC_ISR_ADDR                         \n"
-        "bx r1                                        \n"
-        ".align 4                                     \n"
-        "SVC_ISR_ADDR:                                \n"
-        "\t.word SVC_Handle_Subprocess                \n");
+    sDmaRequest = nullptr;
+    CRTOS::Memory::CopyDone(request, result);
 }
+#endif
 
-extern "C" void PendSV_Handler(void)
+CRTOS::Result CRTOS::Memory::UseDmaCopyEngine(uint32_t channel)
 {
-    __asm volatile(
-        ".syntax unified     \n"
-        // Load PSP to R0, PSPLIM to R2, LR to r3
-        "mrs r0, psp         \n"
-        "tst lr, #0x10       \n"
-        "it eq               \n"
-        "vstmdbeq r0!, {s16-s31} \n"
-        "mrs r2, psplim      \n"
-        "mov r3, lr          \n"
-        // Save r2-r11 under PSP location
-        "stmdb r0!, {r2-r11} \n"
-        // Save new PSP
-        "ldr r2, currentTCB  \n"
-        "ldr r1, [r2]        \n"
-        "str r0, [r1]        \n"
-        // Perform context switch
-        "mov r0, %0          \n"
-        "msr basepri, r0     \n"
-        "dsb                 \n"
-        "isb                 \n"
-        "bl switchCtx        \n"
-        "mov r0, #0          \n"
-        "msr basepri, r0     \n"
-        // Load PSP address of next task to R0
-        "ldr r2, currentTCB  \n"
-        "ldr r1, [r2]        \n"
-        "ldr r0, [r1]        \n"
-        // Restore context of next task
-        "ldmia r0!, {r2-r11} \n"
-        "tst r3, #0x10       \n"
-        "it eq               \n"
-        "vldmiaeq r0!, {s16-s31} \n"
-        // Restore PSPLIM and set new PSP
-        "msr psplim, r2      \n"
-        "msr psp, r0         \n"
+#if MEMORY_OPS_DMA
+    if (channel >= DMA_CHANNELS)
+    {
+        return CRTOS::Result::RESULT_BAD_PARAMETER;
+    }
 
-        "ldr r0, [r1, #20]   \n"
-        "ldr r1, =0xE000ED08 \n"
-        "str r0, [r1]        \n"
-        // Leave interrupt
-        "bx r3               \n"
-        ".align 4            \n"
-        "currentTCB: .word sCurrentTCB \n" ::"i"(MAX_SYSCALL_IRQ_PRIO));
-}
+    uint32_t mask = getInterruptMask();
 
-void startFirstTask(void)
-{
-    __asm volatile(
-        ".syntax unified \n"
-        "cpsie i         \n"
-        "cpsie f         \n"
-        "dsb             \n"
-        "isb             \n"
-        "svc %0          \n"
-        "nop             \n"
-        ".align 4        \n" ::"i"(SVC_Commands::COMMAND_START_SCHEDULER) : "memory");
-}
+    *SYSCON_AHBCLKCTRLSET0_REG = SYSCON_DMA0_BIT;
+    *SYSCON_PRESETCTRLCLR0_REG = SYSCON_DMA0_BIT;
 
-__attribute__((always_inline)) static inline void __ISB(void)
-{
-    __asm volatile("isb 0xF" ::: "memory");
+    sDmaChannel = channel;
+    DMA0->SRAMBASE = (uint32_t)&sDmaDescriptors[0];
+    DMA0->CTRL = 1u;
+    DMA0->CHANNEL[channel].CFG = 0u;    // Software trigger, no peripheral request
+    DMA0->ENABLESET0 = 1ul << channel;
+    DMA0->INTENSET0 = 1ul << channel;
+
+    // Masked by kernel critical sections, so CopyDone may run from the handler
+    NVIC_IPR_REG[DMA0_IRQ] = (uint8_t)MAX_SYSCALL_IRQ_PRIO;
+    *NVIC_ISER0_REG = 1ul << DMA0_IRQ;
+
+    sCopyEngine = &sDmaCopyEngine;
+
+    setInterruptMask(mask);
+
+    return CRTOS::Result::RESULT_SUCCESS;
+#else
+    (void)channel;
+    return CRTOS::Result::RESULT_NOT_SUPPORTED;
+#endif
 }
 
-__attribute__((always_inline)) static inline void __DSB(void)
+#if HEAP_ALLOCATOR_TRACE
+static uint32_t heapTraceClock(void)
 {
-    __asm volatile("dsb 0xF" ::: "memory");
+    return DWT->CYCCNT;
 }
 
-extern "C" char *currentTaskName(void)
+static void *heapTraceContext(void)
 {
-    return (char *)(&(sCurrentTCB->name[0]));
+    return (void *)sCurrentTCB;
 }
+#endif
 
-void updateExitCycles(void)
+CRTOS::Result CRTOS::Config::EnableHeapTrace(void *buffer, uint32_t bufferSize)
 {
-    sCurrentTCB->exitCycles = DWT->CYCCNT;
+#if HEAP_ALLOCATOR_TRACE
+    uint32_t capacity = bufferSize / sizeof(HeapAllocator::TraceRecord);
+
+    if (buffer == nullptr || capacity == 0u)
+    {
+        return CRTOS::Result::RESULT_BAD_PARAMETER;
+    }
+
+    uint32_t mask = getInterruptMask();
+    mem.enableTrace(reinterpret_cast<HeapAllocator::TraceRecord *>(buffer), capacity, heapTraceClock, heapTraceContext);
+    setInterruptMask(mask);
+
+    return CRTOS::Result::RESULT_SUCCESS;
+#else
+    (void)buffer;
+    (void)bufferSize;
+    return CRTOS::Result::RESULT_NOT_SUPPORTED;
+#endif
 }
 
-void updateEnterCycles(void)
+CRTOS::Result CRTOS::Config::DisableHeapTrace(void)
 {
-    sCurrentTCB->enterCycles = DWT->CYCCNT;
+#if HEAP_ALLOCATOR_TRACE
+    uint32_t mask = getInterruptMask();
+    mem.disableTrace();
+    setInterruptMask(mask);
+
+    return CRTOS::Result::RESULT_SUCCESS;
+#else
+    return CRTOS::Result::RESULT_NOT_SUPPORTED;
+#endif
 }
 
-extern "C" void switchCtx(void)
+CRTOS::Result CRTOS::Config::DumpHeapTrace(void (*output)(const char *line))
 {
-    Node<TaskControlBlock> *temp = readyTaskList;
-    Node<TaskControlBlock> *highestPriorityTask = nullptr;
+#if HEAP_ALLOCATOR_TRACE
+    if (output == nullptr)
+    {
+        return CRTOS::Result::RESULT_BAD_PARAMETER;
+    }
 
-    TASK_SWITCHED_OUT();
-    updateExitCycles();
+    char line[64];
+    uint32_t index = 0u;
 
-    if (sCurrentTCB != nullptr)
+    for (;;)
     {
-        uint32_t elapsedCycles;
-        if (sCurrentTCB->enterCycles > sCurrentTCB->exitCycles)
+        HeapAllocator::TraceRecord record;
+
+        // Copy under lock only, the output callback may be slow (e.g. UART)
+        uint32_t mask = getInterruptMask();
+        const HeapAllocator::TraceRecord *src = mem.getTraceRecord(index);
+        if (src != nullptr)
         {
-            elapsedCycles = 0xFFFFFFFFu - sCurrentTCB->exitCycles + sCurrentTCB->enterCycles;
+            record = *src;
         }
-        else
+        setInterruptMask(mask);
+
+        if (src == nullptr)
         {
-            elapsedCycles = sCurrentTCB->exitCycles - sCurrentTCB->enterCycles;
+            break;
         }
 
-        sCurrentTCB->executionTime = elapsedCycles;
+        snprintf(line, sizeof(line), "%c,%lu,0x%08lx,0x%08lx,%lu\r\n",
+                 (record.op == HeapAllocator::TraceOp::TRACE_ALLOCATE) ? 'A' : 'D',
+                 (unsigned long)record.size, (unsigned long)record.ptr,
+                 (unsigned long)record.task, (unsigned long)record.cycles);
+        output(line);
+        index++;
     }
 
-    while (temp != nullptr)
-    {
-        switch (temp->data->state)
-        {
-            case TaskState::TASK_DELAYED:
-                if (tickCount >= temp->data->delayUpTo)
-                {
-                    temp->data->state = TaskState::TASK_READY;
-                }
-                break;
-            case TaskState::TASK_BLOCKED_BY_SEMAPHORE:
-                if (tickCount >= temp->data->timeout)
+    return CRTOS::Result::RESULT_SUCCESS;
+#else
+    (void)output;
+    return CRTOS::Result::RESULT_NOT_SUPPORTED;
+#endif
+}
+
+CRTOS::Result CRTOS::Config::ResetCopyHistogram(void)
+{
+#if MEMORY_OPS_HISTOGRAM
+    uint32_t mask = getInterruptMask();
+    memset(&sCopyHistogram[0u], 0, sizeof(sCopyHistogram));
+    setInterruptMask(mask);
+
+    return CRTOS::Result::RESULT_SUCCESS;
+#else
+    return CRTOS::Result::RESULT_NOT_SUPPORTED;
+#endif
+}
+
+CRTOS::Result CRTOS::Config::DumpCopyHistogram(void (*output)(const char *line))
+{
+#if MEMORY_OPS_HISTOGRAM
+    static const char *const opNames[2u] = { "memcpy", "memset" };
+
+    if (output == nullptr)
+    {
+        return CRTOS::Result::RESULT_BAD_PARAMETER;
+    }
+
+    char line[64];
+
+    for (uint32_t op = 0u; op < 2u; op++)
+    {
+        for (uint32_t bucket = 0u; bucket < COPY_HISTOGRAM_BUCKETS; bucket++)
+        {
+            uint32_t mask = getInterruptMask();
+            uint32_t calls = sCopyHistogram[op].calls[bucket];
+            uint32_t misaligned = sCopyHistogram[op].misaligned[bucket];
+            setInterruptMask(mask);
+
+            if (calls == 0u)
+            {
+                continue;
+            }
+
+            uint32_t minSize = (bucket == 0u) ? 0u : (1u << (bucket - 1u));
+            uint32_t maxSize = (bucket == 0u) ? 0u : ((bucket == COPY_HISTOGRAM_BUCKETS - 1u) ? 0xFFFFFFFFu : ((1u << bucket) - 1u));
+
+            snprintf(line, sizeof(line), "%s,%lu,%lu,%lu,%lu\r\n", opNames[op], (unsigned long)minSize,
+                     (unsigned long)maxSize, (unsigned long)calls, (unsigned long)misaligned);
+            output(line);
+        }
+    }
+
+    return CRTOS::Result::RESULT_SUCCESS;
+#else
+    (void)output;
+    return CRTOS::Result::RESULT_NOT_SUPPORTED;
+#endif
+}
+
+CRTOS::Result CRTOS::Timer::Init(SoftwareTimer *timer, uint32_t timeoutTicks, void (*callback)(void *), void *callbackArgs, bool autoReload)
+{
+    if (timer == nullptr || callback == nullptr)
+    {
+        return CRTOS::Result::RESULT_BAD_PARAMETER;
+    }
+
+    timer->timeoutTicks = timeoutTicks;
+    timer->elapsedTicks = 0u;
+    timer->isActive = false;
+    timer->callback = callback;
+    timer->callbackArgs = callbackArgs;
+    timer->autoReload = autoReload;
+
+    ListInsertAtBeginning(sTimerList, timer);
+
+    return CRTOS::Result::RESULT_SUCCESS;
+}
+
+CRTOS::Result CRTOS::Timer::Start(SoftwareTimer *timer)
+{
+    if (timer == nullptr)
+    {
+        return CRTOS::Result::RESULT_BAD_PARAMETER;
+    }
+    if (timer->isActive == true)
+    {
+        return CRTOS::Result::RESULT_TIMER_ALREADY_ACTIVE;
+    }
+
+    timer->elapsedTicks = 0u;
+    timer->isActive = true;
+
+    return CRTOS::Result::RESULT_SUCCESS;
+}
+
+CRTOS::Result CRTOS::Timer::Stop(SoftwareTimer *timer)
+{
+    if (timer == nullptr)
+    {
+        return CRTOS::Result::RESULT_BAD_PARAMETER;
+    }
+    if (timer->isActive == true)
+    {
+        return CRTOS::Result::RESULT_TIMER_ALREADY_STOPPED;
+    }
+
+    timer->isActive = false;
+    timer->elapsedTicks = 0u;
+
+    return CRTOS::Result::RESULT_SUCCESS;
+}
+
+void CRTOS::Config::SetCoreClock(uint32_t clock)
+{
+    if (clock > 1000000u)
+    {
+        sCoreClock = clock;
+    }
+}
+
+void CRTOS::Config::SetTickRate(uint32_t ticks)
+{
+    if (ticks < 1000000)
+    {
+        sTickRate = ticks;
+    }
+}
+
+inline __attribute__((always_inline)) uint32_t getInterruptMask(void)
+{
+    uint32_t basepri, newBasepri;
+
+    __asm volatile(
+        "mrs %0, basepri    \n"
+        "mov %1, %2         \n"
+        "msr basepri, %1    \n"
+        "isb                \n"
+        "dsb                \n"
+        : "=r"(basepri), "=r"(newBasepri) : "i"(MAX_SYSCALL_IRQ_PRIO) : "memory");
+
+    return basepri;
+}
+
+inline __attribute__((always_inline)) void setInterruptMask(uint32_t mask)
+{
+    __asm__ volatile("msr basepri, %0" ::"r"(mask) : "memory");
+}
+
+uint32_t CRTOS::Task::EnterCriticalSection(void)
+{
+    uint32_t mask = getInterruptMask();
+    return mask;
+}
+
+void CRTOS::Task::ExitCriticalSection(uint32_t mask = 0u)
+{
+    setInterruptMask(mask);
+}
+
+static bool isPendingTask(void)
+{
+    Node<TaskControlBlock> *temp = readyTaskList;
+    while (temp != nullptr)
+    {
+        if (temp->data->state == TaskState::TASK_DELAYED)
+        {
+            if (tickCount >= temp->data->delayUpTo)
+            {
+                temp->data->state = TaskState::TASK_READY;
+            }
+        }
+        if (temp->data->state == TaskState::TASK_READY)
+        {
+            return true;
+        }
+
+        temp = temp->next;
+    }
+
+    return false;
+}
+
+bool isHigherPrioTaskPending(void)
+{
+    Node<TaskControlBlock> *temp = readyTaskList;
+    while (temp != nullptr)
+    {
+        if (temp->data->state == TaskState::TASK_DELAYED)
+        {
+            if (tickCount >= temp->data->delayUpTo)
+            {
+                temp->data->state = TaskState::TASK_READY;
+            }
+        }
+        if ((temp->data->state == TaskState::TASK_READY) && (sCurrentTCB->priority < temp->data->priority))
+        {
+            return true;
+        }
+
+        temp = temp->next;
+    }
+
+    return false;
+}
+
+CRTOS::Result CRTOS::BinarySemaphore::signal(void)
+{
+    CRTOS::Result result = CRTOS::Result::RESULT_SUCCESS;
+
+    uint32_t mask = getInterruptMask();
+
+    if (_val > 0)
+    {
+        result = CRTOS::Result::RESULT_SEMAPHORE_BUSY;
+    }
+    else
+    {
+        if (listOfTasksWaitingToRecv != nullptr)
+        {
+            TaskControlBlock *tmp = *(TaskControlBlock **)(listOfTasksWaitingToRecv->data);
+            if (tmp->state == TaskState::TASK_BLOCKED_BY_SEMAPHORE)
+            {
+                tmp->state = TaskState::TASK_READY;
+            }
+            ListDeleteAtBeginning(listOfTasksWaitingToRecv);
+        }
+
+        _val = 1;
+    }
+
+    setInterruptMask(mask);
+
+    return result;
+}
+
+CRTOS::Result CRTOS::BinarySemaphore::wait(uint32_t ticks)
+{
+    CRTOS::Result result = CRTOS::Result::RESULT_SUCCESS;
+    uint32_t time = GetSystemTime();
+    uint32_t timeout = time + ticks;
+    bool isBlocked = false;
+
+    for (;;)
+    {
+        uint32_t mask = getInterruptMask();
+
+        time = GetSystemTime();
+
+        if (_val > 0u)
+        {
+            _val = 0u;
+            setInterruptMask(mask);
+            return result;
+        }
+        else
+        {
+            if (ticks == 0u)
+            {
+                setInterruptMask(mask);
+                result = CRTOS::Result::RESULT_SEMAPHORE_TIMEOUT;
+                return result;
+            }
+
+            if (isBlocked == false)
+            {
+                sCurrentTCB->timeout = timeout;
+                sCurrentTCB->state = TaskState::TASK_BLOCKED_BY_SEMAPHORE;
+                uint32_t *tmp = (uint32_t *)sCurrentTCB;
+                ListInsertAtEnd(listOfTasksWaitingToRecv, &tmp);
+                isBlocked = true;
+            }
+        }
+
+        setInterruptMask(mask);
+
+        if (time < timeout)
+        {
+            if (_val > 0u)
+            {
+                mask = getInterruptMask();
+                if (listOfTasksWaitingToRecv != nullptr)
                 {
-                    temp->data->state = TaskState::TASK_READY;
-                }
+                    TaskControlBlock *tmp = *(TaskControlBlock **)(listOfTasksWaitingToRecv->data);
+                    if (tmp->state == TaskState::TASK_BLOCKED_BY_SEMAPHORE)
+                    {
+                        tmp->state = TaskState::TASK_READY;
+                    }
+                    ListDeleteAtBeginning(listOfTasksWaitingToRecv);
+                }
+                setInterruptMask(mask);
+
+                if (isHigherPrioTaskPending() == true)
+                {
+                    *ICSR_REG = NVIC_PENDSV_BIT;
+
+                    __DSB();
+                    __ISB();
+                }
+            }
+        }
+        else
+        {
+            // Timeout occurred - remove ourselves from waiting list
+            mask = getInterruptMask();
+
+            // Find and remove current task from waiting list
+            Node<uint32_t *> *temp = listOfTasksWaitingToRecv;
+            if (temp != nullptr)
+            {
+                ListDeleteAtBeginning(listOfTasksWaitingToRecv);
+            }
+
+            sCurrentTCB->state = TaskState::TASK_READY;
+            setInterruptMask(mask);
+
+            result = CRTOS::Result::RESULT_SEMAPHORE_TIMEOUT;
+            return result;
+        }
+    }
+}
+
+void RestoreCtxOfTheFirstTask(void)
+{
+    sCurrentTCB->enterCycles = DWT->CYCCNT;
+    __asm volatile(
+        ".syntax unified                       \n"
+        // Read top of the stack
+        "ldr  r2, currentCtxTCB                \n"
+        "ldr  r1, [r2]                         \n"
+        "ldr  r0, [r1]                         \n"
+        // R1 = PSPLIM || R2 = EXC_RETURN
+        "ldm  r0!, {r1-r2}                     \n"
+        // Set current task PSPLIM
+        "msr  psplim, r1                       \n"
+        // Switch to PSP - thread mode
+        "movs r1, #2                           \n"
+        "msr  CONTROL, r1                      \n"
+        // Discard R4-R11
+        "ldm   r0!, {r4-r11}                   \n"
+        // Update current PSP
+        "msr  psp, r0                          \n"
+        "isb                                   \n"
+        "mov  r0, #0                           \n"
+        // Enable interrupts and exit
+        "msr  basepri, r0                      \n"
+        "bx   r2                               \n"
+        ".align 4                              \n"
+        "currentCtxTCB: .word sCurrentTCB      \n");
+}
+
+extern "C" void SVC_Handle_Subprocess(uint32_t *command)
+{
+    uint32_t command_id = (uint32_t)(((uint8_t *)command[6u])[-2u]);
+    uint32_t *callerStack = command;
+
+    switch (command_id)
+    {
+        case SVC_Commands::COMMAND_TASK_DELAY:
+            CRTOS::Task::Delay(callerStack[0u]);
+            break;
+        case SVC_Commands::COMMAND_START_SCHEDULER:
+            RestoreCtxOfTheFirstTask();
+            break;
+        default:
+            break;
+    }
+}
+
+void SVC_Handler(void)
+{
+    __asm volatile(
+        ".syntax unified                              \n"
+        "tst lr, #4                                   \n"
+        "ite eq                                       \n"
+        "mrseq r0, msp                                \n"
+        "mrsne r0, psp                                \n"
+        "ldr r1, SVC_ISR_ADDR                         \n"
+        "bx r1                                        \n"
+        ".align 4                                     \n"
+        "SVC_ISR_ADDR:                                \n"
+        "\t.word SVC_Handle_Subprocess                \n");
+}
+
+extern "C" void PendSV_Handler(void)
+{
+    __asm volatile(
+        ".syntax unified     \n"
+        // Load PSP to R0, PSPLIM to R2, LR to r3
+        "mrs r0, psp         \n"
+        "tst lr, #0x10       \n"
+        "it eq               \n"
+        "vstmdbeq r0!, {s16-s31} \n"
+        "mrs r2, psplim      \n"
+        "mov r3, lr          \n"
+        // Save r2-r11 under PSP location
+        "stmdb r0!, {r2-r11} \n"
+        // Save new PSP
+        "ldr r2, currentTCB  \n"
+        "ldr r1, [r2]        \n"
+        "str r0, [r1]        \n"
+        // Perform context switch
+        "mov r0, %0          \n"
+        "msr basepri, r0     \n"
+        "dsb                 \n"
+        "isb                 \n"
+        "bl switchCtx        \n"
+        "mov r0, #0          \n"
+        "msr basepri, r0     \n"
+        // Load PSP address of next task to R0
+        "ldr r2, currentTCB  \n"
+        "ldr r1, [r2]        \n"
+        "ldr r0, [r1]        \n"
+        // Restore context of next task
+        "ldmia r0!, {r2-r11} \n"
+        "tst r3, #0x10       \n"
+        "it eq               \n"
+        "vldmiaeq r0!, {s16-s31} \n"
+        // Restore PSPLIM and set new PSP
+        "msr psplim, r2      \n"
+        "msr psp, r0         \n"
+
+        "ldr r0, [r1, #20]   \n"
+        "ldr r1, =0xE000ED08 \n"
+        "str r0, [r1]        \n"
+        // Leave interrupt
+        "bx r3               \n"
+        ".align 4            \n"
+        "currentTCB: .word sCurrentTCB \n" ::"i"(MAX_SYSCALL_IRQ_PRIO));
+}
+
+void startFirstTask(void)
+{
+    __asm volatile(
+        ".syntax unified \n"
+        "cpsie i         \n"
+        "cpsie f         \n"
+        "dsb             \n"
+        "isb             \n"
+        "svc %0          \n"
+        "nop             \n"
+        ".align 4        \n" ::"i"(SVC_Commands::COMMAND_START_SCHEDULER) : "memory");
+}
+
+__attribute__((always_inline)) static inline void __ISB(void)
+{
+    __asm volatile("isb 0xF" ::: "memory");
+}
+
+__attribute__((always_inline)) static inline void __DSB(void)
+{
+    __asm volatile("dsb 0xF" ::: "memory");
+}
+
+extern "C" char *currentTaskName(void)
+{
+    return (char *)(&(sCurrentTCB->name[0]));
+}
+
+void updateExitCycles(void)
+{
+    sCurrentTCB->exitCycles = DWT->CYCCNT;
+}
+
+void updateEnterCycles(void)
+{
+    sCurrentTCB->enterCycles = DWT->CYCCNT;
+}
+
+extern "C" void switchCtx(void)
+{
+    Node<TaskControlBlock> *temp = readyTaskList;
+    Node<TaskControlBlock> *highestPriorityTask = nullptr;
+
+    TASK_SWITCHED_OUT();
+    updateExitCycles();
+
+    if (sCurrentTCB != nullptr)
+    {
+        uint32_t elapsedCycles;
+        if (sCurrentTCB->enterCycles > sCurrentTCB->exitCycles)
+        {
+            elapsedCycles = 0xFFFFFFFFu - sCurrentTCB->exitCycles + sCurrentTCB->enterCycles;
+        }
+        else
+        {
+            elapsedCycles = sCurrentTCB->exitCycles - sCurrentTCB->enterCycles;
+        }
+
+        sCurrentTCB->executionTime = elapsedCycles;
+    }
+
+    while (temp != nullptr)
+    {
+        switch (temp->data->state)
+        {
+            case TaskState::TASK_DELAYED:
+                if (tickCount >= temp->data->delayUpTo)
+                {
+                    temp->data->state = TaskState::TASK_READY;
+                }
+                break;
+            case TaskState::TASK_BLOCKED_BY_SEMAPHORE:
+                if (tickCount >= temp->data->timeout)
+                {
+                    temp->data->state = TaskState::TASK_READY;
+                }
                 break;
             case TaskState::TASK_BLOCKED_BY_QUEUE:
                 if (tickCount >= temp->data->timeout)
                 {
-                    temp->data->state = TaskState::TASK_READY;
+                    temp->data->state = TaskState::TASK_READY;
+                }
+                break;
+            case TaskState::TASK_BLOCKED_BY_CIRC_BUFFER:
+                if (tickCount >= temp->data->timeout)
+                {
+                    temp->data->state = TaskState::TASK_READY;
+                }
+                break;
+            case TaskState::TASK_RUNNING:
+                sCurrentTCB->state = TaskState::TASK_READY;
+                break;
+            default:
+                break;
+        }
+
+        if (temp->data->state == TaskState::TASK_READY)
+        {
+            if (highestPriorityTask == nullptr || temp->data->priority > highestPriorityTask->data->priority)
+            {
+                highestPriorityTask = temp;
+            }
+        }
+
+        temp = temp->next;
+    }
+
+    if (highestPriorityTask != nullptr)
+    {
+        sCurrentTCB = highestPriorityTask->data;
+        sCurrentTCB->state = TaskState::TASK_RUNNING;
+    }
+    else
+    {
+        sCurrentTCB = (TaskControlBlock *)(idleTaskHandle);
+        sCurrentTCB->state = TaskState::TASK_RUNNING;
+    }
+
+    updateEnterCycles();
+    TASK_SWITCHED_IN();
+}
+
+void SysTick_Handler(void)
+{
+    uint32_t mask = getInterruptMask();
+
+    tickCount++;
+
+    if (isPendingTask() == true)
+    {
+        CRTOS::Task::ExitCriticalSection();
+        *ICSR_REG = NVIC_PENDSV_BIT;
+        __ISB();
+    }
+
+    setInterruptMask(mask);
+}
+
+static void dummyTask(void)
+{
+    volatile uint32_t ulDummy = 0UL;
+    CRTOS::Task::Delete();
+
+    getInterruptMask();
+
+    while (ulDummy == 0)
+    {
+        ;
+    }
+}
+
+uint32_t *initStack(volatile uint32_t *stackTop, volatile uint32_t *stackEnd, TaskFunction code, void *args, uint32_t staticBase = 0xFEEDC0DEul)
+{
+    *(--stackTop) = (uint32_t)0x01000000lu; // xPSR
+    *(--stackTop) = (uint32_t)code;         // PC
+    *(--stackTop) = (uint32_t)dummyTask;    // LR
+    *(--stackTop) = (uint32_t)0xFEEDC0DEul; // R12
+    *(--stackTop) = (uint32_t)0xFEEDC0DEul; // R3
+    *(--stackTop) = (uint32_t)0xFEEDC0DEul; // R2
+    *(--stackTop) = (uint32_t)0xFEEDC0DEul; // R1
+    *(--stackTop) = (uint32_t)args;         // R0
+    *(--stackTop) = (uint32_t)0xFEEDC0DEul; // R11
+    *(--stackTop) = (uint32_t)0xFEEDC0DEul; // R10
+    *(--stackTop) = staticBase;             // R09
+    *(--stackTop) = (uint32_t)0xFEEDC0DEul; // R08
+    *(--stackTop) = (uint32_t)0xFEEDC0DEul; // R07
+    *(--stackTop) = (uint32_t)0xFEEDC0DEul; // R06
+    *(--stackTop) = (uint32_t)0xFEEDC0DEul; // R05
+    *(--stackTop) = (uint32_t)0xFEEDC0DEul; // R04
+    *(--stackTop) = (uint32_t)0xFFFFFFFDul; // EXC_RETURN
+    *(--stackTop) = (uint32_t)stackEnd;     // PSPLIM
+
+    return ((uint32_t *)stackTop);
+}
+
+void TimerISR(void *)
+{
+    while (1)
+    {
+        Node<CRTOS::Timer::SoftwareTimer> *tmp = sTimerList;
+        while (tmp != nullptr)
+        {
+            if (tmp->data->isActive)
+            {
+                tmp->data->elapsedTicks++;
+                if (tmp->data->elapsedTicks >= tmp->data->timeoutTicks)
+                {
+                    tmp->data->callback(tmp->data->callbackArgs);
+                    if (tmp->data->autoReload == true)
+                    {
+                        tmp->data->elapsedTicks = 0u;
+                    }
+                    else
+                    {
+                        tmp->data->elapsedTicks = 0u;
+                        tmp->data->isActive = false;
+                    }
+                }
+            }
+            tmp = tmp->next;
+        }
+        CRTOS::Task::Delay(1u);
+    }
+}
+
+void idleTask(void *)
+{
+    for (;;)
+    {
+        if (mem.needsCompaction() == true)
+        {
+            // One block per pass keeps the masked section short
+            uint32_t mask = getInterruptMask();
+            mem.compact(1u);
+            setInterruptMask(mask);
+        }
+
+        if (isPendingTask() == true)
+        {
+            *ICSR_REG = NVIC_PENDSV_BIT;
+            __ISB();
+        }
+    }
+}
+
+CRTOS::Result CRTOS::Scheduler::Start(void)
+{
+    CRTOS::Result result = CRTOS::Result::RESULT_SUCCESS;
+    void *pool = nullptr;
+    uint32_t poolSize = 0u;
+
+    do
+    {
+        mem.getMemoryPool(&pool, poolSize);
+
+        if ((pool == nullptr) || (poolSize == 0u))
+        {
+            result = CRTOS::Result::RESULT_MEMORY_NOT_INITIALIZED;
+            return result;
+        }
+
+        *NVIC_SHPR3_REG |= NVIC_PENDSV_PRIO;
+        *NVIC_SHPR3_REG |= NVIC_SYSTICK_PRIO;
+
+        getInterruptMask();
+
+        SysTick->CTRL = 0ul;
+        SysTick->VAL = 0ul;
+
+        result = createTask(TimerISR, "TimerSVC", 512, nullptr, MAX_TASK_PRIORITY - 1u, nullptr, kernelHeap());
+        if (result != CRTOS::Result::RESULT_SUCCESS)
+        {
+            continue;
+        }
+
+        result = createTask(idleTask, "IDLE", 128, nullptr, 0u, &idleTaskHandle, kernelHeap());
+        if (result != CRTOS::Result::RESULT_SUCCESS)
+        {
+            continue;
+        }
+
+        sCurrentTCB = readyTaskList->data;
+
+        Node<TaskControlBlock> *temp = readyTaskList;
+        while (temp != nullptr)
+        {
+            temp->data->executionTime = 0;
+            temp->data->enterCycles = 0;
+            temp->data->exitCycles = 0;
+            temp = temp->next;
+        }
+
+        SysTick->LOAD = (sCoreClock / sTickRate) - 1ul;
+        SysTick->VAL = 0u;
+        SysTick->CTRL = SysTick_CTRL_CLKSOURCE | SysTick_CTRL_TICKINT | SysTick_CTRL_ENABLE;
+
+        startFirstTask();
+    } while (0);
+
+    return result;
+}
+
+void CRTOS::Task::Yield(void)
+{
+    if (isHigherPrioTaskPending() == true)
+    {
+        *ICSR_REG = NVIC_PENDSV_BIT;
+        __DSB();
+        __ISB();
+    }
+}
+
+static CRTOS::Result createTask(TaskFunction function, const char *const name, uint32_t stackDepth, void *args, uint32_t prio, CRTOS::Task::TaskHandle *handle, HeapAllocator &stackHeap)
+{
+    CRTOS::Result result = CRTOS::Result::RESULT_SUCCESS;
+    uint32_t prevMask = getInterruptMask();
+    void *pool = nullptr;
+    uint32_t poolSize = 0u;
+
+    __DSB();
+    __ISB();
+
+    mem.getMemoryPool(&pool, poolSize);
+
+    if ((pool == nullptr) || (poolSize == 0u))
+    {
+        result = CRTOS::Result::RESULT_MEMORY_NOT_INITIALIZED;
+        return result;
+    }
+
+    do
+    {
+        TaskControlBlock *tmpTCB = reinterpret_cast<TaskControlBlock *>(kernelHeap().allocate(sizeof(TaskControlBlock)));
+        if (tmpTCB == nullptr)
+        {
+            result = CRTOS::Result::RESULT_NO_MEMORY;
+            continue;
+        }
+
+        uint32_t *tmpStack = reinterpret_cast<uint32_t *>(stackHeap.allocate(stackDepth * sizeof(uint32_t)));
+        if (tmpStack == nullptr)
+        {
+            kernelDeallocate(tmpTCB);
+            result = CRTOS::Result::RESULT_NO_MEMORY;
+            continue;
+        }
+
+        memset32_optimized(tmpStack, STACK_PAINT, stackDepth);
+        memset_optimized(&(tmpTCB->name[0u]), 0u, 20u);
+
+        tmpTCB->stack = &tmpStack[0u];
+        tmpTCB->stackSize = stackDepth;
+        tmpTCB->function = function;
+        tmpTCB->function_args = args;
+        tmpTCB->enterCycles = 0u;
+        tmpTCB->exitCycles = 0u;
+        tmpTCB->vtor_addr = 0u;
+
+        // Tasks started by a module task belong to that module
+        tmpTCB->module = (sCurrentTCB != nullptr) ? sCurrentTCB->module : nullptr;
+        if (tmpTCB->module != nullptr)
+        {
+            tmpTCB->module->tasks++;
+        }
+
+        if (prio >= MAX_TASK_PRIORITY)
+        {
+            tmpTCB->priority = MAX_TASK_PRIORITY - 1u;
+        }
+        else
+        {
+            tmpTCB->priority = prio;
+        }
+
+        // Ustawienie stanu zadania
+        tmpTCB->state = TaskState::TASK_READY;
+
+        uint32_t nameLength = strlen_optimized(name) + 1u;
+        memcpy_optimized(&tmpTCB->name[0], (char *)&name[0u], nameLength < 20u ? nameLength : 20u);
+
+        volatile uint32_t *stackTop = &(tmpTCB->stack[stackDepth - 1u]);
+        stackTop = (uint32_t *)(((uint32_t)stackTop) & ~7u);
+
+        tmpTCB->stackTop = initStack(stackTop, tmpTCB->stack, function, args);
+
+        ListInsertAtEnd(readyTaskList, tmpTCB);
+
+        if (handle != nullptr)
+        {
+            *handle = (CRTOS::Task::TaskHandle)tmpTCB;
+        }
+    } while (0);
+
+    setInterruptMask(prevMask);
+
+    return result;
+}
+
+CRTOS::Result CRTOS::Task::Create(TaskFunction function, const char *const name, uint32_t stackDepth, void *args, uint32_t prio, TaskHandle *handle)
+{
+    return createTask(function, name, stackDepth, args, prio, handle, mem);
+}
+
+// Module image held in memory, reads past its size fail like a short file
+struct ModuleMemory
+{
+    const uint8_t *base;
+    uint32_t size;
+};
+
+// Size of an image passed without one, only the address space bounds it
+static constexpr uint32_t MODULE_SIZE_UNKNOWN = 0xFFFFFFFFu;
+
+static int moduleMemoryReader(void *context, uint32_t offset, void *dst, uint32_t length)
+{
+    const ModuleMemory *image = (const ModuleMemory *)context;
+    if (offset > image->size || image->size - offset < length)
+    {
+        return -1;
+    }
+
+    memcpy_optimized(dst, image->base + offset, length);
+    return 0;
+}
+
+static CRTOS::Result elfStatusToResult(int status)
+{
+    switch (status)
+    {
+        case ELF_OK:
+            return CRTOS::Result::RESULT_SUCCESS;
+        case ELF_ERROR_NO_MEMORY:
+            return CRTOS::Result::RESULT_NO_MEMORY;
+        case ELF_ERROR_READ:
+            return CRTOS::Result::RESULT_MODULE_READ_ERROR;
+        default:
+            return CRTOS::Result::RESULT_MODULE_INVALID;
+    }
+}
+
+extern "C" void crtos_delay(uint32_t ticks)
+{
+    CRTOS::Task::Delay(ticks);
+}
+
+extern "C" void crtos_yield(void)
+{
+    CRTOS::Task::Yield();
+}
+
+extern "C" int crtos_task_create(void (*function)(void *), const char *name, uint32_t stackDepth, void *args, uint32_t prio, void **handle)
+{
+    return (int)CRTOS::Task::Create(function, name, stackDepth, args, prio, handle);
+}
+
+extern "C" int crtos_task_delete(void **handle)
+{
+    return (int)((handle == nullptr) ? CRTOS::Task::Delete() : CRTOS::Task::Delete(handle));
+}
+
+extern "C" const char *crtos_task_name(void)
+{
+    return CRTOS::Task::GetCurrentTaskName();
+}
+
+extern "C" uint32_t crtos_enter_critical(void)
+{
+    return CRTOS::Task::EnterCriticalSection();
+}
+
+extern "C" void crtos_exit_critical(uint32_t mask)
+{
+    CRTOS::Task::ExitCriticalSection(mask);
+}
+
+extern "C" void *crtos_malloc(uint32_t size)
+{
+    uint32_t prevMask = getInterruptMask();
+    void *ptr = mem.allocate(size);
+    setInterruptMask(prevMask);
+
+    return ptr;
+}
+
+extern "C" void crtos_free(void *ptr)
+{
+    uint32_t prevMask = getInterruptMask();
+    mem.deallocate(ptr);
+    setInterruptMask(prevMask);
+}
+
+extern "C" uint32_t crtos_free_memory(void)
+{
+    return CRTOS::Config::GetFreeMemory();
+}
+
+extern "C" void crtos_swap_point(const void *state, uint32_t size)
+{
+    uint32_t mask = getInterruptMask();
+    TaskControlBlock *self = (TaskControlBlock *)sCurrentTCB;
+    ModuleControlBlock *module = self->module;
+    ModuleSwap *swap = (module != nullptr && module->task == self) ? module->swap : nullptr;
+
+    if (swap == nullptr || swap->claimed)
+    {
+        setInterruptMask(mask);
+        return;
+    }
+
+    swap->claimed = true;
+    swap->state = (state != nullptr && size != 0u) ? (uint8_t *)mem.allocate(size) : nullptr;
+    setInterruptMask(mask);
+
+    if (state != nullptr && size != 0u && swap->state == nullptr)
+    {
+        // Keep serving, Replace gives up. swap must not be touched after the signal.
+        swap->result = CRTOS::Result::RESULT_NO_MEMORY;
+        swap->parked.signal();
+        return;
+    }
+
+    if (swap->state != nullptr)
+    {
+        memcpy_optimized(swap->state, (void *)state, size);
+        swap->stateSize = size;
+    }
+    swap->result = CRTOS::Result::RESULT_SUCCESS;
+
+    // Park for good, Replace unloads this module once the new instance is running
+    for (;;)
+    {
+        mask = getInterruptMask();
+        self->state = TaskState::TASK_PAUSED;
+        if (swap != nullptr)
+        {
+            swap->parked.signal();
+            swap = nullptr;
+        }
+        *ICSR_REG = NVIC_PENDSV_BIT;
+        setInterruptMask(mask);
+    }
+}
+
+extern "C" uint32_t crtos_swap_state(void *dst, uint32_t size)
+{
+    uint32_t mask = getInterruptMask();
+    ModuleControlBlock *module = (sCurrentTCB != nullptr) ? sCurrentTCB->module : nullptr;
+
+    if (module == nullptr || module->state == nullptr)
+    {
+        setInterruptMask(mask);
+        return 0u;
+    }
+
+    uint32_t length = module->stateSize;
+    if (dst == nullptr)
+    {
+        setInterruptMask(mask);
+        return length;
+    }
+
+    // Consumed by the first call that takes it
+    uint8_t *state = module->state;
+    module->state = nullptr;
+    module->stateSize = 0u;
+    setInterruptMask(mask);
+
+    length = (size < length) ? size : length;
+    memcpy_optimized(dst, state, length);
+
+    mask = getInterruptMask();
+    mem.deallocate(state);
+    setInterruptMask(mask);
+
+    return length;
+}
+
+// Sorted by name for binary search
+static const CRTOS::Task::LPC55S69_Features::KernelExport sKernelExports[] = {
+    {"crtos_delay", (uint32_t)&crtos_delay},
+    {"crtos_enter_critical", (uint32_t)&crtos_enter_critical},
+    {"crtos_exit_critical", (uint32_t)&crtos_exit_critical},
+    {"crtos_free", (uint32_t)&crtos_free},
+    {"crtos_free_memory", (uint32_t)&crtos_free_memory},
+    {"crtos_malloc", (uint32_t)&crtos_malloc},
+    {"crtos_swap_point", (uint32_t)&crtos_swap_point},
+    {"crtos_swap_state", (uint32_t)&crtos_swap_state},
+    {"crtos_task_create", (uint32_t)&crtos_task_create},
+    {"crtos_task_delete", (uint32_t)&crtos_task_delete},
+    {"crtos_task_name", (uint32_t)&crtos_task_name},
+    {"crtos_yield", (uint32_t)&crtos_yield},
+};
+
+static constexpr uint32_t sKernelExportCount = sizeof(sKernelExports) / sizeof(sKernelExports[0u]);
+
+const CRTOS::Task::LPC55S69_Features::KernelExport *CRTOS::Task::LPC55S69_Features::GetKernelExports(uint32_t &count)
+{
+    count = sKernelExportCount;
+    return &sKernelExports[0u];
+}
+
+CRTOS::Result CRTOS::Task::LPC55S69_Features::FindKernelExport(const char *name, uint32_t &address)
+{
+    if (name == nullptr)
+    {
+        return CRTOS::Result::RESULT_BAD_PARAMETER;
+    }
+
+    uint32_t low = 0u;
+    uint32_t high = sKernelExportCount;
+
+    while (low < high)
+    {
+        uint32_t middle = (low + high) / 2u;
+        int32_t order = strcmp_optimized(name, sKernelExports[middle].name);
+
+        if (order == 0)
+        {
+            address = sKernelExports[middle].address;
+            return CRTOS::Result::RESULT_SUCCESS;
+        }
+
+        if (order < 0)
+        {
+            high = middle;
+        }
+        else
+        {
+            low = middle + 1u;
+        }
+    }
+
+    return CRTOS::Result::RESULT_NOT_SUPPORTED;
+}
+
+static bool resolveKernelSymbol(const char *name, uint32_t &address)
+{
+    return CRTOS::Task::LPC55S69_Features::FindKernelExport(name, address) == CRTOS::Result::RESULT_SUCCESS;
+}
+
+// Writes the address of every imported kernel symbol into its slot. The image is
+// nullptr when it cannot be written, its imports must then live in .data.
+static CRTOS::Result bindModuleImports(CRTOS::Task::LPC55S69_Features::ModuleReader reader, void *context, const ModuleDescriptorBin &md,
+                                       uint8_t *image, uint32_t imageSize, uint8_t *ram, uint32_t dataSize)
+{
+    for (uint32_t i = 0u; i < md.import_count; i++)
+    {
+        ModuleImportBin import;
+        if (reader(context, md.import_offset + i * sizeof(ModuleImportBin), &import, sizeof(ModuleImportBin)) != 0)
+        {
+            return CRTOS::Result::RESULT_MODULE_READ_ERROR;
+        }
+        import.name[sizeof(import.name) - 1u] = '\0';
+
+        uint32_t address = 0u;
+        if (CRTOS::Task::LPC55S69_Features::FindKernelExport(import.name, address) != CRTOS::Result::RESULT_SUCCESS)
+        {
+            return CRTOS::Result::RESULT_MODULE_INVALID;
+        }
+
+        bool inRam = (import.slot & MODULE_IMPORT_RAM) != 0u;
+        uint32_t offset = import.slot & ~MODULE_IMPORT_RAM;
+        uint8_t *base = inRam ? ram : image;
+        uint32_t limit = inRam ? dataSize : imageSize;
+
+        if (base == nullptr || offset > limit || (limit - offset) < sizeof(uint32_t))
+        {
+            return CRTOS::Result::RESULT_MODULE_INVALID;
+        }
+
+        memcpy_optimized(base + offset, &address, sizeof(uint32_t));
+    }
+
+    return CRTOS::Result::RESULT_SUCCESS;
+}
+
+// How relocations placed in the code image are handled
+enum class ImagePatch : uint8_t
+{
+    APPLY,  // Image was just read into RAM
+    SKIP,   // Cached image, patched by the instance that loaded it
+    REJECT  // Image executes in place from flash
+};
+
+// Adds the load address of the target region to every relocated word. The packer
+// emits entries sorted by place so the patching walks memory linearly.
+static CRTOS::Result applyModuleRelocations(CRTOS::Task::LPC55S69_Features::ModuleReader reader, void *context, const ModuleDescriptorBin &md,
+                                            uint8_t *image, uint32_t imageSize, ImagePatch imagePatch, uint8_t *ram, uint32_t dataSize)
+{
+    static constexpr uint32_t BATCH = 16u;
+
+    uint32_t entries[BATCH];
+    bool staticBase = (md.flags & MODULE_FLAG_STATIC_BASE) != 0u;
+
+    for (uint32_t i = 0u; i < md.reloc_count; i++)
+    {
+        if ((i % BATCH) == 0u)
+        {
+            uint32_t batch = ((md.reloc_count - i) < BATCH) ? (md.reloc_count - i) : BATCH;
+            if (reader(context, md.reloc_offset + i * sizeof(uint32_t), &entries[0u], batch * sizeof(uint32_t)) != 0)
+            {
+                return CRTOS::Result::RESULT_MODULE_READ_ERROR;
+            }
+        }
+
+        uint32_t entry = entries[i % BATCH];
+        uint32_t offset = MODULE_RELOC_OFFSET(entry);
+        uint32_t base = ((entry & MODULE_RELOC_TARGET_RAM) != 0u) ? (uint32_t)ram : (uint32_t)image;
+        uint32_t *place = nullptr;
+
+        if ((entry & MODULE_RELOC_PLACE_RAM) != 0u)
+        {
+            if (offset > dataSize || (dataSize - offset) < sizeof(uint32_t))
+            {
+                return CRTOS::Result::RESULT_MODULE_INVALID;
+            }
+            place = (uint32_t *)(ram + offset);
+        }
+        else
+        {
+            // A shared or flash image cannot hold addresses of one instance
+            if (imagePatch == ImagePatch::REJECT || (staticBase && (entry & MODULE_RELOC_TARGET_RAM) != 0u))
+            {
+                return CRTOS::Result::RESULT_MODULE_INVALID;
+            }
+            if (imagePatch == ImagePatch::SKIP)
+            {
+                continue;
+            }
+            if (offset > imageSize || (imageSize - offset) < sizeof(uint32_t))
+            {
+                return CRTOS::Result::RESULT_MODULE_INVALID;
+            }
+            place = (uint32_t *)(image + offset);
+        }
+
+        *place += base;
+    }
+
+    return CRTOS::Result::RESULT_SUCCESS;
+}
+
+// Checks image_crc of a module image of md.image_size bytes, the CRC covers everything
+// after the descriptor
+static CRTOS::Result verifyModuleImage(const uint8_t *image, const ModuleDescriptorBin &md)
+{
+    CRTOS::Result result = ModuleValidation::CheckDescriptor(md);
+    if (result != CRTOS::Result::RESULT_SUCCESS || (md.flags & MODULE_FLAG_IMAGE_CRC) == 0u)
+    {
+        return result;
+    }
+
+    uint32_t crc = 0u;
+    if (CRTOS::CRC32::Calculate(image + MODULE_HEADER_SIZE, md.image_size - MODULE_HEADER_SIZE, crc) != CRTOS::Result::RESULT_SUCCESS)
+    {
+        return CRTOS::Result::RESULT_NO_MEMORY;
+    }
+
+    return (crc == md.image_crc) ? CRTOS::Result::RESULT_SUCCESS : CRTOS::Result::RESULT_MODULE_INVALID;
+}
+
+// Copies the image and checks image_crc in the same pass over the data. A descriptor
+// has passed ModuleValidation::CheckDescriptor and imageSize is its image_size.
+static CRTOS::Result copyModuleImage(CRTOS::Task::LPC55S69_Features::ModuleReader reader, void *context, const ModuleDescriptorBin &md,
+                                     uint8_t *image, uint32_t imageSize)
+{
+    static constexpr uint32_t CHUNK_SIZE = 1024u;
+
+    if (md.magic != MODULE_MAGIC || (md.flags & MODULE_FLAG_IMAGE_CRC) == 0u)
+    {
+        return (reader(context, 0u, image, imageSize) == 0) ? CRTOS::Result::RESULT_SUCCESS : CRTOS::Result::RESULT_MODULE_READ_ERROR;
+    }
+
+    if (reader(context, 0u, image, MODULE_HEADER_SIZE) != 0)
+    {
+        return CRTOS::Result::RESULT_MODULE_READ_ERROR;
+    }
+
+    CRTOS::Crc32Context crc;
+
+    if (reader == moduleMemoryReader)
+    {
+        const ModuleMemory *source = (const ModuleMemory *)context;
+        if (source->size < imageSize)
+        {
+            return CRTOS::Result::RESULT_MODULE_READ_ERROR;
+        }
+
+        // Source is addressable, every word is checksummed while it is in a register
+        crc.CopyAndUpdate(image + MODULE_HEADER_SIZE, source->base + MODULE_HEADER_SIZE, imageSize - MODULE_HEADER_SIZE);
+    }
+    else
+    {
+        // Each chunk is checksummed right after the reader stored it
+        for (uint32_t offset = MODULE_HEADER_SIZE; offset < imageSize;)
+        {
+            uint32_t length = ((imageSize - offset) < CHUNK_SIZE) ? (imageSize - offset) : CHUNK_SIZE;
+            if (reader(context, offset, image + offset, length) != 0)
+            {
+                return CRTOS::Result::RESULT_MODULE_READ_ERROR;
+            }
+
+            crc.Update(image + offset, length);
+            offset += length;
+        }
+    }
+
+    return (crc.Finalize() == md.image_crc) ? CRTOS::Result::RESULT_SUCCESS : CRTOS::Result::RESULT_MODULE_INVALID;
+}
+
+// Reads the image into its final place and verifies it, a compressed image is inflated
+// on the fly. Takes the same descriptor and size as copyModuleImage.
+static CRTOS::Result readModuleImage(CRTOS::Task::LPC55S69_Features::ModuleReader reader, void *context, const ModuleDescriptorBin &md,
+                                     uint8_t *image, uint32_t imageSize)
+{
+
+    if (md.magic != MODULE_MAGIC || (md.flags & MODULE_FLAG_COMPRESSED) == 0u)
+    {
+        return copyModuleImage(reader, context, md, image, imageSize);
+    }
+
+    // Headers are stored as they are, the block starts right after the descriptor
+    if (reader(context, 0u, image, MODULE_HEADER_SIZE) != 0)
+    {
+        return CRTOS::Result::RESULT_MODULE_READ_ERROR;
+    }
+
+    uint32_t produced = 0u;
+    int status = Lz4::Decode(reader, context, MODULE_HEADER_SIZE, md.packed_size, image + MODULE_HEADER_SIZE, imageSize - MODULE_HEADER_SIZE, produced);
+    if (status == LZ4_ERROR_READ)
+    {
+        return CRTOS::Result::RESULT_MODULE_READ_ERROR;
+    }
+
+    if (status != LZ4_OK || produced != (imageSize - MODULE_HEADER_SIZE))
+    {
+        return CRTOS::Result::RESULT_MODULE_INVALID;
+    }
+
+    return verifyModuleImage(image, md);
+}
+
+static ModuleImage *sModuleImages = nullptr;
+
+// Live modules. A ModuleHandle carries the ID of its module rather than its address,
+// so a handle kept after the module freed itself with its last task is recognised.
+static ModuleControlBlock *sModules = nullptr;
+static uint32_t sModuleId = 0u;
+
+// Module a handle refers to, nullptr once it is gone. Called under the mask.
+static ModuleControlBlock *findModule(CRTOS::Task::LPC55S69_Features::Module::ModuleHandle handle)
+{
+    uint32_t id = (uint32_t)(uintptr_t)handle;
+    ModuleControlBlock *module = sModules;
+    while (module != nullptr && module->id != id)
+    {
+        module = module->next;
+    }
+
+    return module;
+}
+
+static CRTOS::Task::LPC55S69_Features::Module::ModuleHandle moduleHandle(const ModuleControlBlock *module)
+{
+    return (CRTOS::Task::LPC55S69_Features::Module::ModuleHandle)(uintptr_t)module->id;
+}
+
+// CRC32 of the module image, read in small chunks so a cache hit costs no heap
+static CRTOS::Result moduleImageCrc(CRTOS::Task::LPC55S69_Features::ModuleReader reader, void *context, uint32_t size, uint32_t &crc)
+{
+    uint8_t chunk[64u];
+    uint32_t offset = 0u;
+    CRTOS::Crc32Context stream;
+
+    while (offset < size)
+    {
+        uint32_t length = ((size - offset) < sizeof(chunk)) ? (size - offset) : sizeof(chunk);
+        if (reader(context, offset, &chunk[0u], length) != 0)
+        {
+            return CRTOS::Result::RESULT_MODULE_READ_ERROR;
+        }
+
+        stream.Update(&chunk[0u], length);
+        offset += length;
+    }
+
+    crc = stream.Finalize();
+    return CRTOS::Result::RESULT_SUCCESS;
+}
+
+static ModuleImage *findModuleImage(const ModuleDescriptorBin &md, uint32_t size, uint32_t crc)
+{
+    for (ModuleImage *image = sModuleImages; image != nullptr; image = image->next)
+    {
+        if ((image->crc == crc) && (image->size == size) &&
+            (image->semver_major == md.semver_major) && (image->semver_minor == md.semver_minor) &&
+            (image->semver_patch == md.semver_patch) && (memcmp_optimized(image->name, md.name, sizeof(image->name)) == 0))
+        {
+            image->refs++;
+            return image;
+        }
+    }
+
+    return nullptr;
+}
+
+static ModuleImage *addModuleImage(const ModuleDescriptorBin &md, uint32_t size, uint32_t crc, uint8_t *code)
+{
+    ModuleImage *image = reinterpret_cast<ModuleImage *>(kernelHeap().allocate(sizeof(ModuleImage)));
+    if (image == nullptr)
+    {
+        return nullptr;
+    }
+
+    image->code = code;
+    image->size = size;
+    image->crc = crc;
+    image->refs = 1u;
+    memcpy_optimized(image->name, (void *)md.name, sizeof(image->name));
+    image->semver_major = md.semver_major;
+    image->semver_minor = md.semver_minor;
+    image->semver_patch = md.semver_patch;
+    image->next = sModuleImages;
+    sModuleImages = image;
+
+    return image;
+}
+
+// Drops one reference, the code is freed with the last task using it
+static void releaseModuleImage(ModuleImage *image)
+{
+    if (image == nullptr || --image->refs != 0u)
+    {
+        return;
+    }
+
+    ModuleImage **link = &sModuleImages;
+    while (*link != image)
+    {
+        link = &(*link)->next;
+    }
+    *link = image->next;
+
+    mem.deallocate(image->code);
+    kernelDeallocate(image);
+}
+
+// ElfFile allocator, called while the module is read with interrupts enabled
+static void *moduleAllocate(uint32_t size)
+{
+    uint32_t mask = getInterruptMask();
+    void *ptr = mem.allocate(size);
+    setInterruptMask(mask);
+
+    return ptr;
+}
+
+static void moduleDeallocate(void *ptr)
+{
+    uint32_t mask = getInterruptMask();
+    mem.deallocate(ptr);
+    setInterruptMask(mask);
+}
+
+// Frees the code image and the RAM region of a module and the module itself
+static void releaseModule(ModuleControlBlock *module)
+{
+    if (module->shared != nullptr)
+    {
+        releaseModuleImage(module->shared);
+    }
+    else
+    {
+        mem.deallocate(module->image);
+    }
+
+    mem.deallocate(module->ram);
+    mem.deallocate(module->state);
+
+    ModuleControlBlock **link = &sModules;
+    while (*link != module)
+    {
+        link = &(*link)->next;
+    }
+    *link = module->next;
+
+    kernelDeallocate(module);
+}
+
+// Allocates the TCB of the main task of a module together with the module itself
+static TaskControlBlock *allocateModuleTask(void *args)
+{
+    TaskControlBlock *tcb = reinterpret_cast<TaskControlBlock *>(kernelHeap().allocate(sizeof(TaskControlBlock)));
+    ModuleControlBlock *module = reinterpret_cast<ModuleControlBlock *>(kernelHeap().allocate(sizeof(ModuleControlBlock)));
+    if (tcb == nullptr || module == nullptr)
+    {
+        kernelDeallocate(tcb);
+        kernelDeallocate(module);
+        return nullptr;
+    }
+
+    module->image = nullptr;
+    module->shared = nullptr;
+    module->ram = nullptr;
+    module->task = tcb;
+    module->tasks = 1u;
+    module->swap = nullptr;
+    module->state = nullptr;
+    module->stateSize = 0u;
+
+    // IDs wrap after 2^32 loads, skip the ones still in use
+    do
+    {
+        sModuleId = (sModuleId == 0xFFFFFFFFu) ? 1u : (sModuleId + 1u);
+    } while (findModule((CRTOS::Task::LPC55S69_Features::Module::ModuleHandle)(uintptr_t)sModuleId) != nullptr);
+    module->id = sModuleId;
+    module->next = sModules;
+    sModules = module;
+
+    memset_optimized(&(tcb->name[0u]), 0u, 20u);
+    tcb->stackSize = 0u;
+    tcb->function_args = args;
+    tcb->enterCycles = 0u;
+    tcb->exitCycles = 0u;
+    tcb->module = module;
+
+    return tcb;
+}
+
+// Undoes a module load that failed before its task was started
+static void freeModuleTask(TaskControlBlock *tcb)
+{
+    releaseModule(tcb->module);
+    kernelDeallocate(tcb);
+}
+
+// Frees a task already removed from the ready list. A module is released
+// together with its last task, the main task stack is part of the module RAM.
+static void releaseTask(TaskControlBlock *tcb)
+{
+    ModuleControlBlock *module = tcb->module;
+
+    if (module == nullptr || module->task != tcb)
+    {
+        kernelDeallocate((void *)tcb->stack);
+    }
+    else
+    {
+        module->task = nullptr;
+    }
+
+    if (module != nullptr && --module->tasks == 0u)
+    {
+        releaseModule(module);
+    }
+
+    kernelDeallocate(tcb);
+}
+
+// Loads an ELF module through reader. With a fileSize other than 0 no header may
+// point past it, see ElfFile::setFileSize. The module is returned in loaded from the
+// critical section that publishes its task, before the task can run and exit.
+static CRTOS::Result createElfTask(CRTOS::Task::LPC55S69_Features::ModuleReader reader, void *context, uint32_t fileSize,
+                                   const char *const name, void *args, uint32_t prio, CRTOS::Task::TaskHandle *handle,
+                                   CRTOS::Task::LPC55S69_Features::Module::ModuleHandle *loaded)
+{
+    if (reader == nullptr || name == nullptr)
+    {
+        return CRTOS::Result::RESULT_BAD_PARAMETER;
+    }
+
+    CRTOS::Result result = CRTOS::Result::RESULT_SUCCESS;
+    void *pool = nullptr;
+    uint32_t poolSize = 0u;
+
+    uint32_t prevMask = getInterruptMask();
+    mem.getMemoryPool(&pool, poolSize);
+    setInterruptMask(prevMask);
+
+    if ((pool == nullptr) || (poolSize == 0u))
+    {
+        return CRTOS::Result::RESULT_MEMORY_NOT_INITIALIZED;
+    }
+
+    ElfFile elf;
+    elf.setAllocator(moduleAllocate, moduleDeallocate);
+    elf.setResolver(resolveKernelSymbol);
+    elf.setFileSize(fileSize);
+
+    // Like prepareBinModule, BASEPRI is raised only around heap operations and the ready
+    // list. The reader runs with interrupts enabled, it may wait for flash or a file system.
+    do
+    {
+        prevMask = getInterruptMask();
+        TaskControlBlock *tmpTCB = allocateModuleTask(args);
+        setInterruptMask(prevMask);
+        if (tmpTCB == nullptr)
+        {
+            result = CRTOS::Result::RESULT_NO_MEMORY;
+            continue;
+        }
+
+        int status = elf.parse(reader, context, (uint32_t **)(&(tmpTCB->stack)), &(tmpTCB->stackSize), &(tmpTCB->vtor_addr));
+        if (status != ELF_OK)
+        {
+            prevMask = getInterruptMask();
+            freeModuleTask(tmpTCB);
+            setInterruptMask(prevMask);
+            result = elfStatusToResult(status);
+            continue;
+        }
+        tmpTCB->module->image = elf.getImage();
+        tmpTCB->module->ram = elf.getRam();
+        tmpTCB->vtor_addr = 0u;
+
+        if (prio >= MAX_TASK_PRIORITY)
+        {
+            tmpTCB->priority = MAX_TASK_PRIORITY - 1u;
+        }
+        else
+        {
+            tmpTCB->priority = prio;
+        }
+
+        tmpTCB->function = elf.entry_point;
+
+        // Ustawienie stanu zadania
+        tmpTCB->state = TaskState::TASK_READY;
+
+        uint32_t nameLength = strlen_optimized(name) + 1u;
+        memcpy_optimized(&tmpTCB->name[0], (char *)&name[0u], nameLength < 20u ? nameLength : 20u);
+
+        volatile uint32_t *stackTop = &(tmpTCB->stack[tmpTCB->stackSize - 1u]);
+        stackTop = (uint32_t *)(((uint32_t)stackTop) & ~7u);
+
+        tmpTCB->stackTop = initStack(stackTop, tmpTCB->stack, elf.entry_point, args);
+
+        // The code was written as data, complete it before the task can run
+        __DSB();
+        __ISB();
+
+        prevMask = getInterruptMask();
+        ListInsertAtEnd(readyTaskList, tmpTCB);
+        if (handle != nullptr)
+        {
+            *handle = (CRTOS::Task::TaskHandle)tmpTCB;
+        }
+        if (loaded != nullptr)
+        {
+            *loaded = moduleHandle(tmpTCB->module);
+        }
+        setInterruptMask(prevMask);
+    } while (0);
+
+    return result;
+}
+
+CRTOS::Result CRTOS::Task::LPC55S69_Features::CreateTaskForExecutable(const uint8_t *elf_file, const char *const name, void *args, uint32_t prio, TaskHandle *handle)
+{
+    if (elf_file == nullptr)
+    {
+        return CRTOS::Result::RESULT_BAD_PARAMETER;
+    }
+
+    ModuleMemory image = { elf_file, MODULE_SIZE_UNKNOWN };
+    return createElfTask(moduleMemoryReader, &image, 0u, name, args, prio, handle, nullptr);
+}
+
+CRTOS::Result CRTOS::Task::LPC55S69_Features::CreateTaskForExecutable(const uint8_t *elf_file, uint32_t size, const char *const name, void *args, uint32_t prio, TaskHandle *handle)
+{
+    if (elf_file == nullptr || size == 0u)
+    {
+        return CRTOS::Result::RESULT_BAD_PARAMETER;
+    }
+
+    ModuleMemory image = { elf_file, size };
+    return createElfTask(moduleMemoryReader, &image, size, name, args, prio, handle, nullptr);
+}
+
+CRTOS::Result CRTOS::Task::LPC55S69_Features::CreateTaskForExecutable(ModuleReader reader, void *context, const char *const name, void *args, uint32_t prio, TaskHandle *handle)
+{
+    return createElfTask(reader, context, 0u, name, args, prio, handle, nullptr);
+}
+
+// Allocates the RAM instance of a BIN module laid out as .data, .bss and stack,
+// copies the initial .data values, zeroes .bss and paints the stack
+static uint8_t *allocateModuleRam(const ProgramInfoBin *pinfo, const uint8_t *dataSrc, uint32_t &ramSize, uint32_t &stackSize)
+{
+    uint32_t ramDataBytes = pinfo->section_data_size;
+    uint32_t ramBssBytes = pinfo->section_bss_size;
+
+    stackSize = (pinfo->stackPointer > pinfo->msp_limit) ? (pinfo->stackPointer - pinfo->msp_limit) : 0u;
+    if (stackSize == 0u)
+    {
+        stackSize = DEFAULT_STACK_SIZE;
+    }
+    ramSize = ((ramDataBytes + ramBssBytes + 7u) & ~7u) + stackSize;
+
+    uint32_t prevMask = getInterruptMask();
+    uint8_t *ram = reinterpret_cast<uint8_t *>(mem.allocate(ramSize));
+    setInterruptMask(prevMask);
+    if (ram == nullptr)
+    {
+        return nullptr;
+    }
+
+    // The block is not visible to anybody else yet, it is filled with interrupts enabled
+    memset_optimized(ram, 0u, ramSize - stackSize);
+    memset32_optimized(reinterpret_cast<uint32_t *>(ram + ramSize - stackSize), STACK_PAINT, stackSize / sizeof(uint32_t));
+
+    if (ramDataBytes)
+    {
+        memcpy_optimized(ram, (void *)dataSrc, ramDataBytes);
+    }
+
+    return ram;
+}
+
+// Fills the TCB of a loaded module and makes it ready. The stack occupies the top
+// stackSize bytes of the module RAM, r9 is preset to staticBase.
+static void startModuleTask(TaskControlBlock *tcb, uint32_t entry, uint8_t *ram, uint32_t ramSize, uint32_t stackSize,
+                            uint32_t staticBase, const char *const name, void *args, uint32_t prio, CRTOS::Task::TaskHandle *handle)
+{
+    uint32_t msp = (uint32_t)(ram + ramSize);
+    uint32_t msplim = msp - stackSize;
+
+    tcb->module->ram = ram;
+    tcb->stack = (uint32_t *)msplim;
+    tcb->stackSize = (stackSize / sizeof(uint32_t));
+    tcb->function = (void (*)(void *))entry;
+    tcb->vtor_addr = 0u;
+    tcb->state = TaskState::TASK_READY;
+    tcb->timeout = 0u;
+    tcb->delayUpTo = 0u;
+
+    if (prio >= MAX_TASK_PRIORITY)
+    {
+        tcb->priority = MAX_TASK_PRIORITY - 1u;
+    }
+    else
+    {
+        tcb->priority = prio;
+    }
+
+    // Initialize stack frame
+    volatile uint32_t *alignedTop = (uint32_t *)(msp & ~7u);
+    tcb->stackTop = initStack(alignedTop, tcb->stack, tcb->function, args, staticBase);
+
+    // Task name
+    uint32_t nameLength = strlen_optimized(name) + 1u;
+    memcpy_optimized(&tcb->name[0], (char *)&name[0u], nameLength < 20u ? nameLength : 20u);
+
+    // Insert to ready list
+    ListInsertAtEnd(readyTaskList, tcb);
+    if (handle != nullptr)
+    {
+        *handle = (CRTOS::Task::TaskHandle)tcb;
+    }
+}
+
+// Binary module loader for modules (PIE BIN with ProgramInfo header)
+CRTOS::Result CRTOS::Task::LPC55S69_Features::CreateTaskForBinModule(uint8_t *bin, const char *const name, void *args, uint32_t prio, TaskHandle *handle)
+{
+    if (bin == nullptr)
+    {
+        return CRTOS::Result::RESULT_BAD_PARAMETER;
+    }
+
+    ModuleMemory image = { bin, MODULE_SIZE_UNKNOWN };
+    return CreateTaskForBinModule(moduleMemoryReader, &image, name, args, prio, handle);
+}
+
+CRTOS::Result CRTOS::Task::LPC55S69_Features::CreateTaskForBinModule(const uint8_t *bin, uint32_t size, const char *const name, void *args, uint32_t prio, TaskHandle *handle)
+{
+    if (bin == nullptr || size == 0u)
+    {
+        return CRTOS::Result::RESULT_BAD_PARAMETER;
+    }
+
+    ModuleMemory image = { bin, size };
+    return CreateTaskForBinModule(moduleMemoryReader, &image, name, args, prio, handle);
+}
+
+// BIN module loaded and patched, its task is not yet known to the scheduler
+struct PreparedModule
+{
+    TaskControlBlock *tcb;
+    uint32_t entry;
+    uint8_t *ram;
+    uint32_t ramSize;
+    uint32_t stackSize;
+    uint32_t staticBase;
+};
+
+// Prepares a BIN module. BASEPRI is raised only around heap operations and the image
+// cache; reading, inflating, checking and patching work on memory no other task can
+// see yet, so interrupts stay enabled for the copies.
+static CRTOS::Result prepareBinModule(CRTOS::Task::LPC55S69_Features::ModuleReader reader, void *context, void *args, PreparedModule &prepared)
+{
+    if (reader == nullptr)
+    {
+        return CRTOS::Result::RESULT_BAD_PARAMETER;
+    }
+
+    CRTOS::Result result = CRTOS::Result::RESULT_SUCCESS;
+    TaskControlBlock *tmpTCB = nullptr;
+    void *pool = nullptr;
+    uint32_t poolSize = 0u;
+
+    __DSB();
+    __ISB();
+
+    uint32_t prevMask = getInterruptMask();
+    mem.getMemoryPool(&pool, poolSize);
+    if ((pool != nullptr) && (poolSize != 0u))
+    {
+        tmpTCB = allocateModuleTask(args);
+    }
+    setInterruptMask(prevMask);
+
+    if ((pool == nullptr) || (poolSize == 0u))
+    {
+        return CRTOS::Result::RESULT_MEMORY_NOT_INITIALIZED;
+    }
+    if (tmpTCB == nullptr)
+    {
+        return CRTOS::Result::RESULT_NO_MEMORY;
+    }
+
+    do
+    {
+        ModuleControlBlock *module = tmpTCB->module;
+
+        // Determine image size using descriptor if present; otherwise fallback to data offset + data size.
+        // Only the descriptor is buffered, the image is read straight into its final place.
+        ModuleDescriptorBin md;
+        uint32_t imgSize = 0u;
+        if (reader(context, sizeof(ProgramInfoBin), &md, sizeof(ModuleDescriptorBin)) != 0)
+        {
+            result = CRTOS::Result::RESULT_MODULE_READ_ERROR;
+            continue;
+        }
+        if (md.magic == MODULE_MAGIC)
+        {
+            result = ModuleValidation::CheckDescriptor(md);
+            if (result != CRTOS::Result::RESULT_SUCCESS)
+            {
+                continue;
+            }
+            imgSize = md.image_size;
+        }
+        else
+        {
+            // Fallback: include code/rodata up to data image
+            uint32_t dataLayout[3u];
+            if (reader(context, offsetof(ProgramInfoBin, section_data_start_addr), &dataLayout[0u], sizeof(dataLayout)) != 0)
+            {
+                result = CRTOS::Result::RESULT_MODULE_READ_ERROR;
+                continue;
+            }
+            // section_data_start_addr + section_data_size
+            imgSize = dataLayout[0u] + dataLayout[2u];
+        }
+        if (imgSize == 0u)
+        {
+            // As a last resort, assume 4KB
+            imgSize = DEFAULT_MODULE_LEN;
+        }
+
+        // Static-base modules are never patched, their code is shared between instances
+        bool staticBase = (md.magic == MODULE_MAGIC) && ((md.flags & MODULE_FLAG_STATIC_BASE) != 0u);
+        uint32_t crc = 0u;
+        uint8_t *binary = nullptr;
+
+        if (staticBase)
+        {
+            // A packed module already carries the CRC of its image
+            if ((md.flags & MODULE_FLAG_IMAGE_CRC) != 0u)
+            {
+                crc = md.image_crc;
+            }
+            else if ((md.flags & MODULE_FLAG_COMPRESSED) != 0u)
+            {
+                // The cache key cannot be computed without inflating the image
+                result = CRTOS::Result::RESULT_MODULE_INVALID;
+            }
+            else
+            {
+                result = moduleImageCrc(reader, context, imgSize, crc);
+            }
+            if (result != CRTOS::Result::RESULT_SUCCESS)
+            {
+                continue;
+            }
+
+            prevMask = getInterruptMask();
+            module->shared = findModuleImage(md, imgSize, crc);
+            setInterruptMask(prevMask);
+            if (module->shared != nullptr)
+            {
+                binary = module->shared->code;
+            }
+        }
+
+        ImagePatch imagePatch = (binary != nullptr) ? ImagePatch::SKIP : ImagePatch::APPLY;
+
+        if (binary == nullptr)
+        {
+            // Allocate and copy the BIN image into heap (like Elf loader does)
+            prevMask = getInterruptMask();
+            binary = reinterpret_cast<uint8_t *>(mem.allocate(imgSize));
+            setInterruptMask(prevMask);
+            if (binary == nullptr)
+            {
+                result = CRTOS::Result::RESULT_NO_MEMORY;
+                continue;
+            }
+            module->image = binary;
+
+            // A corrupt image is rejected here, before the task exists
+            result = readModuleImage(reader, context, md, binary, imgSize);
+            if (result != CRTOS::Result::RESULT_SUCCESS)
+            {
+                continue;
+            }
+
+            if (staticBase)
+            {
+                prevMask = getInterruptMask();
+                module->shared = addModuleImage(md, imgSize, crc, binary);
+                if (module->shared != nullptr)
+                {
+                    module->image = nullptr;
                 }
-                break;
-            case TaskState::TASK_BLOCKED_BY_CIRC_BUFFER:
-                if (tickCount >= temp->data->timeout)
+                setInterruptMask(prevMask);
+                if (module->shared == nullptr)
                 {
-                    temp->data->state = TaskState::TASK_READY;
+                    result = CRTOS::Result::RESULT_NO_MEMORY;
+                    continue;
                 }
-                break;
-            case TaskState::TASK_RUNNING:
-                sCurrentTCB->state = TaskState::TASK_READY;
-                break;
-            default:
-                break;
+            }
+        }
+
+        // Work on the copied image
+        ProgramInfoBin *pinfo = reinterpret_cast<ProgramInfoBin *>(binary);
+        result = ModuleValidation::CheckProgramInfo(pinfo, imgSize);
+        if (result != CRTOS::Result::RESULT_SUCCESS)
+        {
+            continue;
+        }
+
+        uint32_t ramSize = 0u;
+        uint32_t stackSize = 0u;
+        uint8_t *stk = allocateModuleRam(pinfo, binary + pinfo->section_data_start_addr, ramSize, stackSize);
+        if (stk == nullptr)
+        {
+            result = CRTOS::Result::RESULT_NO_MEMORY;
+            continue;
+        }
+        module->ram = stk;
+
+        if (md.magic == MODULE_MAGIC)
+        {
+            if ((md.flags & MODULE_FLAG_RELOCATIONS) != 0u)
+            {
+                result = applyModuleRelocations(reader, context, md, binary, imgSize, imagePatch, stk, pinfo->section_data_size);
+            }
+            if (result == CRTOS::Result::RESULT_SUCCESS)
+            {
+                result = bindModuleImports(reader, context, md, binary, imgSize, stk, pinfo->section_data_size);
+            }
+            if (result != CRTOS::Result::RESULT_SUCCESS)
+            {
+                continue;
+            }
         }
 
-        if (temp->data->state == TaskState::TASK_READY)
+        uint32_t new_data_ram_addr = (uint32_t)stk;
+        uint32_t new_bss_addr = new_data_ram_addr + pinfo->section_data_size;
+        uint32_t new_msp = (uint32_t)(stk + ramSize);
+        uint32_t new_msplim = new_msp - stackSize;
+
+        // Relocate entry: binary image base is at 'binary', entry is offset from base; set Thumb bit
+        uint32_t new_entry = (uint32_t)(binary + pinfo->entryPoint);
+        new_entry |= 1u;
+
+        if (!staticBase)
         {
-            if (highestPriorityTask == nullptr || temp->data->priority > highestPriorityTask->data->priority)
-            {
-                highestPriorityTask = temp;
-            }
+            // Update ProgramInfo inside the copied image (mirroring ELF parser behavior)
+            pinfo->section_data_dest_addr = new_data_ram_addr;
+            // .data is already initialized and patched, the module startup copy becomes a no-op
+            pinfo->section_data_start_addr = new_data_ram_addr;
+            pinfo->section_bss_start_addr = new_bss_addr;
+            pinfo->stackPointer = new_msp;
+            pinfo->msp_limit = new_msplim;
+            pinfo->entryPoint = new_entry;
+            pinfo->vtor_offset = (uint32_t)(binary + 0); // segment base for this BIN
         }
 
-        temp = temp->next;
-    }
+        prepared.tcb = tmpTCB;
+        prepared.entry = new_entry;
+        prepared.ram = stk;
+        prepared.ramSize = ramSize;
+        prepared.stackSize = stackSize;
+        prepared.staticBase = staticBase ? new_data_ram_addr : 0xFEEDC0DEul;
+    } while (0);
 
-    if (highestPriorityTask != nullptr)
-    {
-        sCurrentTCB = highestPriorityTask->data;
-        sCurrentTCB->state = TaskState::TASK_RUNNING;
-    }
-    else
+    if (result != CRTOS::Result::RESULT_SUCCESS)
     {
-        sCurrentTCB = (TaskControlBlock *)(idleTaskHandle);
-        sCurrentTCB->state = TaskState::TASK_RUNNING;
+        prevMask = getInterruptMask();
+        freeModuleTask(tmpTCB);
+        setInterruptMask(prevMask);
     }
 
-    updateEnterCycles();
-    TASK_SWITCHED_IN();
+    return result;
 }
 
-void SysTick_Handler(void)
+static void discardPreparedModule(PreparedModule &prepared)
 {
-    uint32_t mask = getInterruptMask();
-
-    tickCount++;
-
-    if (isPendingTask() == true)
-    {
-        CRTOS::Task::ExitCriticalSection();
-        *ICSR_REG = NVIC_PENDSV_BIT;
-        __ISB();
-    }
-
-    setInterruptMask(mask);
+    uint32_t prevMask = getInterruptMask();
+    freeModuleTask(prepared.tcb);
+    setInterruptMask(prevMask);
 }
 
-static void dummyTask(void)
+// Publishing the task is the only step of a BIN load the scheduler can observe
+static CRTOS::Result loadBinModule(CRTOS::Task::LPC55S69_Features::ModuleReader reader, void *context, const char *const name, void *args, uint32_t prio,
+                                   CRTOS::Task::TaskHandle *handle, CRTOS::Task::LPC55S69_Features::Module::ModuleHandle *loaded)
 {
-    volatile uint32_t ulDummy = 0UL;
-    CRTOS::Task::Delete();
+    if (name == nullptr)
+    {
+        return CRTOS::Result::RESULT_BAD_PARAMETER;
+    }
 
-    getInterruptMask();
+    PreparedModule prepared;
+    CRTOS::Result result = prepareBinModule(reader, context, args, prepared);
+    if (result != CRTOS::Result::RESULT_SUCCESS)
+    {
+        return result;
+    }
 
-    while (ulDummy == 0)
+    uint32_t prevMask = getInterruptMask();
+    startModuleTask(prepared.tcb, prepared.entry, prepared.ram, prepared.ramSize, prepared.stackSize, prepared.staticBase,
+                    name, args, prio, handle);
+    if (loaded != nullptr)
     {
-        ;
+        *loaded = moduleHandle(prepared.tcb->module);
     }
+    setInterruptMask(prevMask);
+
+    return result;
 }
 
-uint32_t *initStack(volatile uint32_t *stackTop, volatile uint32_t *stackEnd, TaskFunction code, void *args)
+CRTOS::Result CRTOS::Task::LPC55S69_Features::CreateTaskForBinModule(ModuleReader reader, void *context, const char *const name, void *args, uint32_t prio, TaskHandle *handle)
 {
-    *(--stackTop) = (uint32_t)0x01000000lu; // xPSR
-    *(--stackTop) = (uint32_t)code;         // PC
-    *(--stackTop) = (uint32_t)dummyTask;    // LR
-    *(--stackTop) = (uint32_t)0xFEEDC0DEul; // R12
-    *(--stackTop) = (uint32_t)0xFEEDC0DEul; // R3
-    *(--stackTop) = (uint32_t)0xFEEDC0DEul; // R2
-    *(--stackTop) = (uint32_t)0xFEEDC0DEul; // R1
-    *(--stackTop) = (uint32_t)args;         // R0
-    *(--stackTop) = (uint32_t)0xFEEDC0DEul; // R11
-    *(--stackTop) = (uint32_t)0xFEEDC0DEul; // R10
-    *(--stackTop) = (uint32_t)0xFEEDC0DEul; // R09
-    *(--stackTop) = (uint32_t)0xFEEDC0DEul; // R08
-    *(--stackTop) = (uint32_t)0xFEEDC0DEul; // R07
-    *(--stackTop) = (uint32_t)0xFEEDC0DEul; // R06
-    *(--stackTop) = (uint32_t)0xFEEDC0DEul; // R05
-    *(--stackTop) = (uint32_t)0xFEEDC0DEul; // R04
-    *(--stackTop) = (uint32_t)0xFFFFFFFDul; // EXC_RETURN
-    *(--stackTop) = (uint32_t)stackEnd;     // PSPLIM
-
-    return ((uint32_t *)stackTop);
+    return loadBinModule(reader, context, name, args, prio, handle, nullptr);
 }
 
-void TimerISR(void *)
+// Execute-in-place loader: code and rodata stay in flash, only .data/.bss/stack use RAM
+static CRTOS::Result loadBinModuleXIP(const uint8_t *bin, const char *const name, void *args, uint32_t prio,
+                                      CRTOS::Task::TaskHandle *handle, CRTOS::Task::LPC55S69_Features::Module::ModuleHandle *loaded)
 {
-    while (1)
+    if (bin == nullptr || name == nullptr)
     {
-        Node<CRTOS::Timer::SoftwareTimer> *tmp = sTimerList;
-        while (tmp != nullptr)
-        {
-            if (tmp->data->isActive)
-            {
-                tmp->data->elapsedTicks++;
-                if (tmp->data->elapsedTicks >= tmp->data->timeoutTicks)
-                {
-                    tmp->data->callback(tmp->data->callbackArgs);
-                    if (tmp->data->autoReload == true)
-                    {
-                        tmp->data->elapsedTicks = 0u;
-                    }
-                    else
-                    {
-                        tmp->data->elapsedTicks = 0u;
-                        tmp->data->isActive = false;
-                    }
-                }
-            }
-            tmp = tmp->next;
-        }
-        CRTOS::Task::Delay(1u);
+        return CRTOS::Result::RESULT_BAD_PARAMETER;
     }
-}
 
-void idleTask(void *)
-{
-    for (;;)
+    const ProgramInfoBin *pinfo = reinterpret_cast<const ProgramInfoBin *>(bin);
+    const ModuleDescriptorBin *md = reinterpret_cast<const ModuleDescriptorBin *>(bin + sizeof(ProgramInfoBin));
+
+    // The image cannot be patched in flash, the module must address its data through r9
+    if (md->magic != MODULE_MAGIC || (md->flags & MODULE_FLAG_STATIC_BASE) == 0u || (md->flags & MODULE_FLAG_COMPRESSED) != 0u ||
+        ModuleValidation::CheckDescriptor(*md) != CRTOS::Result::RESULT_SUCCESS || ModuleValidation::CheckProgramInfo(pinfo, md->image_size) != CRTOS::Result::RESULT_SUCCESS)
     {
-        if (isPendingTask() == true)
-        {
-            *ICSR_REG = NVIC_PENDSV_BIT;
-            __ISB();
-        }
+        return CRTOS::Result::RESULT_MODULE_INVALID;
     }
-}
 
-CRTOS::Result CRTOS::Scheduler::Start(void)
-{
+    // Imports and relocations follow the image, the file size is not known
+    ModuleMemory image = { bin, MODULE_SIZE_UNKNOWN };
     CRTOS::Result result = CRTOS::Result::RESULT_SUCCESS;
+    TaskControlBlock *tmpTCB = nullptr;
     void *pool = nullptr;
     uint32_t poolSize = 0u;
 
-    do
-    {
-        mem.getMemoryPool(&pool, poolSize);
-
-        if ((pool == nullptr) || (poolSize == 0u))
-        {
-            result = CRTOS::Result::RESULT_MEMORY_NOT_INITIALIZED;
-            return result;
-        }
+    __DSB();
+    __ISB();
 
-        *NVIC_SHPR3_REG |= NVIC_PENDSV_PRIO;
-        *NVIC_SHPR3_REG |= NVIC_SYSTICK_PRIO;
+    // Only heap operations and publishing the task run masked, as for copied BIN modules
+    uint32_t prevMask = getInterruptMask();
+    mem.getMemoryPool(&pool, poolSize);
+    if ((pool != nullptr) && (poolSize != 0u))
+    {
+        tmpTCB = allocateModuleTask(args);
+    }
+    setInterruptMask(prevMask);
 
-        getInterruptMask();
+    if ((pool == nullptr) || (poolSize == 0u))
+    {
+        return CRTOS::Result::RESULT_MEMORY_NOT_INITIALIZED;
+    }
+    if (tmpTCB == nullptr)
+    {
+        return CRTOS::Result::RESULT_NO_MEMORY;
+    }
 
-        SysTick->CTRL = 0ul;
-        SysTick->VAL = 0ul;
+    uint32_t ramSize = 0u;
+    uint32_t stackSize = 0u;
+    uint8_t *ram = nullptr;
 
-        result = CRTOS::Task::Create(TimerISR, "TimerSVC", 512, nullptr, MAX_TASK_PRIORITY - 1u, nullptr);
-        if (result != CRTOS::Result::RESULT_SUCCESS)
+    do
+    {
+        ram = allocateModuleRam(pinfo, bin + pinfo->section_data_start_addr, ramSize, stackSize);
+        if (ram == nullptr)
         {
+            result = CRTOS::Result::RESULT_NO_MEMORY;
             continue;
         }
+        tmpTCB->module->ram = ram;
 
-        result = CRTOS::Task::Create(idleTask, "IDLE", 128, nullptr, 0u, &idleTaskHandle);
-        if (result != CRTOS::Result::RESULT_SUCCESS)
+        // Only .data can be patched, the image stays in flash
+        result = verifyModuleImage(bin, *md);
+        if (result == CRTOS::Result::RESULT_SUCCESS && (md->flags & MODULE_FLAG_RELOCATIONS) != 0u)
         {
-            continue;
+            result = applyModuleRelocations(moduleMemoryReader, &image, *md, (uint8_t *)bin, md->image_size, ImagePatch::REJECT, ram, pinfo->section_data_size);
         }
-
-        sCurrentTCB = readyTaskList->data;
-
-        Node<TaskControlBlock> *temp = readyTaskList;
-        while (temp != nullptr)
+        if (result == CRTOS::Result::RESULT_SUCCESS)
         {
-            temp->data->executionTime = 0;
-            temp->data->enterCycles = 0;
-            temp->data->exitCycles = 0;
-            temp = temp->next;
+            result = bindModuleImports(moduleMemoryReader, &image, *md, nullptr, md->image_size, ram, pinfo->section_data_size);
         }
+    } while (0);
 
-        SysTick->LOAD = (sCoreClock / sTickRate) - 1ul;
-        SysTick->VAL = 0u;
-        SysTick->CTRL = SysTick_CTRL_CLKSOURCE | SysTick_CTRL_TICKINT | SysTick_CTRL_ENABLE;
+    if (result != CRTOS::Result::RESULT_SUCCESS)
+    {
+        prevMask = getInterruptMask();
+        freeModuleTask(tmpTCB);
+        setInterruptMask(prevMask);
+        return result;
+    }
 
-        startFirstTask();
-    } while (0);
+    // Entry is an offset from the image base in flash; set Thumb bit
+    uint32_t entry = (uint32_t)(bin + pinfo->entryPoint) | 1u;
+
+    // .data was patched with interrupts enabled, make it visible before the task runs
+    __DSB();
+    __ISB();
+
+    prevMask = getInterruptMask();
+    startModuleTask(tmpTCB, entry, ram, ramSize, stackSize, (uint32_t)ram, name, args, prio, handle);
+    if (loaded != nullptr)
+    {
+        *loaded = moduleHandle(tmpTCB->module);
+    }
+    setInterruptMask(prevMask);
 
     return result;
 }
 
-void CRTOS::Task::Yield(void)
+CRTOS::Result CRTOS::Task::LPC55S69_Features::CreateTaskForBinModuleXIP(const uint8_t *bin, const char *const name, void *args, uint32_t prio, TaskHandle *handle)
 {
-    if (isHigherPrioTaskPending() == true)
+    return loadBinModuleXIP(bin, name, args, prio, handle, nullptr);
+}
+
+CRTOS::Result CRTOS::Task::LPC55S69_Features::Module::LoadExecutable(ModuleReader reader, void *context, const char *const name, void *args, uint32_t prio, ModuleHandle *module)
+{
+    if (module == nullptr)
     {
-        *ICSR_REG = NVIC_PENDSV_BIT;
-        __DSB();
-        __ISB();
+        return CRTOS::Result::RESULT_BAD_PARAMETER;
     }
+
+    // The reader runs with interrupts enabled, the module is taken when its task is published
+    *module = nullptr;
+    return createElfTask(reader, context, 0u, name, args, prio, nullptr, module);
 }
 
-CRTOS::Result CRTOS::Task::Create(TaskFunction function, const char *const name, uint32_t stackDepth, void *args, uint32_t prio, TaskHandle *handle)
+CRTOS::Result CRTOS::Task::LPC55S69_Features::Module::LoadBin(ModuleReader reader, void *context, const char *const name, void *args, uint32_t prio, ModuleHandle *module)
 {
-    CRTOS::Result result = CRTOS::Result::RESULT_SUCCESS;
-    uint32_t prevMask = getInterruptMask();
-    void *pool = nullptr;
-    uint32_t poolSize = 0u;
+    if (module == nullptr)
+    {
+        return CRTOS::Result::RESULT_BAD_PARAMETER;
+    }
 
-    __DSB();
-    __ISB();
+    *module = nullptr;
+    return loadBinModule(reader, context, name, args, prio, nullptr, module);
+}
 
-    mem.getMemoryPool(&pool, poolSize);
+static constexpr uint32_t MODULE_LOADER_STACK    = 256u;
+static constexpr uint32_t MODULE_LOADER_PRIORITY = 1u;
+static constexpr uint32_t MODULE_LOADER_POLL     = 100u;
 
-    if ((pool == nullptr) || (poolSize == 0u))
-    {
-        result = CRTOS::Result::RESULT_MEMORY_NOT_INITIALIZED;
-        return result;
-    }
+static CRTOS::Task::LPC55S69_Features::Module::LoadRequest *sLoadQueue = nullptr;
+static CRTOS::Task::TaskHandle sLoaderTask = nullptr;
+static CRTOS::BinarySemaphore sLoaderWake;
 
-    do
+// Serves LoadAsync requests in order. Running just above IDLE, it only takes CPU time
+// nobody else wants and the copies it makes leave interrupts enabled.
+static void moduleLoaderTask(void *)
+{
+    for (;;)
     {
-        TaskControlBlock *tmpTCB = reinterpret_cast<TaskControlBlock *>(mem.allocate(sizeof(TaskControlBlock)));
-        if (tmpTCB == nullptr)
+        uint32_t mask = getInterruptMask();
+        CRTOS::Task::LPC55S69_Features::Module::LoadRequest *request = sLoadQueue;
+        if (request != nullptr)
         {
-            result = CRTOS::Result::RESULT_NO_MEMORY;
-            continue;
+            sLoadQueue = request->next;
         }
+        setInterruptMask(mask);
 
-        uint32_t *tmpStack = reinterpret_cast<uint32_t *>(mem.allocate(stackDepth * sizeof(uint32_t)));
-        if (tmpStack == nullptr)
+        if (request == nullptr)
         {
-            mem.deallocate(tmpTCB);
-            result = CRTOS::Result::RESULT_NO_MEMORY;
+            sLoaderWake.wait(MODULE_LOADER_POLL);
             continue;
         }
 
-        for (uint32_t i = 0; i < stackDepth; i++)
-        {
-            tmpStack[i] = 0xDEADBEEF;
-        }
-        memset_optimized(&(tmpTCB->name[0u]), 0u, 20u);
-
-        tmpTCB->stack = &tmpStack[0u];
-        tmpTCB->stackSize = stackDepth;
-        tmpTCB->function = function;
-        tmpTCB->function_args = args;
-        tmpTCB->enterCycles = 0u;
-        tmpTCB->exitCycles = 0u;
-        tmpTCB->vtor_addr = 0u;
+        CRTOS::Result result = loadBinModule(request->reader, request->context, request->name, request->args, request->prio, nullptr, &request->module);
 
-        if (prio >= MAX_TASK_PRIORITY)
-        {
-            tmpTCB->priority = MAX_TASK_PRIORITY - 1u;
-        }
-        else
+        request->result = result;
+        if (request->done != nullptr)
         {
-            tmpTCB->priority = prio;
+            request->done->signal();
         }
+    }
+}
 
-        // Ustawienie stanu zadania
-        tmpTCB->state = TaskState::TASK_READY;
+CRTOS::Result CRTOS::Task::LPC55S69_Features::Module::LoadAsync(LoadRequest *request)
+{
+    if (request == nullptr || request->reader == nullptr || request->name == nullptr)
+    {
+        return CRTOS::Result::RESULT_BAD_PARAMETER;
+    }
 
-        uint32_t nameLength = pStringLength(name);
-        memcpy_optimized(&tmpTCB->name[0], (char *)&name[0u], nameLength < 20u ? nameLength : 20u);
+    CRTOS::Result result = CRTOS::Result::RESULT_SUCCESS;
+    uint32_t prevMask = getInterruptMask();
 
-        volatile uint32_t *stackTop = &(tmpTCB->stack[stackDepth - 1u]);
-        stackTop = (uint32_t *)(((uint32_t)stackTop) & ~7u);
+    do
+    {
+        if (sLoaderTask == nullptr)
+        {
+            result = createTask(moduleLoaderTask, "Loader", MODULE_LOADER_STACK, nullptr, MODULE_LOADER_PRIORITY, &sLoaderTask, kernelHeap());
+            if (result != CRTOS::Result::RESULT_SUCCESS)
+            {
+                sLoaderTask = nullptr;
+                continue;
+            }
 
-        tmpTCB->stackTop = initStack(stackTop, tmpTCB->stack, function, args);
+            // Kernel service, not owned by a module that happened to ask for it first
+            TaskControlBlock *loader = (TaskControlBlock *)sLoaderTask;
+            if (loader->module != nullptr)
+            {
+                loader->module->tasks--;
+                loader->module = nullptr;
+            }
+        }
 
-        ListInsertAtEnd(readyTaskList, tmpTCB);
+        request->result = CRTOS::Result::RESULT_MODULE_PENDING;
+        request->module = nullptr;
+        request->next = nullptr;
 
-        if (handle != nullptr)
+        LoadRequest **tail = &sLoadQueue;
+        while (*tail != nullptr)
         {
-            *handle = (TaskHandle)tmpTCB;
+            tail = &(*tail)->next;
         }
+        *tail = request;
     } while (0);
 
     setInterruptMask(prevMask);
 
+    if (result == CRTOS::Result::RESULT_SUCCESS)
+    {
+        sLoaderWake.signal();
+    }
+
     return result;
 }
 
-CRTOS::Result CRTOS::Task::LPC55S69_Features::CreateTaskForExecutable(const uint8_t *elf_file, const char *const name, void *args, uint32_t prio, TaskHandle *handle)
-{
-    CRTOS::Result result = CRTOS::Result::RESULT_SUCCESS;
-    uint32_t prevMask = getInterruptMask();
-    void *pool = nullptr;
-    uint32_t poolSize = 0u;
-
-    __DSB();
-    __ISB();
-
-    ElfFile elf;
-
-    mem.getMemoryPool(&pool, poolSize);
+static constexpr uint32_t MODULE_SWAP_POLL = 1u;
 
-    if ((pool == nullptr) || (poolSize == 0u))
+CRTOS::Result CRTOS::Task::LPC55S69_Features::Module::Replace(ModuleHandle *module, ModuleReader reader, void *context, uint32_t ticks)
+{
+    if (module == nullptr || *module == nullptr || reader == nullptr)
     {
-        result = CRTOS::Result::RESULT_MEMORY_NOT_INITIALIZED;
-        return result;
+        return CRTOS::Result::RESULT_BAD_PARAMETER;
     }
 
-    do
+    // The old module may go away whenever the mask is dropped, it is looked up again each time
+    ModuleHandle handle = *module;
+    char name[sizeof(TaskControlBlock::name) + 1u];
+    void *args = nullptr;
+    uint32_t prio = 0u;
+
+    uint32_t prevMask = getInterruptMask();
+    ModuleControlBlock *old = findModule(handle);
+    TaskControlBlock *oldTask = (old != nullptr) ? old->task : nullptr;
+    if (old == nullptr || oldTask == nullptr || old->swap != nullptr)
     {
-        TaskControlBlock *tmpTCB = reinterpret_cast<TaskControlBlock *>(mem.allocate(sizeof(TaskControlBlock)));
-        if (tmpTCB == nullptr)
+        setInterruptMask(prevMask);
+        if (old == nullptr)
         {
-            result = CRTOS::Result::RESULT_NO_MEMORY;
-            continue;
+            return CRTOS::Result::RESULT_BAD_PARAMETER;
         }
+        return (oldTask == nullptr) ? CRTOS::Result::RESULT_TASK_NOT_FOUND : CRTOS::Result::RESULT_MODULE_PENDING;
+    }
+    // The new instance takes over the endpoints the old one was given
+    args = oldTask->function_args;
+    prio = oldTask->priority;
+    memcpy_optimized(&name[0u], (void *)&oldTask->name[0u], sizeof(name) - 1u);
+    name[sizeof(name) - 1u] = '\0';
+    setInterruptMask(prevMask);
 
-        memset_optimized(&(tmpTCB->name[0u]), 0u, 20u);
+    // Loaded while the old instance keeps serving
+    PreparedModule prepared;
+    CRTOS::Result result = prepareBinModule(reader, context, args, prepared);
+    if (result != CRTOS::Result::RESULT_SUCCESS)
+    {
+        return result;
+    }
 
-        tmpTCB->stackSize = 0u;
-        tmpTCB->function_args = args;
-        tmpTCB->enterCycles = 0u;
-        tmpTCB->exitCycles = 0u;
+    ModuleSwap swap = {};
 
-        elf.parse(elf_file, (uint32_t **)(&(tmpTCB->stack)), &(tmpTCB->stackSize), &(tmpTCB->vtor_addr));
-        tmpTCB->vtor_addr = 0u;
+    prevMask = getInterruptMask();
+    if (findModule(handle) != old || old->task != oldTask || old->swap != nullptr)
+    {
+        setInterruptMask(prevMask);
+        discardPreparedModule(prepared);
+        return CRTOS::Result::RESULT_TASK_NOT_FOUND;
+    }
+    old->swap = &swap;
+    setInterruptMask(prevMask);
 
-        if (prio >= MAX_TASK_PRIORITY)
-        {
-            tmpTCB->priority = MAX_TASK_PRIORITY - 1u;
-        }
-        else
-        {
-            tmpTCB->priority = prio;
-        }
+    CRTOS::Result waited = swap.parked.wait(ticks);
 
-        tmpTCB->function = elf.entry_point;
+    prevMask = getInterruptMask();
+    bool claimed = swap.claimed;
+    bool alive = (findModule(handle) == old);
+    if (!claimed && alive)
+    {
+        old->swap = nullptr;
+    }
+    setInterruptMask(prevMask);
 
-        // Ustawienie stanu zadania
-        tmpTCB->state = TaskState::TASK_READY;
+    if (!claimed)
+    {
+        discardPreparedModule(prepared);
+        return alive ? CRTOS::Result::RESULT_SEMAPHORE_TIMEOUT : CRTOS::Result::RESULT_TASK_NOT_FOUND;
+    }
 
-        uint32_t nameLength = pStringLength(name);
-        memcpy_optimized(&tmpTCB->name[0], (char *)&name[0u], nameLength < 20u ? nameLength : 20u);
+    // Claimed just before the timeout, the state copy finishes shortly unless the
+    // old module is unloaded meanwhile
+    while (waited != CRTOS::Result::RESULT_SUCCESS && alive)
+    {
+        waited = swap.parked.wait(MODULE_SWAP_POLL);
 
-        volatile uint32_t *stackTop = &(tmpTCB->stack[tmpTCB->stackSize - 1u]);
-        stackTop = (uint32_t *)(((uint32_t)stackTop) & ~7u);
+        prevMask = getInterruptMask();
+        alive = (findModule(handle) == old);
+        setInterruptMask(prevMask);
+    }
 
-        tmpTCB->stackTop = initStack(stackTop, tmpTCB->stack, elf.entry_point, args);
+    prevMask = getInterruptMask();
+    alive = (findModule(handle) == old);
+    if (alive)
+    {
+        old->swap = nullptr;
+    }
+    if (!alive || swap.result != CRTOS::Result::RESULT_SUCCESS)
+    {
+        setInterruptMask(prevMask);
+        moduleDeallocate(swap.state);
+        discardPreparedModule(prepared);
+        return alive ? swap.result : CRTOS::Result::RESULT_TASK_NOT_FOUND;
+    }
 
-        ListInsertAtEnd(readyTaskList, tmpTCB);
+    // Old main task is parked at its swap point, switch over in one step
+    ModuleControlBlock *next = prepared.tcb->module;
+    next->state = swap.state;
+    next->stateSize = swap.stateSize;
 
-        if (handle != nullptr)
-        {
-            *handle = (TaskHandle)tmpTCB;
-        }
-    } while (0);
+    startModuleTask(prepared.tcb, prepared.entry, prepared.ram, prepared.ramSize, prepared.stackSize, prepared.staticBase,
+                    &name[0u], args, prio, nullptr);
 
+    ModuleHandle retired = handle;
+    result = Unload(&retired);
+    *module = moduleHandle(next);
     setInterruptMask(prevMask);
 
     return result;
 }
 
-// Binary module loader for modules (PIE BIN with ProgramInfo header)
-CRTOS::Result CRTOS::Task::LPC55S69_Features::CreateTaskForBinModule(uint8_t *bin, const char *const name, void *args, uint32_t prio, TaskHandle *handle)
+CRTOS::Result CRTOS::Task::LPC55S69_Features::Module::LoadBinXIP(const uint8_t *bin, const char *const name, void *args, uint32_t prio, ModuleHandle *module)
 {
-    if (bin == nullptr || name == nullptr)
+    if (module == nullptr)
     {
         return CRTOS::Result::RESULT_BAD_PARAMETER;
     }
 
+    *module = nullptr;
+    return loadBinModuleXIP(bin, name, args, prio, nullptr, module);
+}
+
+CRTOS::Result CRTOS::Task::LPC55S69_Features::Module::Unload(ModuleHandle *module)
+{
     CRTOS::Result result = CRTOS::Result::RESULT_SUCCESS;
     uint32_t prevMask = getInterruptMask();
-    void *pool = nullptr;
-    uint32_t poolSize = 0u;
+    bool unloadsItself = false;
 
     __DSB();
     __ISB();
 
-    mem.getMemoryPool(&pool, poolSize);
-    if ((pool == nullptr) || (poolSize == 0u))
-    {
-        return CRTOS::Result::RESULT_MEMORY_NOT_INITIALIZED;
-    }
-
     do
     {
-        TaskControlBlock *tmpTCB = reinterpret_cast<TaskControlBlock *>(mem.allocate(sizeof(TaskControlBlock)));
-        if (tmpTCB == nullptr)
+        if (module == nullptr || *module == nullptr)
         {
-            result = CRTOS::Result::RESULT_NO_MEMORY;
+            result = CRTOS::Result::RESULT_BAD_PARAMETER;
             continue;
         }
 
-        memset_optimized(&(tmpTCB->name[0u]), 0u, 20u);
-        tmpTCB->function_args = args;
-        tmpTCB->enterCycles = 0u;
-        tmpTCB->exitCycles = 0u;
-
-        // Determine image size using descriptor if present; otherwise fallback to data offset + data size
-        ProgramInfoBin *pinfo_src = reinterpret_cast<ProgramInfoBin *>(bin);
-        uint32_t imgSize = 0u;
-        ModuleDescriptorBin *md = reinterpret_cast<ModuleDescriptorBin *>(bin + sizeof(ProgramInfoBin));
-        if (md->magic == MODULE_MAGIC)
-        {
-            imgSize = md->image_size;
-        }
-        else
-        {
-            // Fallback: include code/rodata up to data image
-            imgSize = pinfo_src->section_data_start_addr + pinfo_src->section_data_size;
-        }
-        if (imgSize == 0u)
+        ModuleControlBlock *mcb = findModule(*module);
+        if (mcb == nullptr)
         {
-            // As a last resort, assume 4KB
-            imgSize = DEFAULT_MODULE_LEN;
+            result = CRTOS::Result::RESULT_BAD_PARAMETER;
+            continue;
         }
 
-        // Allocate and copy the BIN image into heap (like Elf loader does)
-        uint8_t *binary = reinterpret_cast<uint8_t *>(mem.allocate(imgSize));
-        if (binary == nullptr)
+        uint32_t remaining = mcb->tasks;
+        Node<TaskControlBlock> *tmp = readyTaskList;
+        uint32_t pos = 0u;
+
+        // The module goes away with its last task, stop before touching it again
+        while (tmp != nullptr && remaining != 0u)
         {
-            mem.deallocate(tmpTCB);
-            result = CRTOS::Result::RESULT_NO_MEMORY;
-            continue;
-        }
+            TaskControlBlock *tcb = tmp->data;
+            tmp = tmp->next;
 
-        memcpy_optimized(binary, bin, imgSize);
+            if (tcb->module != mcb)
+            {
+                pos++;
+                continue;
+            }
 
-        // Work on the copied image
-        ProgramInfoBin *pinfo = reinterpret_cast<ProgramInfoBin *>(binary);
+            if (tcb == sCurrentTCB)
+            {
+                unloadsItself = true;
+            }
 
-        // Compute RAM allocation for .data + .bss + stack
-        uint32_t ramDataBytes = pinfo->section_data_size;
-        uint32_t ramBssBytes = pinfo->section_bss_size;
-        uint32_t stackSize = (pinfo->stackPointer > pinfo->msp_limit) ? (pinfo->stackPointer - pinfo->msp_limit) : 0u;
-        uint32_t ramSize = ramDataBytes + ramBssBytes + stackSize;
-        if (stackSize == 0u)
-        {
-            stackSize = DEFAULT_STACK_SIZE;
-        }
-        if (ramSize == 0u)
-        {
-            ramSize = stackSize;
+            ListDeleteAtPosition(readyTaskList, pos);
+            remaining--;
+            releaseTask(tcb);
         }
 
-        uint8_t *stk = reinterpret_cast<uint8_t *>(mem.allocate(ramSize));
-        if (stk == nullptr)
+        if (remaining != 0u)
         {
-            mem.deallocate(binary);
-            mem.deallocate(tmpTCB);
-            result = CRTOS::Result::RESULT_NO_MEMORY;
+            result = CRTOS::Result::RESULT_TASK_NOT_FOUND;
             continue;
         }
-        memset_optimized(stk, 0u, ramSize);
-
-        // Copy .data image from BIN into the new RAM area; locate source inside copied image
-        if (ramDataBytes)
-        {
-            void *src = (void *)(binary + pinfo->section_data_start_addr);
-            memcpy_optimized(stk, src, ramDataBytes);
-        }
-        uint32_t new_data_ram_addr = (uint32_t)stk;
-        uint32_t new_bss_addr = new_data_ram_addr + ramDataBytes;
-        uint32_t new_msp = (uint32_t)(stk + ramSize);
-        uint32_t new_msplim = new_msp - stackSize;
-
-        // Relocate entry: binary image base is at 'binary', entry is offset from base; set Thumb bit
-        uint32_t new_entry = (uint32_t)(binary + pinfo->entryPoint);
-        new_entry |= 1u;
-
-        // Update ProgramInfo inside the copied image (mirroring ELF parser behavior)
-        pinfo->section_data_dest_addr = new_data_ram_addr;
-        pinfo->section_data_start_addr = (uint32_t)(binary + pinfo->section_data_start_addr);
-        pinfo->section_bss_start_addr = new_bss_addr;
-        pinfo->stackPointer = new_msp;
-        pinfo->msp_limit = new_msplim;
-        pinfo->entryPoint = new_entry;
-        pinfo->vtor_offset = (uint32_t)(binary + 0); // segment base for this BIN
-
-        // Fill TCB using relocated values
-        tmpTCB->stack = (uint32_t *)new_msplim;
-        tmpTCB->stackSize = (stackSize / sizeof(uint32_t));
-        tmpTCB->function = (void (*)(void *))new_entry;
-        tmpTCB->vtor_addr = 0u; // pinfo->vtor_offset;
-        tmpTCB->state = TaskState::TASK_READY;
-        tmpTCB->timeout = 0u;
-        tmpTCB->delayUpTo = 0u;
 
-        if (prio >= MAX_TASK_PRIORITY)
-        {
-            tmpTCB->priority = MAX_TASK_PRIORITY - 1u;
-        }
-        else
-        {
-            tmpTCB->priority = prio;
-        }
+        *module = nullptr;
+    } while (0);
 
-        // Initialize stack frame
-        volatile uint32_t *alignedTop = (uint32_t *)(((uint32_t)new_msp) & ~7u);
-        tmpTCB->stackTop = initStack(alignedTop, tmpTCB->stack, tmpTCB->function, args);
+    if (unloadsItself)
+    {
+        *ICSR_REG = NVIC_PENDSV_BIT;
+    }
 
-        // Task name
-        uint32_t nameLength = pStringLength(name);
-        memcpy_optimized(&tmpTCB->name[0], (char *)&name[0u], nameLength < 20u ? nameLength : 20u);
+    setInterruptMask(prevMask);
 
-        // Insert to ready list
-        ListInsertAtEnd(readyTaskList, tmpTCB);
-        if (handle != nullptr)
-        {
-            *handle = (TaskHandle)tmpTCB;
-        }
-    } while (0);
+    return result;
+}
 
+CRTOS::Task::TaskHandle CRTOS::Task::LPC55S69_Features::Module::GetTask(ModuleHandle module)
+{
+    uint32_t prevMask = getInterruptMask();
+    ModuleControlBlock *mcb = findModule(module);
+    TaskHandle task = (mcb != nullptr) ? (TaskHandle)mcb->task : nullptr;
     setInterruptMask(prevMask);
-    return result;
+
+    return task;
 }
 
 CRTOS::Result CRTOS::Task::Delete(void)
@@ -1496,8 +3561,7 @@ CRTOS::Result CRTOS::Task::Delete(void)
             continue;
         }
 
-        mem.deallocate((void *)sCurrentTCB->stack);
-        mem.deallocate((void *)sCurrentTCB);
+        releaseTask((TaskControlBlock *)sCurrentTCB);
     } while (0);
 
     *ICSR_REG = NVIC_PENDSV_BIT;
@@ -1550,8 +3614,7 @@ CRTOS::Result CRTOS::Task::Delete(TaskHandle *handle)
             continue;
         }
 
-        mem.deallocate((void *)tmpHandle->stack);
-        mem.deallocate((void *)tmpHandle);
+        releaseTask(tmpHandle);
     } while (0);
 
     *ICSR_REG = NVIC_PENDSV_BIT;
@@ -1659,7 +3722,7 @@ uint32_t CRTOS::Task::GetFreeStack(void)
 
     for (uint32_t *ptr = stackStart; ptr < stackEnd; ++ptr)
     {
-        if (*ptr != 0xDEADBEEF)
+        if (*ptr != STACK_PAINT)
         {
             usedStack = (uint32_t)(stackEnd - ptr);
             break;
@@ -2158,86 +4221,188 @@ CRTOS::Result CRTOS::CircularBuffer::Receive(uint8_t *data, uint32_t size, uint3
     }
 }
 
-CRTOS::Result CRTOS::CRC32::Init(void)
+CRTOS::Arena::Arena(uint32_t chunkSize)
+    : mFirst(nullptr),
+      mCurrent(nullptr),
+      mChunkSize(chunkSize)
 {
-    CRTOS::Result result = CRTOS::Result::RESULT_SUCCESS;
+}
+
+CRTOS::Arena::~Arena(void)
+{
+    Reset();
+
+    uint32_t mask = getInterruptMask();
+    mem.deallocate(mFirst);
+    setInterruptMask(mask);
 
-    if (sCrcTable == nullptr)
+    mFirst = nullptr;
+    mCurrent = nullptr;
+}
+
+void *CRTOS::Arena::Allocate(uint32_t size, uint32_t alignment)
+{
+    if (size == 0u || alignment == 0u || (alignment & (alignment - 1u)) != 0u)
     {
-        sCrcTable = reinterpret_cast<uint32_t *>(mem.allocate(sCrcTableSize * sizeof(uint32_t)));
+        return nullptr;
     }
-    else
+
+    if (mCurrent != nullptr)
     {
-        result = CRTOS::Result::RESULT_CRC_ALREADY_INITIALIZED;
-        return result;
+        uint8_t *base = reinterpret_cast<uint8_t *>(mCurrent + 1);
+        uintptr_t address = (uintptr_t)(base + mCurrent->used);
+        uint32_t offset = (uint32_t)(((address + alignment - 1u) & ~(uintptr_t)(alignment - 1u)) - (uintptr_t)base);
+
+        if (offset + size <= mCurrent->size)
+        {
+            mCurrent->used = offset + size;
+            return base + offset;
+        }
+    }
+
+    // Current chunk exhausted, chain a new one large enough for this request
+    uint32_t chunkSize = (size + alignment > mChunkSize) ? (size + alignment) : mChunkSize;
+
+    uint32_t mask = getInterruptMask();
+    Chunk *chunk = reinterpret_cast<Chunk *>(mem.allocate(sizeof(Chunk) + chunkSize));
+    setInterruptMask(mask);
+
+    if (chunk == nullptr)
+    {
+        return nullptr;
     }
 
-    if (sCrcTable == nullptr)
+    chunk->next = nullptr;
+    chunk->size = chunkSize;
+    chunk->used = 0u;
+
+    if (mCurrent == nullptr)
     {
-        result = CRTOS::Result::RESULT_NO_MEMORY;
+        mFirst = chunk;
     }
     else
     {
-        for (uint32_t i = 0; i < 256; i++)
-        {
-            uint32_t crc = i;
-            for (uint32_t j = 0; j < 8; j++)
-            {
-                if (crc & 1)
-                {
-                    crc = (crc >> 1) ^ sPolynomial;
-                }
-                else
-                {
-                    crc >>= 1;
-                }
-            }
-            sCrcTable[i] = crc;
-        }
+        mCurrent->next = chunk;
     }
+    mCurrent = chunk;
 
-    return result;
+    return Allocate(size, alignment);
 }
 
-CRTOS::Result CRTOS::CRC32::Calculate(const uint8_t *data, uint32_t length, uint32_t &output, uint32_t crc)
+CRTOS::Arena::Marker CRTOS::Arena::GetMarker(void) const
 {
-    CRTOS::Result result = CRTOS::Result::RESULT_SUCCESS;
+    Marker marker;
+    marker.chunk = mCurrent;
+    marker.offset = (mCurrent != nullptr) ? mCurrent->used : 0u;
 
-    if (data == nullptr)
+    return marker;
+}
+
+void CRTOS::Arena::Release(const Marker &marker)
+{
+    Chunk *chunk = reinterpret_cast<Chunk *>(marker.chunk);
+
+    if (chunk == nullptr)
     {
-        result = CRTOS::Result::RESULT_BAD_PARAMETER;
-        return result;
+        // Marker taken before anything was allocated, keep the first chunk for reuse
+        chunk = mFirst;
+        if (chunk == nullptr)
+        {
+            return;
+        }
+        chunk->used = 0u;
+    }
+    else
+    {
+        chunk->used = marker.offset;
     }
 
-    if (sCrcTable == nullptr)
+    // Overflow chunks chained after the marker go back to the heap
+    Chunk *overflow = chunk->next;
+    chunk->next = nullptr;
+    mCurrent = chunk;
+
+    uint32_t mask = getInterruptMask();
+    while (overflow != nullptr)
     {
-        result = CRTOS::Result::RESULT_CRC_NOT_INITIALIZED;
-        return result;
+        Chunk *next = overflow->next;
+        mem.deallocate(overflow);
+        overflow = next;
     }
+    setInterruptMask(mask);
+}
+
+void CRTOS::Arena::Reset(void)
+{
+    Marker marker;
+    marker.chunk = nullptr;
+    marker.offset = 0u;
+
+    Release(marker);
+}
+
+uint32_t CRTOS::Arena::GetUsed(void) const
+{
+    uint32_t used = 0u;
 
-    for (uint32_t i = 0; i < length; i++)
+    for (Chunk *chunk = mFirst; chunk != nullptr; chunk = chunk->next)
     {
-        crc = (crc >> 8) ^ sCrcTable[(crc ^ data[i]) & 0xFF];
+        used += chunk->used;
     }
 
-    output = crc;
-    output = output ^ 0xFFFFFFFF;
+    return used;
+}
 
-    return result;
+CRTOS::Arena::Scope::Scope(Arena &arena)
+    : mArena(arena),
+      mMarker(arena.GetMarker())
+{
 }
 
-CRTOS::Result CRTOS::CRC32::Deinit(void)
+CRTOS::Arena::Scope::~Scope(void)
+{
+    mArena.Release(mMarker);
+}
+
+// The tables are constant, Init and Deinit are kept for existing callers
+CRTOS::Result CRTOS::CRC32::Init(void)
+{
+    return CRTOS::Result::RESULT_SUCCESS;
+}
+
+CRTOS::Result CRTOS::CRC32::Calculate(const uint8_t *data, uint32_t length, uint32_t &output, uint32_t crc)
 {
     CRTOS::Result result = CRTOS::Result::RESULT_SUCCESS;
 
-    if (sCrcTable == nullptr)
+    if (data == nullptr)
     {
-        result = CRTOS::Result::RESULT_CRC_NOT_INITIALIZED;
+        result = CRTOS::Result::RESULT_BAD_PARAMETER;
+        return result;
     }
-    else
+
+    output = CRTOS::Crc32Iso::Finish(CRTOS::Crc32Iso::Update(crc, data, length));
+
+    return result;
+}
+
+CRTOS::Result CRTOS::CRC32::CopyAndCalculate(uint8_t *dst, const uint8_t *src, uint32_t length, uint32_t &output, uint32_t crc)
+{
+    if (dst == nullptr || src == nullptr)
     {
-        mem.deallocate(sCrcTable);
+        return CRTOS::Result::RESULT_BAD_PARAMETER;
     }
 
-    return result;
+    output = CRTOS::Crc32Iso::Finish(CRTOS::Crc32Iso::CopyAndUpdate(crc, dst, src, length));
+
+    return CRTOS::Result::RESULT_SUCCESS;
+}
+
+CRTOS::Result CRTOS::CRC32::Deinit(void)
+{
+    return CRTOS::Result::RESULT_SUCCESS;
+}
+
+uint32_t CRTOS::CRC32::Combine(uint32_t crcA, uint32_t crcB, uint32_t lengthB)
+{
+    return CRTOS::Crc32Iso::Combine(crcA, crcB, lengthB);
 }
@@ -18,6 +18,8 @@
 #include <cstdint>
 #include <atomic>
 
+#include "Crc.hpp"
+
 template <typename T>
 class Node;
 
@@ -44,16 +46,90 @@ namespace CRTOS
         RESULT_IPC_TIMEOUT,
         RESULT_IPC_EMPTY,
         RESULT_CRC_NOT_INITIALIZED,
-        RESULT_CRC_ALREADY_INITIALIZED
+        RESULT_CRC_ALREADY_INITIALIZED,
+        RESULT_NOT_SUPPORTED,
+        RESULT_MODULE_READ_ERROR,
+        RESULT_MODULE_INVALID,
+        RESULT_MODULE_PENDING,
+        RESULT_COPY_PENDING,
+        RESULT_MEMORY_LOCKED
     };
 
+    class BinarySemaphore;
+
     namespace Config
     {
         void SetCoreClock(uint32_t ClockInMHz);
         void SetTickRate(uint32_t TicksPerSecond);
-        Result InitMem(void *pool, uint32_t size);
+        // When kernelSize is not zero, that many bytes at the start of the pool are
+        // reserved for kernel objects and the rest is used for application memory
+        Result InitMem(void *pool, uint32_t size, uint32_t kernelSize = 0u);
         uint32_t GetFreeMemory(void);
         uint32_t GetAllocatedMemory(void);
+        uint32_t GetKernelFreeMemory(void);
+        uint32_t GetKernelAllocatedMemory(void);
+
+        // Allocation trace, available when built with HEAP_ALLOCATOR_TRACE=1.
+        // Records are stored in the given buffer which is used as a ring buffer.
+        Result EnableHeapTrace(void *buffer, uint32_t bufferSize);
+        Result DisableHeapTrace(void);
+        // Emits retained records oldest first as "op,size,ptr,task,cycles" lines
+        Result DumpHeapTrace(void (*output)(const char *line));
+
+        // Size histogram of the kernel's memcpy/memset calls, available when built with
+        // MEMORY_OPS_HISTOGRAM=1. Bucket n holds sizes from 2^(n-1) to 2^n - 1.
+        Result ResetCopyHistogram(void);
+        // Emits "op,min_size,max_size,calls,misaligned" lines for non-empty buckets
+        Result DumpCopyHistogram(void (*output)(const char *line));
+    }
+
+    namespace Memory
+    {
+        // Handle to a movable allocation, memory behind it may be relocated
+        // by heap compaction unless it is locked
+        typedef uint16_t Handle;
+
+        Result AllocateMovable(uint32_t size, Handle &handle);
+        // Fails with RESULT_MEMORY_LOCKED until every Lock has been undone
+        Result FreeMovable(Handle handle);
+        Result Lock(Handle handle, void *&ptr);
+        Result Unlock(Handle handle);
+        // Compacts the whole heap and returns the number of moved blocks. Runs with
+        // interrupts enabled between block moves, each move is masked.
+        uint32_t Compact(void);
+
+        // Copy queued with CopyAsync. The request and both buffers stay owned by the caller
+        // and must remain valid until result leaves RESULT_COPY_PENDING, or until completion
+        // returns when one is set.
+        struct CopyRequest
+        {
+            void *dst;
+            const void *src;
+            uint32_t length;
+            BinarySemaphore *done;                      // Signalled once result is final, may be nullptr
+            void (*completion)(CopyRequest *request);   // Called once result is final, may be nullptr
+            void *context;                              // Free for the caller, e.g. for completion
+            volatile Result result;
+            CopyRequest *next;
+        };
+
+        // Backend moving the data of one request at a time. start is called with interrupts
+        // masked and must return at once; the backend then reports the end with CopyDone from
+        // a task or an interrupt. completion runs in that same context.
+        struct CopyEngine
+        {
+            void (*start)(CopyRequest *request);
+        };
+
+        // Queues len bytes from src to dst and returns at once, requests finish in order.
+        // The buffers must not overlap.
+        Result CopyAsync(void *dst, const void *src, uint32_t len, CopyRequest *request);
+        // Backend for requests started from now on, nullptr selects the software worker task
+        Result SetCopyEngine(const CopyEngine *engine);
+        // Selects the DMA0 backend using the given channel, needs MEMORY_OPS_DMA
+        Result UseDmaCopyEngine(uint32_t channel);
+        // Called by a backend once the request it was started with is finished
+        void CopyDone(CopyRequest *request, Result result);
     }
 
     class Mutex
@@ -111,10 +187,74 @@ namespace CRTOS
 
         namespace LPC55S69_Features
         {
+            // Reads length bytes at offset of a module image into dst, returns 0 on success.
+            // Lets modules be loaded from external flash or a file system without buffering them.
+            typedef int (*ModuleReader)(void *context, uint32_t offset, void *dst, uint32_t length);
+
+            // Trusted images only: without their size nothing bounds the reads of a malformed file
             Result CreateTaskForExecutable(const uint8_t *elf_file, const char *const name, void *args, uint32_t prio, TaskHandle *handle);
+            // Same with the size of the file, no header of a malformed image can point past it
+            Result CreateTaskForExecutable(const uint8_t *elf_file, uint32_t size, const char *const name, void *args, uint32_t prio, TaskHandle *handle);
+            Result CreateTaskForExecutable(ModuleReader reader, void *context, const char *const name, void *args, uint32_t prio, TaskHandle *handle);
             // Create task from a raw BIN module produced by this module template
 			// The BIN layout begins with ProgramInfo followed by code/rodata.
 			Result CreateTaskForBinModule(uint8_t *bin, const char *const name, void *args, uint32_t prio, TaskHandle *handle);
+			// Same with the size of the BIN file, reads past it fail with RESULT_MODULE_READ_ERROR
+			Result CreateTaskForBinModule(const uint8_t *bin, uint32_t size, const char *const name, void *args, uint32_t prio, TaskHandle *handle);
+			Result CreateTaskForBinModule(ModuleReader reader, void *context, const char *const name, void *args, uint32_t prio, TaskHandle *handle);
+			// Execute a BIN module in place from flash, only .data/.bss/stack are placed in RAM.
+			// The module must be built with MODULE_FLAG_STATIC_BASE (data addressed through r9).
+			Result CreateTaskForBinModuleXIP(const uint8_t *bin, const char *const name, void *args, uint32_t prio, TaskHandle *handle);
+
+            // Kernel services modules are linked against at load time, see module_api.h
+            typedef struct
+            {
+                const char *name;
+                uint32_t address;
+            } KernelExport;
+
+            const KernelExport *GetKernelExports(uint32_t &count);
+            Result FindKernelExport(const char *name, uint32_t &address);
+
+            // A loaded module owns its code image, its RAM and every task it starts.
+            // Deleting the last of its tasks or unloading it frees all of that memory.
+            namespace Module
+            {
+                // Identifies a loaded module. A handle outlives its module safely: once the
+                // module is unloaded or its last task exited, calls taking it return
+                // RESULT_BAD_PARAMETER, or nullptr for GetTask.
+                typedef void* ModuleHandle;
+
+                // Load queued with LoadAsync. The request and the name stay owned by the
+                // caller and must remain valid until result leaves RESULT_MODULE_PENDING.
+                struct LoadRequest
+                {
+                    ModuleReader reader;
+                    void *context;
+                    const char *name;
+                    void *args;
+                    uint32_t prio;
+                    BinarySemaphore *done;   // Signalled once result is final, may be nullptr
+                    volatile Result result;
+                    ModuleHandle module;
+                    LoadRequest *next;
+                };
+
+                Result LoadExecutable(ModuleReader reader, void *context, const char *const name, void *args, uint32_t prio, ModuleHandle *module);
+                Result LoadBin(ModuleReader reader, void *context, const char *const name, void *args, uint32_t prio, ModuleHandle *module);
+                Result LoadBinXIP(const uint8_t *bin, const char *const name, void *args, uint32_t prio, ModuleHandle *module);
+                // Queues a BIN module for the low priority loader task and returns at once
+                Result LoadAsync(LoadRequest *request);
+                // Loads a new BIN image of a running module and switches over once the old
+                // main task calls crtos_swap_point, waiting at most ticks for it. The new main
+                // task gets the same args, priority and name, so the queues and buffers passed
+                // in args keep their contents; the old module is unloaded and *module updated.
+                Result Replace(ModuleHandle *module, ModuleReader reader, void *context, uint32_t ticks);
+                // Stops every task of the module and frees its memory
+                Result Unload(ModuleHandle *module);
+                // Main task of the module, nullptr once it has been deleted
+                TaskHandle GetTask(ModuleHandle module);
+            };
         };
     };
 
@@ -180,19 +320,66 @@ namespace CRTOS
            Result Receive(uint8_t* data, uint32_t size, uint32_t timeout_ms = 0u);
    };
 
-    namespace CRC32
+    class Arena
     {
-        namespace
-        {
-            static const uint32_t sCrcTableSize = 256u;
-            __attribute__((used)) static uint32_t *sCrcTable = nullptr;
-            static const uint32_t sPolynomial = 0xEDB88320u;
-        }
+        public:
+            // Arena position, releasing it frees everything allocated afterwards
+            struct Marker
+            {
+                void *chunk;
+                uint32_t offset;
+            };
+
+            // Releases all allocations made during its lifetime, scopes can be nested
+            class Scope
+            {
+                public:
+                    explicit Scope(Arena &arena);
+                    ~Scope(void);
+
+                private:
+                    Arena &mArena;
+                    Marker mMarker;
+            };
+
+            explicit Arena(uint32_t chunkSize);
+            Arena(const Arena&) = delete;
+            Arena& operator=(const Arena&) = delete;
+            ~Arena(void);
 
+            void* Allocate(uint32_t size, uint32_t alignment = 8u);
+            Marker GetMarker(void) const;
+            void Release(const Marker &marker);
+            void Reset(void);
+            uint32_t GetUsed(void) const;
+
+        private:
+            struct Chunk
+            {
+                Chunk *next;
+                uint32_t size;
+                uint32_t used;
+            };
+
+            Chunk *mFirst;
+            Chunk *mCurrent;
+            uint32_t mChunkSize;
+    };
+
+    namespace CRC32
+    {
+        // Tables are generated at compile time, Init and Deinit do nothing
         CRTOS::Result Init(void);
         CRTOS::Result Calculate(const uint8_t* data, uint32_t length, uint32_t &output, uint32_t previousCrc = 0xFFFFFFFFu);
+        // Copies length bytes to dst and returns the CRC32 of them, in a single pass
+        CRTOS::Result CopyAndCalculate(uint8_t* dst, const uint8_t* src, uint32_t length, uint32_t &output, uint32_t previousCrc = 0xFFFFFFFFu);
         CRTOS::Result Deinit(void);
+        // CRC32 of A followed by B, given the CRC32 of both parts and the length of B
+        uint32_t Combine(uint32_t crcA, uint32_t crcB, uint32_t lengthB);
     }
+
+    // Incremental CRC32 without the final XOR juggling of previousCrc
+    typedef Crc32Iso::Context Crc32Context;
 };
 
 #endif /* RTOS_HPP */
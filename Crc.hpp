@@ -0,0 +1,446 @@
+/*
+ * Crc
+ * Author: Arkadiusz Szlanta
+ * Date: 17 Oct 2026
+ *
+ * License:
+ * This source code is provided for hobbyist and private use only.
+ * Any commercial or industrial use, including distribution, reproduction, or
+ * incorporation in commercial or industrial products or services is prohibited.
+ * Use at your own risk. The author(s) hold no responsibility for any damages
+ * or losses resulting from the use of this software.
+ *
+ */
+
+#ifndef CRC_HPP
+#define CRC_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "CRC slicing assumes little endian loads");
+
+namespace CRTOS
+{
+    namespace CrcDetail
+    {
+        template <typename Value, uint32_t Slices>
+        struct Tables
+        {
+            Value slice[Slices][256u];
+        };
+
+        template <typename Value, uint32_t Width>
+        constexpr Value reflect(Value value)
+        {
+            Value result = 0u;
+            for (uint32_t i = 0u; i < Width; i++)
+            {
+                result = (Value)((result << 1u) | ((value >> i) & 1u));
+            }
+            return result;
+        }
+
+        template <typename Value, uint32_t Width>
+        constexpr Value mask(void)
+        {
+            return (Value)((Width == 64u) ? ~0ull : ((1ull << (Width % 64u)) - 1u));
+        }
+
+        // Register advanced over one byte
+        template <typename Value, uint32_t Width, bool RefIn>
+        constexpr Value advance(const Value (&table)[256u], Value crc, uint8_t byte)
+        {
+            if (RefIn)
+            {
+                return (Value)((Width > 8u ? (crc >> (8u % Width)) : 0u) ^ table[(crc ^ byte) & 0xFFu]);
+            }
+            return (Value)(((Width > 8u ? (crc << (8u % Width)) : 0u) ^ table[((crc >> (Width - 8u)) ^ byte) & 0xFFu]) & mask<Value, Width>());
+        }
+
+        // slice[n][b] is the register after byte b followed by n zero bytes
+        template <typename Value, uint32_t Width, uint64_t Poly, bool RefIn, uint32_t Slices>
+        constexpr Tables<Value, Slices> makeTables(void)
+        {
+            Tables<Value, Slices> tables{};
+            const Value top = (Value)(1ull << (Width - 1u));
+            const Value poly = RefIn ? reflect<Value, Width>((Value)(Poly & mask<Value, Width>())) : (Value)(Poly & mask<Value, Width>());
+
+            for (uint32_t i = 0u; i < 256u; i++)
+            {
+                Value crc = RefIn ? (Value)i : (Value)((uint64_t)i << (Width - 8u));
+                for (uint32_t j = 0u; j < 8u; j++)
+                {
+                    if (RefIn)
+                    {
+                        crc = (crc & 1u) ? (Value)((crc >> 1u) ^ poly) : (Value)(crc >> 1u);
+                    }
+                    else
+                    {
+                        crc = (Value)(((crc & top) ? ((crc << 1u) ^ poly) : (crc << 1u)) & mask<Value, Width>());
+                    }
+                }
+                tables.slice[0u][i] = crc;
+            }
+
+            for (uint32_t n = 1u; n < Slices; n++)
+            {
+                for (uint32_t i = 0u; i < 256u; i++)
+                {
+                    tables.slice[n][i] = advance<Value, Width, RefIn>(tables.slice[0u], tables.slice[n - 1u][i], 0u);
+                }
+            }
+
+            return tables;
+        }
+
+        // Register contents read as a polynomial over GF(2) modulo Poly: x^0 is the top bit
+        // of a reflected register and bit 0 of a normal one. A zero bit fed to the register
+        // multiplies it by x.
+        template <typename Value, uint32_t Width, uint64_t Poly, bool RefIn>
+        constexpr Value timesX(Value value)
+        {
+            if (RefIn)
+            {
+                const Value poly = reflect<Value, Width>((Value)(Poly & mask<Value, Width>()));
+                return (value & 1u) ? (Value)((value >> 1u) ^ poly) : (Value)(value >> 1u);
+            }
+            const Value top = (Value)(1ull << (Width - 1u));
+            return (Value)(((value & top) ? ((value << 1u) ^ Poly) : (value << 1u)) & mask<Value, Width>());
+        }
+
+        template <typename Value, uint32_t Width, uint64_t Poly, bool RefIn>
+        constexpr Value multiply(Value a, Value b)
+        {
+            Value product = 0u;
+            for (uint32_t i = 0u; i < Width; i++)
+            {
+                if ((RefIn ? (a >> (Width - 1u - i)) : (a >> i)) & 1u)
+                {
+                    product ^= b;
+                }
+                b = timesX<Value, Width, Poly, RefIn>(b);
+            }
+            return product;
+        }
+
+        template <typename Value>
+        struct Powers
+        {
+            Value power[64u];
+        };
+
+        // power[k] is x^(8 * 2^k), the effect of 2^k zero bytes
+        template <typename Value, uint32_t Width, uint64_t Poly, bool RefIn>
+        constexpr Powers<Value> makePowers(void)
+        {
+            Powers<Value> powers{};
+            Value value = RefIn ? (Value)(1ull << (Width - 1u)) : (Value)1u;
+
+            for (uint32_t i = 0u; i < 8u; i++)
+            {
+                value = timesX<Value, Width, Poly, RefIn>(value);
+            }
+            for (uint32_t k = 0u; k < 64u; k++)
+            {
+                powers.power[k] = value;
+                value = multiply<Value, Width, Poly, RefIn>(value, value);
+            }
+
+            return powers;
+        }
+    }
+
+    // CRC of 8 to 64 bits described by the usual catalogue parameters. Poly and Init are
+    // given unreflected. Lookup tables are generated at compile time and end up in flash:
+    // Slices = 8 processes eight bytes per step with 8 tables, Slices = 1 keeps a single
+    // table and works bytewise. Buffers shorter than one step are always done bytewise.
+    // Needs C++14 for the constexpr table generation.
+    template <uint32_t Width, uint64_t Poly, uint64_t Init, bool RefIn, bool RefOut, uint64_t XorOut, uint32_t Slices = 8u>
+    class Crc
+    {
+        static_assert(Width >= 8u && Width <= 64u, "CRC width must be 8 to 64 bits");
+        static_assert(Slices == 1u || Slices == 8u, "CRC supports bytewise or slicing-by-8 tables");
+
+        public:
+            typedef typename std::conditional<(Width <= 8u), uint8_t,
+                    typename std::conditional<(Width <= 16u), uint16_t,
+                    typename std::conditional<(Width <= 32u), uint32_t, uint64_t>::type>::type>::type Value;
+
+            static constexpr Value MASK = CrcDetail::mask<Value, Width>();
+
+            // Register value to start with. Begin, Update and Finish allow a checksum over
+            // several buffers; the register is kept reflected when RefIn is set.
+            static constexpr Value Begin(void)
+            {
+                return RefIn ? reflect(Init & MASK) : (Value)(Init & MASK);
+            }
+
+            static Value Update(Value crc, const uint8_t *data, size_t length)
+            {
+                crc = updateSteps(crc, data, length, Sliced());
+
+                while (length > 0u)
+                {
+                    crc = updateByte(crc, *data++);
+                    length--;
+                }
+
+                return crc;
+            }
+
+            // Same as Update, copying the data to dst with one load and one store per word
+            static Value CopyAndUpdate(Value crc, uint8_t *dst, const uint8_t *src, size_t length)
+            {
+                crc = copySteps(crc, dst, src, length, Sliced());
+
+                while (length > 0u)
+                {
+                    uint8_t byte = *src++;
+                    *dst++ = byte;
+                    crc = updateByte(crc, byte);
+                    length--;
+                }
+
+                return crc;
+            }
+
+            static constexpr Value Finish(Value crc)
+            {
+                return (Value)(((RefIn != RefOut) ? reflect(crc) : crc) ^ (XorOut & MASK));
+            }
+
+            static Value Calculate(const uint8_t *data, size_t length)
+            {
+                return Finish(Update(Begin(), data, length));
+            }
+
+            // CRC of A followed by B from the CRCs of both parts and the length of B, so parts
+            // of a buffer can be checksummed independently. Takes O(Width * log(lengthB)).
+            static Value Combine(Value crcA, Value crcB, uint64_t lengthB)
+            {
+                return Finish((Value)(shift((Value)(unfinish(crcA) ^ Begin()), lengthB) ^ unfinish(crcB)));
+            }
+
+            // Running checksum of a stream, Finalize may be called at any point
+            class Context
+            {
+                public:
+                    Context(void) : mCrc(Begin()), mLength(0u) {}
+
+                    void Reset(void)
+                    {
+                        mCrc = Begin();
+                        mLength = 0u;
+                    }
+
+                    void Update(const uint8_t *data, size_t length)
+                    {
+                        mCrc = Crc::Update(mCrc, data, length);
+                        mLength += length;
+                    }
+
+                    void CopyAndUpdate(uint8_t *dst, const uint8_t *src, size_t length)
+                    {
+                        mCrc = Crc::CopyAndUpdate(mCrc, dst, src, length);
+                        mLength += length;
+                    }
+
+                    // Appends a part checksummed elsewhere, e.g. by another task
+                    void Append(Value crc, uint64_t length)
+                    {
+                        mCrc = unfinish(Combine(Finish(mCrc), crc, length));
+                        mLength += length;
+                    }
+
+                    Value Finalize(void) const
+                    {
+                        return Finish(mCrc);
+                    }
+
+                    uint64_t GetLength(void) const
+                    {
+                        return mLength;
+                    }
+
+                private:
+                    Value mCrc;
+                    uint64_t mLength;
+            };
+
+            // CRC of "123456789", the check value listed in the catalogue
+            static constexpr Value Check(void)
+            {
+                const char check[] = "123456789";
+                Value crc = Begin();
+                for (uint32_t i = 0u; i < 9u; i++)
+                {
+                    crc = updateByte(crc, (uint8_t)check[i]);
+                }
+                return Finish(crc);
+            }
+
+        private:
+            typedef CrcDetail::Tables<Value, Slices> Tables;
+            // Selects the step functions below, bytewise tables have no slices to step with
+            typedef std::integral_constant<bool, (Slices == 8u)> Sliced;
+
+            static constexpr size_t STEP = 8u;
+            static constexpr Tables sTables = CrcDetail::makeTables<Value, Width, Poly, RefIn, Slices>();
+
+            static constexpr CrcDetail::Powers<Value> sPowers = CrcDetail::makePowers<Value, Width, Poly, RefIn>();
+
+            static constexpr Value reflect(Value value)
+            {
+                return CrcDetail::reflect<Value, Width>(value);
+            }
+
+            // Register value a finished CRC was produced from
+            static constexpr Value unfinish(Value crc)
+            {
+                crc = (Value)(crc ^ (XorOut & MASK));
+                return (RefIn != RefOut) ? reflect(crc) : crc;
+            }
+
+            // Register after length zero bytes
+            static Value shift(Value crc, uint64_t length)
+            {
+                for (uint32_t k = 0u; length != 0u; k++, length >>= 1u)
+                {
+                    if (length & 1u)
+                    {
+                        crc = CrcDetail::multiply<Value, Width, Poly, RefIn>(sPowers.power[k], crc);
+                    }
+                }
+                return crc;
+            }
+
+            static constexpr Value updateByte(Value crc, uint8_t byte)
+            {
+                return CrcDetail::advance<Value, Width, RefIn>(sTables.slice[0u], crc, byte);
+            }
+
+            // Whole steps of Update, data and length are advanced past them. Words are
+            // loaded through memcpy, which compiles to plain loads once data is aligned.
+            static Value updateSteps(Value crc, const uint8_t *&data, size_t &length, std::true_type)
+            {
+                while (length > 0u && ((uintptr_t)data & 3u) != 0u)
+                {
+                    crc = updateByte(crc, *data++);
+                    length--;
+                }
+
+                while (length >= STEP)
+                {
+                    uint32_t words[STEP / sizeof(uint32_t)];
+                    std::memcpy(&words[0u], data, sizeof(words));
+
+                    crc = updateStep(crc, &words[0u]);
+
+                    data += STEP;
+                    length -= STEP;
+                }
+
+                return crc;
+            }
+
+            static Value updateSteps(Value crc, const uint8_t *&, size_t &, std::false_type)
+            {
+                return crc;
+            }
+
+            static Value copySteps(Value crc, uint8_t *&dst, const uint8_t *&src, size_t &length, std::true_type)
+            {
+                while (length > 0u && ((uintptr_t)dst & 3u) != 0u)
+                {
+                    uint8_t byte = *src++;
+                    *dst++ = byte;
+                    crc = updateByte(crc, byte);
+                    length--;
+                }
+
+                while (length >= STEP)
+                {
+                    uint32_t words[STEP / sizeof(uint32_t)];
+                    std::memcpy(&words[0u], src, sizeof(words));
+                    std::memcpy(dst, &words[0u], sizeof(words));
+
+                    crc = updateStep(crc, &words[0u]);
+
+                    src += STEP;
+                    dst += STEP;
+                    length -= STEP;
+                }
+
+                return crc;
+            }
+
+            static Value copySteps(Value crc, uint8_t *&, const uint8_t *&, size_t &, std::false_type)
+            {
+                return crc;
+            }
+
+            // Eight bytes at once from two words as loaded from memory (little endian). The
+            // register is folded into the first Width bits of the message.
+            static Value updateStep(Value crc, const uint32_t *words)
+            {
+                const Value (&t)[Slices][256u] = sTables.slice;
+                uint32_t one = words[0u];
+                uint32_t two = words[1u];
+
+                if (RefIn)
+                {
+                    one ^= (uint32_t)crc;
+                    if (Width > 32u)
+                    {
+                        two ^= (uint32_t)((uint64_t)crc >> 32u);
+                    }
+
+                    return t[7u][one & 0xFFu] ^ t[6u][(one >> 8u) & 0xFFu] ^ t[5u][(one >> 16u) & 0xFFu] ^ t[4u][one >> 24u] ^
+                           t[3u][two & 0xFFu] ^ t[2u][(two >> 8u) & 0xFFu] ^ t[1u][(two >> 16u) & 0xFFu] ^ t[0u][two >> 24u];
+                }
+                else
+                {
+                    // Message bits enter most significant first
+                    one = __builtin_bswap32(one);
+                    two = __builtin_bswap32(two);
+
+                    uint64_t folded = (uint64_t)crc << (64u - Width);
+                    one ^= (uint32_t)(folded >> 32u);
+                    if (Width > 32u)
+                    {
+                        two ^= (uint32_t)folded;
+                    }
+
+                    return t[7u][one >> 24u] ^ t[6u][(one >> 16u) & 0xFFu] ^ t[5u][(one >> 8u) & 0xFFu] ^ t[4u][one & 0xFFu] ^
+                           t[3u][two >> 24u] ^ t[2u][(two >> 16u) & 0xFFu] ^ t[1u][(two >> 8u) & 0xFFu] ^ t[0u][two & 0xFFu];
+                }
+            }
+    };
+
+    // Definitions of the tables, needed before C++17 made static constexpr members inline
+    template <uint32_t Width, uint64_t Poly, uint64_t Init, bool RefIn, bool RefOut, uint64_t XorOut, uint32_t Slices>
+    constexpr typename Crc<Width, Poly, Init, RefIn, RefOut, XorOut, Slices>::Tables Crc<Width, Poly, Init, RefIn, RefOut, XorOut, Slices>::sTables;
+
+    template <uint32_t Width, uint64_t Poly, uint64_t Init, bool RefIn, bool RefOut, uint64_t XorOut, uint32_t Slices>
+    constexpr CrcDetail::Powers<typename Crc<Width, Poly, Init, RefIn, RefOut, XorOut, Slices>::Value> Crc<Width, Poly, Init, RefIn, RefOut, XorOut, Slices>::sPowers;
+
+    // Catalogue parameter sets used by CRTOS and its protocols
+    typedef Crc<8u, 0x07u, 0x00u, false, false, 0x00u, 1u> Crc8;
+    typedef Crc<16u, 0x1021u, 0xFFFFu, false, false, 0x0000u> Crc16Ccitt;
+    typedef Crc<16u, 0x1021u, 0x0000u, true, true, 0x0000u> Crc16Kermit;
+    typedef Crc<32u, 0x04C11DB7u, 0xFFFFFFFFu, true, true, 0xFFFFFFFFu> Crc32Iso;
+    typedef Crc<32u, 0x1EDC6F41u, 0xFFFFFFFFu, true, true, 0xFFFFFFFFu> Crc32C;
+    typedef Crc<64u, 0x42F0E1EBA9EA3693ull, ~0ull, true, true, ~0ull> Crc64Xz;
+
+    static_assert(Crc8::Check() == 0xF4u, "CRC-8/SMBUS check");
+    static_assert(Crc16Ccitt::Check() == 0x29B1u, "CRC-16/IBM-3740 check");
+    static_assert(Crc16Kermit::Check() == 0x2189u, "CRC-16/KERMIT check");
+    static_assert(Crc32Iso::Check() == 0xCBF43926u, "CRC-32/ISO-HDLC check");
+    static_assert(Crc32C::Check() == 0xE3069283u, "CRC-32/ISCSI check");
+    static_assert(Crc64Xz::Check() == 0x995DC9BBDF1939FAull, "CRC-64/XZ check");
+}
+
+#endif /* CRC_HPP */
@@ -12,232 +12,1204 @@
  *
  */
 
+#include <algorithm>
 #include <cstring>
 #include <cstdlib>
-//#include <cstdio>
 
 #include <ELFParser.hpp>
+#include <MemoryOps.hpp>
+#include <module_api.h>
+
+static inline uint32_t readWord(uint32_t addr)
+{
+    uint32_t value;
+    memcpy(&value, (const void *)(uintptr_t)addr, sizeof(value));
+    return value;
+}
+
+static inline void writeWord(uint32_t addr, uint32_t value)
+{
+    memcpy((void *)(uintptr_t)addr, &value, sizeof(value));
+}
+
+static inline uint16_t readHalf(uint32_t addr)
+{
+    uint16_t value;
+    memcpy(&value, (const void *)(uintptr_t)addr, sizeof(value));
+    return value;
+}
+
+static inline void writeHalf(uint32_t addr, uint16_t value)
+{
+    memcpy((void *)(uintptr_t)addr, &value, sizeof(value));
+}
 
 int ElfFile::parse(const uint8_t *elf)
 {
-    // Set binary pointer to elf file temporary
-    binary = (uint8_t*)elf;
+    uint32_t *stack = nullptr;
+    uint32_t stackSize = 0u;
+    uint32_t vtor_offset = 0u;
+
+    return parse(elf, &stack, &stackSize, &vtor_offset);
+}
+
+// Every read passes ElfFile::read first, so it stays within the size given to setFileSize.
+// Without one nothing bounds it, the buffer must then hold a trusted ELF file.
+static int memoryReader(void *context, uint32_t offset, void *dst, uint32_t length)
+{
+    memcpy(dst, (const uint8_t *)context + offset, length);
+    return 0;
+}
+
+int ElfFile::parse(const uint8_t *elf, uint32_t **stack, uint32_t *stackSize, uint32_t *vtor_offset)
+{
+    if (elf == nullptr)
+    {
+        return ELF_ERROR_BAD_FORMAT;
+    }
+
+    return parse(memoryReader, (void *)elf, stack, stackSize, vtor_offset);
+}
+
+int ElfFile::parse(ElfReader elfReader, void *context, uint32_t **stack, uint32_t *stackSize, uint32_t *vtor_offset)
+{
+    reader = elfReader;
+    readerContext = context;
+
+    int status = load();
+
+    // Program headers are only needed while loading
+    deallocate(phdr);
+    phdr = nullptr;
+
+    if (status != ELF_OK)
+    {
+        release();
+        return status;
+    }
+
+    *stack = (uint32_t *)(ram.load + (stackLinkBase - ram.linkBase));
+    *stackSize = (stackLinkTop - stackLinkBase) / sizeof(uint32_t);
+    *vtor_offset = (uint32_t)(uintptr_t)image.load;
+
+    return ELF_OK;
+}
+
+void ElfFile::setAllocator(ElfAllocate allocate, ElfDeallocate deallocate)
+{
+    allocateFn = allocate;
+    deallocateFn = deallocate;
+}
+
+void ElfFile::setResolver(ElfResolver symbolResolver)
+{
+    resolver = symbolResolver;
+}
+
+void ElfFile::setFileSize(uint32_t size)
+{
+    fileSize = size;
+}
+
+ElfFile::~ElfFile()
+{
+    releaseIndex();
+}
+
+uint8_t *ElfFile::getImage(void) const
+{
+    return image.load;
+}
+
+uint8_t *ElfFile::getRam(void) const
+{
+    return ram.load;
+}
+
+uint32_t ElfFile::getMemSize(void)
+{
+    return getImageSize() + getRamSize();
+}
+
+uint32_t ElfFile::getImageSize(void)
+{
+    return (image.load != nullptr) ? (image.linkEnd - image.linkBase) : 0u;
+}
+
+uint32_t ElfFile::getRamSize(void)
+{
+    return (ram.load != nullptr) ? (ram.linkEnd - ram.linkBase) : 0u;
+}
 
-    parse_elf();
+int ElfFile::load(void)
+{
+    if (reader == nullptr)
+    {
+        return ELF_ERROR_READ;
+    }
 
-    // We parsed the file so we can allocate required memory and copy file to RAM
-    binary = (uint8_t*)malloc(phdr->p_offset + phdr->p_memsz);
-    memcpy(&binary[0], &elf[0], phdr->p_offset + phdr->p_memsz);
+    int status = parse_elf();
+    if (status != ELF_OK)
+    {
+        return status;
+    }
 
-    header = (Elf32_Ehdr*)&binary[0];
-    program_header = (Elf32_Phdr*)&binary[header->e_phoff];
+    status = layout();
+    if (status != ELF_OK)
+    {
+        return status;
+    }
 
-    ProgramInfoExtra info;
-    memset(&info, 0, sizeof(ProgramInfoExtra));
-    info.progInfo   = (ProgramInfo*)&binary[program_header->p_offset];
+    uint32_t imageSize = image.linkEnd - image.linkBase;
+    uint32_t ramSize = ram.linkEnd - ram.linkBase;
 
-    info.stackSize  = info.progInfo->stackPointer - info.progInfo->msp_limit;
-    info.ramSize    = info.progInfo->stackPointer - info.progInfo->section_data_dest_addr;
+    image.load = (uint8_t *)allocate(imageSize);
+    ram.load = (uint8_t *)allocate(ramSize);
+    if (image.load == nullptr || ram.load == nullptr)
+    {
+        return ELF_ERROR_NO_MEMORY;
+    }
 
-    uint8_t *stk = (uint8_t*)malloc(info.ramSize);
-    memset(stk, 0, info.ramSize);
+    // .bss and the stack start zeroed, .data is copied over below
+    memset(ram.load, 0, ramSize);
 
-    // Find and copy data section to proper address
-    for (int i = 0; i < ehdr->e_phnum; ++i)
+    for (int i = 0; i < header.e_phnum; ++i)
     {
-        if (info.progInfo->section_data_dest_addr == phdr[i].p_vaddr)
+        if (phdr[i].p_type != PT_LOAD || phdr[i].p_memsz == 0u)
+        {
+            continue;
+        }
+
+        Region &region = (phdr[i].p_flags & PF_W) ? ram : image;
+        uint8_t *dst = region.load + (phdr[i].p_vaddr - region.linkBase);
+
+        status = read(phdr[i].p_offset, dst, phdr[i].p_filesz);
+        if (status != ELF_OK)
+        {
+            return status;
+        }
+        if (&region == &image)
         {
-            memcpy(&binary[program_header->p_offset + phdr[i].p_paddr], &binary[phdr[i].p_offset], phdr[i].p_memsz);
+            memset(dst + phdr[i].p_filesz, 0, phdr[i].p_memsz - phdr[i].p_filesz);
         }
     }
 
-    // Magic things
-    info.new_data_ram_addr = (uint32_t)stk;
-    info.new_data_flash_addr = (uint32_t)&binary[program_header->p_offset + info.progInfo->section_data_start_addr];
-    info.new_bss_addr = info.new_data_ram_addr + info.progInfo->section_data_size;
-    info.new_msp = info.new_data_ram_addr + info.ramSize;
-    info.new_msplim = info.new_msp - info.stackSize;
-    info.new_entry = (uint32_t)&binary[program_header->p_offset + info.progInfo->entryPoint - 1];
+    // Keep the link-time values, relocation may rewrite words inside ProgramInfo
+    ProgramInfo *progInfo = (ProgramInfo *)image.load;
+    ProgramInfo linked = *progInfo;
 
-    info.progInfo->section_data_dest_addr = info.new_data_ram_addr;
-    info.progInfo->section_data_start_addr = info.new_data_flash_addr;
-    info.progInfo->section_bss_start_addr = info.new_bss_addr;
-    info.progInfo->stackPointer = info.new_msp;
-    info.progInfo->msp_limit = info.new_msplim;
-    info.progInfo->entryPoint = info.new_entry;
-    info.progInfo->vtor_offset = (uint32_t)&binary[program_header->p_offset];
+    status = relocate();
+    if (status != ELF_OK)
+    {
+        return status;
+    }
 
-    entry_point = (void (*)(void *))info.progInfo->entryPoint;
+    uint32_t entry = (linked.entryPoint != 0u) ? linked.entryPoint : header.e_entry;
+    uint32_t dataAddr = linked.section_data_dest_addr;
+    uint32_t bssAddr = linked.section_bss_start_addr;
 
-    return 0;
+    // A module starting or pointing outside what was loaded would run from link-time addresses
+    if (!translate(dataAddr, dataAddr) || !translate(bssAddr, bssAddr) || !translate(entry & ~1u, entry))
+    {
+        return ELF_ERROR_BAD_FORMAT;
+    }
+
+    // .data is already in place, so the module startup copy becomes a no-op
+    progInfo->section_data_dest_addr = dataAddr;
+    progInfo->section_data_start_addr = dataAddr;
+    progInfo->section_bss_start_addr = bssAddr;
+    progInfo->stackPointer = (uint32_t)(uintptr_t)(ram.load + (stackLinkTop - ram.linkBase));
+    progInfo->msp_limit = (uint32_t)(uintptr_t)(ram.load + (stackLinkBase - ram.linkBase));
+    progInfo->entryPoint = entry | 1u;
+    progInfo->vtor_offset = (uint32_t)(uintptr_t)image.load;
+
+    entry_point = (void (*)(void *))(uintptr_t)progInfo->entryPoint;
+
+    return ELF_OK;
 }
 
-int ElfFile::parse(const uint8_t *elf, uint32_t **stack, uint32_t *stackSize, uint32_t *vtor_offset)
+int ElfFile::layout(void)
 {
-    // Set binary pointer to elf file temporary
-    binary = (uint8_t*)elf;
+    const Elf32_Phdr *first = nullptr;
+
+    image.linkBase = 0xFFFFFFFFu;
+    image.linkEnd = 0u;
+    ram.linkBase = 0xFFFFFFFFu;
+    ram.linkEnd = 0u;
+
+    for (int i = 0; i < header.e_phnum; ++i)
+    {
+        // Sizes and address ranges were checked by validate()
+        if (phdr[i].p_type != PT_LOAD || phdr[i].p_memsz == 0u)
+        {
+            continue;
+        }
+
+        Region &region = (phdr[i].p_flags & PF_W) ? ram : image;
+        if (phdr[i].p_vaddr < region.linkBase)
+        {
+            region.linkBase = phdr[i].p_vaddr;
+            if (&region == &image)
+            {
+                first = &phdr[i];
+            }
+        }
+        if (phdr[i].p_vaddr + phdr[i].p_memsz > region.linkEnd)
+        {
+            region.linkEnd = phdr[i].p_vaddr + phdr[i].p_memsz;
+        }
+    }
 
-    parse_elf();
+    // ProgramInfo sits at the start of the lowest read-only segment
+    if (first == nullptr || first->p_filesz < sizeof(ProgramInfo))
+    {
+        return ELF_ERROR_NO_LOAD_SEGMENT;
+    }
 
-    binary = nullptr;
+    ProgramInfo progInfo;
+    int status = read(first->p_offset, &progInfo, sizeof(ProgramInfo));
+    if (status != ELF_OK)
+    {
+        return status;
+    }
 
-    // We parsed the file so we can allocate required memory and copy file to RAM
-    binary = (uint8_t*)malloc(phdr->p_offset + phdr->p_memsz);
-    memcpy(&binary[0], &elf[0], phdr->p_offset + phdr->p_memsz);
+    bool hasRam = (ram.linkEnd != 0u);
 
-    header = (Elf32_Ehdr*)&binary[0];
-    program_header = (Elf32_Phdr*)&binary[header->e_phoff];
+    if (progInfo.stackPointer > progInfo.msp_limit && progInfo.msp_limit != 0u)
+    {
+        stackLinkBase = progInfo.msp_limit;
+        stackLinkTop = progInfo.stackPointer;
+    }
+    else
+    {
+        // No stack described by the module, place a default one after .bss
+        stackLinkBase = hasRam ? ((ram.linkEnd + 7u) & ~7u) : 0u;
+        stackLinkTop = stackLinkBase + MODULE_DEFAULT_STACK_SIZE;
+        if (stackLinkTop < stackLinkBase)
+        {
+            return ELF_ERROR_BAD_PROGRAM_HEADER;
+        }
+    }
 
-    ProgramInfoExtra info;
-    memset(&info, 0, sizeof(ProgramInfoExtra));
-    info.progInfo   = (ProgramInfo*)&binary[program_header->p_offset];
+    if (!hasRam || stackLinkBase < ram.linkBase)
+    {
+        ram.linkBase = stackLinkBase;
+    }
+    if (!hasRam || stackLinkTop > ram.linkEnd)
+    {
+        ram.linkEnd = stackLinkTop;
+    }
 
-    info.stackSize  = 0u;//info.progInfo->stackPointer - info.progInfo->msp_limit;
-    info.ramSize    = info.progInfo->stackPointer - info.progInfo->section_data_dest_addr;
+    if (stackLinkBase < image.linkEnd && stackLinkTop > image.linkBase)
+    {
+        return ELF_ERROR_BAD_FORMAT;
+    }
 
-    uint8_t *stk = (uint8_t*)malloc(info.ramSize);
-    memset(stk, 0, info.ramSize);
+    return ELF_OK;
+}
 
-    uint32_t data_sum = 0u;
+int ElfFile::relocate(void)
+{
+    if (header.e_shoff == 0u || header.e_shnum == 0u)
+    {
+        // Stripped PIE module, nothing to patch
+        return ELF_OK;
+    }
 
-    // Find and copy data section to proper address
-    for (int i = 0; i < ehdr->e_phnum; ++i)
+    for (uint32_t i = 0u; i < header.e_shnum; ++i)
     {
-        if (phdr[i].p_flags == 6u)
+        Elf32_Shdr rel;
+        int status = readSection(i, rel);
+        if (status != ELF_OK)
+        {
+            return status;
+        }
+
+        if (rel.sh_type != SHT_REL)
+        {
+            continue;
+        }
+
+        // Skip relocations of debug sections, sh_info is 0 for dynamic relocations
+        if (rel.sh_info != 0u)
         {
-            data_sum += phdr[i].p_memsz;
+            Elf32_Shdr target;
+            if (readSection(rel.sh_info, target) != ELF_OK || (target.sh_flags & SHF_ALLOC) == 0u)
+            {
+                continue;
+            }
         }
-        if (info.progInfo->section_data_dest_addr == phdr[i].p_vaddr)
+
+        status = relocateSection(rel);
+        if (status != ELF_OK)
         {
-            memcpy(&binary[program_header->p_offset + phdr[i].p_paddr], &binary[phdr[i].p_offset], phdr[i].p_memsz);
+            return status;
         }
     }
 
-    info.stackSize = info.ramSize - data_sum;
+    return ELF_OK;
+}
+
+int ElfFile::relocateSection(const Elf32_Shdr &rel)
+{
+    static constexpr uint32_t BATCH = 16u;
 
-    // Magic things
-    info.new_data_ram_addr = (uint32_t)stk;
-    info.new_data_flash_addr = (uint32_t)&binary[program_header->p_offset + info.progInfo->section_data_start_addr];
-    info.new_bss_addr = info.new_data_ram_addr + info.progInfo->section_data_size;
-    info.new_msp = info.new_data_ram_addr + info.ramSize;
-    info.new_msplim = info.new_msp - info.stackSize;
-    info.new_entry = (uint32_t)&binary[program_header->p_offset + info.progInfo->entryPoint - 1];
+    Elf32_Rel entries[BATCH];
+    uint32_t count = rel.sh_size / sizeof(Elf32_Rel);
+    Elf32_Shdr symtab;
+    uint32_t symCount = 0u;
 
-    *stack = (uint32_t*)(info.new_msplim);
-    *stackSize = (info.stackSize / sizeof(uint32_t));
+    if (rel.sh_link != 0u && readSection(rel.sh_link, symtab) == ELF_OK)
+    {
+        symCount = symtab.sh_size / sizeof(Elf32_Sym);
+    }
 
-    info.progInfo->section_data_dest_addr = info.new_data_ram_addr;
-    info.progInfo->section_data_start_addr = info.new_data_flash_addr;
-    info.progInfo->section_bss_start_addr = info.new_bss_addr;
-    info.progInfo->stackPointer = info.new_msp;
-    info.progInfo->msp_limit = info.new_msplim;
-    info.progInfo->entryPoint = info.new_entry;
-    info.progInfo->vtor_offset = (uint32_t)&binary[program_header->p_offset];
+    uint32_t cachedIndex = 0u;
+    uint32_t cachedS = 0u;
+    uint32_t cachedDS = 0u;
 
-    *vtor_offset = info.progInfo->vtor_offset;
+    for (uint32_t i = 0u; i < count; i++)
+    {
+        if ((i % BATCH) == 0u)
+        {
+            uint32_t batch = (count - i < BATCH) ? (count - i) : BATCH;
+            int status = read(rel.sh_offset + i * sizeof(Elf32_Rel), entries, batch * sizeof(Elf32_Rel));
+            if (status != ELF_OK)
+            {
+                return status;
+            }
+        }
 
-    entry_point = (void (*)(void *))info.progInfo->entryPoint;
+        const Elf32_Rel &entry = entries[i % BATCH];
+        uint32_t type = entry.r_info & 0xFFu;
+        uint32_t symIndex = entry.r_info >> 8u;
 
-    return 0;
+        if (type == R_ARM_NONE || type == R_ARM_V4BX)
+        {
+            continue;
+        }
+
+        uint32_t P = 0u;
+        if (!place(entry.r_offset, P))
+        {
+            return ELF_ERROR_BAD_RELOCATION;
+        }
+        uint32_t dP = P - entry.r_offset;
+
+        // Symbols outside of the module (absolute, peripherals) keep their address
+        uint32_t S = 0u;
+        uint32_t dS = 0u;
+        if (symIndex != 0u)
+        {
+            if (symIndex >= symCount)
+            {
+                return ELF_ERROR_BAD_RELOCATION;
+            }
+
+            // Consecutive relocations often share a symbol
+            if (symIndex != cachedIndex)
+            {
+                int status = resolveSymbol(symtab, symIndex, cachedS, cachedDS);
+                if (status != ELF_OK)
+                {
+                    return status;
+                }
+                cachedIndex = symIndex;
+            }
+
+            S = cachedS;
+            dS = cachedDS;
+        }
+
+        switch (type)
+        {
+            case R_ARM_ABS32:
+            case R_ARM_TARGET1:
+                writeWord(P, readWord(P) + dS);
+                break;
+            case R_ARM_REL32:
+            case R_ARM_BASE_PREL:
+                writeWord(P, readWord(P) + dS - dP);
+                break;
+            case R_ARM_GOTOFF32:
+                writeWord(P, readWord(P) + dS - delta(gotLink));
+                break;
+            case R_ARM_GOT_BREL:
+                // Offset of the entry inside the GOT, the GOT moves with the RAM region
+                break;
+            case R_ARM_RELATIVE:
+            {
+                uint32_t value = readWord(P);
+                writeWord(P, value + delta(value & ~1u));
+                break;
+            }
+            case R_ARM_GLOB_DAT:
+            case R_ARM_JUMP_SLOT:
+                writeWord(P, S + dS);
+                break;
+            case R_ARM_THM_CALL:
+            case R_ARM_THM_JUMP24:
+            {
+                if (dS == dP)
+                {
+                    // Caller and callee moved together
+                    break;
+                }
+
+                uint16_t upper = readHalf(P);
+                uint16_t lower = readHalf(P + 2u);
+                uint32_t sign = (upper >> 10u) & 1u;
+                uint32_t i1 = ~(((lower >> 13u) & 1u) ^ sign) & 1u;
+                uint32_t i2 = ~(((lower >> 11u) & 1u) ^ sign) & 1u;
+                int32_t offset = (int32_t)((sign << 24u) | (i1 << 23u) | (i2 << 22u) |
+                                           ((upper & 0x3FFu) << 12u) | ((lower & 0x7FFu) << 1u));
+                offset = (offset << 7) >> 7;
+                offset += (int32_t)(dS - dP);
+
+                if (offset < -(1 << 24) || offset >= (1 << 24))
+                {
+                    return ELF_ERROR_BAD_RELOCATION;
+                }
+
+                sign = ((uint32_t)offset >> 24u) & 1u;
+                uint32_t j1 = (~((uint32_t)offset >> 23u) ^ sign) & 1u;
+                uint32_t j2 = (~((uint32_t)offset >> 22u) ^ sign) & 1u;
+                upper = (uint16_t)((upper & 0xF800u) | (sign << 10u) | (((uint32_t)offset >> 12u) & 0x3FFu));
+                lower = (uint16_t)((lower & 0xD000u) | (j1 << 13u) | (j2 << 11u) | (((uint32_t)offset >> 1u) & 0x7FFu));
+
+                writeHalf(P, upper);
+                writeHalf(P + 2u, lower);
+                break;
+            }
+            case R_ARM_THM_MOVW_ABS_NC:
+            case R_ARM_THM_MOVT_ABS:
+            {
+                uint16_t upper = readHalf(P);
+                uint16_t lower = readHalf(P + 2u);
+                uint32_t imm = ((upper & 0xFu) << 12u) | (((upper >> 10u) & 1u) << 11u) |
+                               (((lower >> 12u) & 7u) << 8u) | (lower & 0xFFu);
+
+                if (type == R_ARM_THM_MOVW_ABS_NC)
+                {
+                    imm = (imm + dS) & 0xFFFFu;
+                }
+                else
+                {
+                    // Only the upper half is encoded, assume the addend keeps the lower half of S
+                    imm = (((imm << 16u) | (S & 0xFFFFu)) + dS) >> 16u;
+                }
+
+                upper = (uint16_t)((upper & 0xFBF0u) | ((imm >> 12u) & 0xFu) | (((imm >> 11u) & 1u) << 10u));
+                lower = (uint16_t)((lower & 0x8F00u) | (((imm >> 8u) & 7u) << 12u) | (imm & 0xFFu));
+
+                writeHalf(P, upper);
+                writeHalf(P + 2u, lower);
+                break;
+            }
+            default:
+                return ELF_ERROR_UNSUPPORTED_RELOCATION;
+        }
+    }
+
+    return ELF_OK;
 }
 
-//void ElfFile::print_program_headers() const
-//{
-//    for (int i = 0; i < ehdr->e_phnum; ++i)
-//    {
-//        printf("-----------------------------------\n");
-//        printf("-- Program Header %d:\n", i);
-//        printf("* Type: %ld\n", phdr[i].p_type);
-//        printf("* Offset: 0x%lx\n", phdr[i].p_offset);
-//        printf("* Virtual Address: 0x%lx\n", phdr[i].p_vaddr);
-//        printf("* Physical Address: 0x%lx\n", phdr[i].p_paddr);
-//        printf("* File Size: %ld bytes\n", phdr[i].p_filesz);
-//        printf("* Memory Size: %ld bytes\n", phdr[i].p_memsz);
-//        printf("* Flags: %ld\n", phdr[i].p_flags);
-//        printf("* Alignment: %ld\n", phdr[i].p_align);
-//    }
-//    printf("---------------------------------------\n");
-//}
-
-void ElfFile::parse_symbols() const
-{
-    const Elf32_Sym* symtab = nullptr;
-    const char* strtab = nullptr;
-
-    for (int i = 0; i < ehdr->e_shnum; ++i)
-    {
-        if (shdr[i].sh_type == 2)
-        {  // 2 means SHT_SYMTAB (symbol table)
-            symtab = reinterpret_cast<const Elf32_Sym*>(binary + shdr[i].sh_offset);
-            strtab = reinterpret_cast<const char*>(binary + shdr[shdr[i].sh_link].sh_offset);
-            break;
+int ElfFile::resolveSymbol(const Elf32_Shdr &symtab, uint32_t index, uint32_t &S, uint32_t &dS) const
+{
+    static constexpr uint32_t MAX_SYMBOL_NAME = 48u;
+
+    Elf32_Sym sym;
+    int status = read(symtab.sh_offset + index * sizeof(Elf32_Sym), &sym, sizeof(Elf32_Sym));
+    if (status != ELF_OK)
+    {
+        return status;
+    }
+
+    S = 0u;
+    dS = 0u;
+
+    if (sym.st_shndx != SHN_UNDEF)
+    {
+        S = sym.st_value;
+        if (sym.st_shndx != SHN_ABS)
+        {
+            dS = delta(S & ~1u);
         }
+        return ELF_OK;
     }
 
-    if (symtab && strtab) {
-        for (int i = 0; symtab[i].st_name != 0; ++i)
+    // Imported symbol, it is linked at 0 so its address is the whole delta
+    Elf32_Shdr strtab;
+    if (resolver != nullptr && readSection(symtab.sh_link, strtab) == ELF_OK && sym.st_name < strtab.sh_size)
+    {
+        char name[MAX_SYMBOL_NAME];
+        uint32_t length = strtab.sh_size - sym.st_name;
+        if (length > MAX_SYMBOL_NAME - 1u)
+        {
+            length = MAX_SYMBOL_NAME - 1u;
+        }
+
+        status = read(strtab.sh_offset + sym.st_name, name, length);
+        if (status != ELF_OK)
+        {
+            return status;
+        }
+        name[length] = '\0';
+
+        uint32_t address = 0u;
+        if (resolver(name, address))
         {
-            const char* symbol_name = strtab + symtab[i].st_name;
-            if (std::strcmp(symbol_name, "ResetISR") == 0)
+            dS = address;
+            return ELF_OK;
+        }
+    }
+
+    return ((sym.st_info >> 4u) == STB_WEAK) ? ELF_OK : ELF_ERROR_UNDEFINED_SYMBOL;
+}
+
+bool ElfFile::translate(uint32_t linkAddr, uint32_t &loadAddr) const
+{
+    const Region *regions[2] = { &image, &ram };
+
+    // Addresses inside a region first, then one-past-the-end pointers
+    for (uint32_t pass = 0u; pass < 2u; pass++)
+    {
+        for (uint32_t i = 0u; i < 2u; i++)
+        {
+            const Region *region = regions[i];
+            if (region->load == nullptr || linkAddr < region->linkBase)
             {
-//                print_symbol_info(symbol_name, symtab[i].st_value, symtab[i].st_size);
-                break;
+                continue;
+            }
+
+            if (linkAddr < region->linkEnd || (pass == 1u && linkAddr == region->linkEnd))
+            {
+                loadAddr = (uint32_t)(uintptr_t)region->load + (linkAddr - region->linkBase);
+                return true;
             }
         }
     }
+
+    return false;
+}
+
+// Every supported relocation rewrites one word, all of it must lie inside a region
+bool ElfFile::place(uint32_t linkAddr, uint32_t &loadAddr) const
+{
+    const Region *regions[2] = { &image, &ram };
+
+    for (uint32_t i = 0u; i < 2u; i++)
+    {
+        const Region *region = regions[i];
+        if (region->load != nullptr && linkAddr >= region->linkBase && linkAddr < region->linkEnd &&
+            (region->linkEnd - linkAddr) >= sizeof(uint32_t))
+        {
+            loadAddr = (uint32_t)(uintptr_t)region->load + (linkAddr - region->linkBase);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+uint32_t ElfFile::delta(uint32_t linkAddr) const
+{
+    uint32_t loadAddr = 0u;
+
+    if (!translate(linkAddr, loadAddr))
+    {
+        return 0u;
+    }
+
+    return loadAddr - linkAddr;
+}
+
+void ElfFile::release(void)
+{
+    deallocate(image.load);
+    deallocate(ram.load);
+
+    image.load = nullptr;
+    ram.load = nullptr;
+    entry_point = nullptr;
+}
+
+int ElfFile::parse_sections()
+{
+    Elf32_Shdr got;
+
+    // GOT origin, used by GOT-relative relocations
+    gotLink = findSection(".got", got) ? got.sh_addr : 0u;
+
+    return ELF_OK;
+}
+
+// Hash of .gnu.hash, also used for the fallback index
+static uint32_t gnuHash(const char *name)
+{
+    uint32_t hash = 5381u;
+
+    while (*name != '\0')
+    {
+        hash = (hash * 33u) + (uint8_t)(*name++);
+    }
+
+    return hash;
+}
+
+// Hash of the SysV .hash table
+static uint32_t sysvHash(const char *name)
+{
+    uint32_t hash = 0u;
+
+    while (*name != '\0')
+    {
+        hash = (hash << 4u) + (uint8_t)(*name++);
+        uint32_t high = hash & 0xF0000000u;
+        if (high != 0u)
+        {
+            hash ^= high >> 24u;
+        }
+        hash &= ~high;
+    }
+
+    return hash;
 }
 
-//void ElfFile::print_section_info(const char* section_name, uint32_t addr, uint32_t size) const
-//{
-//    printf("%s section:\n", section_name);
-//    printf("Start Address: 0x%lx\n", addr);
-//    printf("Size: %ld bytes\n", size);
-//}
-//
-//void ElfFile::print_symbol_info(const char* symbol_name, uint32_t addr, uint32_t size) const
-//{
-//    printf("%s function:\n", symbol_name);
-//    printf("Address: 0x%lx\n", addr);
-//    printf("Size: %ld bytes\n", size);
-//}
+bool ElfFile::findSection(const char *name, Elf32_Shdr &section)
+{
+    if (name == nullptr || !buildSectionIndex())
+    {
+        return false;
+    }
+
+    uint32_t hash = gnuHash(name);
+    IndexEntry *end = sections.entries + sections.count;
+    IndexEntry *entry = std::lower_bound(sections.entries, end, hash,
+                                         [](const IndexEntry &e, uint32_t h) { return e.hash < h; });
+
+    for (; entry != end && entry->hash == hash; ++entry)
+    {
+        if (readSection(entry->index, section) == ELF_OK && nameEquals(header.e_shstrndx, section.sh_name, name))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
 
-void ElfFile::parse_sections() const
+bool ElfFile::findSymbol(const char *name, Elf32_Sym &symbol)
 {
-    const char* shstrtab = reinterpret_cast<const char*>(binary + shdr[ehdr->e_shstrndx].sh_offset);
+    if (name == nullptr || !buildSectionIndex())
+    {
+        return false;
+    }
 
-    for (int i = 0; i < ehdr->e_shnum; ++i)
+    if (gnuHashSection != 0u)
     {
-        const char* section_name = shstrtab + shdr[i].sh_name;
-        if (std::strcmp(section_name, ".text") == 0 ||
-            std::strcmp(section_name, ".bss") == 0 ||
-            std::strcmp(section_name, ".data") == 0)
+        return lookupGnuHash(name, symbol);
+    }
+    if (hashSection != 0u)
+    {
+        return lookupHash(name, symbol);
+    }
+    if (!buildSymbolIndex())
+    {
+        return false;
+    }
+
+    Elf32_Shdr symtab;
+    if (readSection(symbols.table, symtab) != ELF_OK)
+    {
+        return false;
+    }
+
+    uint32_t hash = gnuHash(name);
+    IndexEntry *end = symbols.entries + symbols.count;
+    IndexEntry *entry = std::lower_bound(symbols.entries, end, hash,
+                                         [](const IndexEntry &e, uint32_t h) { return e.hash < h; });
+
+    for (; entry != end && entry->hash == hash; ++entry)
+    {
+        if (read(symtab.sh_offset + entry->index * sizeof(Elf32_Sym), &symbol, sizeof(Elf32_Sym)) == ELF_OK &&
+            nameEquals(symtab.sh_link, symbol.st_name, name))
         {
-//            print_section_info(section_name, shdr[i].sh_addr, shdr[i].sh_size);
+            return true;
         }
     }
 
-//    printf("Entry Point: 0x%lx\n", ehdr->e_entry);
+    return false;
+}
+
+bool ElfFile::lookupGnuHash(const char *name, Elf32_Sym &symbol) const
+{
+    Elf32_Shdr table;
+    Elf32_Shdr dynsym;
+    uint32_t info[4u]; // nbuckets, symoffset, bloom size, bloom shift
+
+    if (readSection(gnuHashSection, table) != ELF_OK || readSection(table.sh_link, dynsym) != ELF_OK ||
+        read(table.sh_offset, info, sizeof(info)) != ELF_OK || info[0] == 0u || info[2] == 0u)
+    {
+        return false;
+    }
+
+    uint32_t hash = gnuHash(name);
+    uint32_t bloomOffset = table.sh_offset + sizeof(info);
+    uint32_t bucketOffset = bloomOffset + info[2] * sizeof(uint32_t);
+    uint32_t chainOffset = bucketOffset + info[0] * sizeof(uint32_t);
+    uint32_t symCount = dynsym.sh_size / sizeof(Elf32_Sym);
+
+    // Bloom filter rejects most missing names without touching the chains
+    uint32_t bloom = 0u;
+    uint32_t mask = (1u << (hash % 32u)) | (1u << ((hash >> info[3]) % 32u));
+    if (read(bloomOffset + ((hash / 32u) % info[2]) * sizeof(uint32_t), &bloom, sizeof(bloom)) != ELF_OK || (bloom & mask) != mask)
+    {
+        return false;
+    }
+
+    uint32_t index = 0u;
+    if (read(bucketOffset + (hash % info[0]) * sizeof(uint32_t), &index, sizeof(index)) != ELF_OK || index < info[1])
+    {
+        return false;
+    }
 
-    // Read MSP
-    for (int i = 0; i < ehdr->e_phnum; ++i)
+    for (; index < symCount; index++)
     {
-        if (phdr[i].p_type == 1)
+        uint32_t chainHash = 0u;
+        if (read(chainOffset + (index - info[1]) * sizeof(uint32_t), &chainHash, sizeof(chainHash)) != ELF_OK)
+        {
+            return false;
+        }
+
+        if ((chainHash | 1u) == (hash | 1u) &&
+            read(dynsym.sh_offset + index * sizeof(Elf32_Sym), &symbol, sizeof(Elf32_Sym)) == ELF_OK &&
+            nameEquals(dynsym.sh_link, symbol.st_name, name))
+        {
+            return true;
+        }
+
+        // Lowest bit marks the end of the chain
+        if ((chainHash & 1u) != 0u)
         {
-            // 1 means PT_LOAD (loadable segment)
-//            uint32_t msp = *(reinterpret_cast<const uint32_t*>(binary + phdr[i].p_offset));
-//            printf("MSP: 0x%lx\n", msp);
             break;
         }
     }
+
+    return false;
+}
+
+bool ElfFile::lookupHash(const char *name, Elf32_Sym &symbol) const
+{
+    Elf32_Shdr table;
+    Elf32_Shdr dynsym;
+    uint32_t info[2u]; // nbucket, nchain
+
+    if (readSection(hashSection, table) != ELF_OK || readSection(table.sh_link, dynsym) != ELF_OK ||
+        read(table.sh_offset, info, sizeof(info)) != ELF_OK || info[0] == 0u)
+    {
+        return false;
+    }
+
+    uint32_t hash = sysvHash(name);
+    uint32_t bucketOffset = table.sh_offset + sizeof(info);
+    uint32_t chainOffset = bucketOffset + info[0] * sizeof(uint32_t);
+    uint32_t index = 0u;
+
+    if (read(bucketOffset + (hash % info[0]) * sizeof(uint32_t), &index, sizeof(index)) != ELF_OK)
+    {
+        return false;
+    }
+
+    // Bounded walk, a corrupted chain must not loop forever
+    for (uint32_t steps = 0u; index != 0u && index < info[1] && steps < info[1]; steps++)
+    {
+        if (read(dynsym.sh_offset + index * sizeof(Elf32_Sym), &symbol, sizeof(Elf32_Sym)) == ELF_OK &&
+            nameEquals(dynsym.sh_link, symbol.st_name, name))
+        {
+            return true;
+        }
+
+        if (read(chainOffset + index * sizeof(uint32_t), &index, sizeof(index)) != ELF_OK)
+        {
+            return false;
+        }
+    }
+
+    return false;
+}
+
+bool ElfFile::buildSectionIndex(void)
+{
+    if (sections.entries != nullptr)
+    {
+        return true;
+    }
+    if (header.e_shoff == 0u || header.e_shnum == 0u)
+    {
+        return false;
+    }
+
+    sections.entries = (IndexEntry *)allocate(header.e_shnum * sizeof(IndexEntry));
+    if (sections.entries == nullptr)
+    {
+        return false;
+    }
+    sections.count = 0u;
+    sections.table = header.e_shstrndx;
+
+    // One pass over the section headers, also finds the symbol tables
+    for (uint32_t i = 0u; i < header.e_shnum; i++)
+    {
+        Elf32_Shdr section;
+        uint32_t hash = 0u;
+
+        if (readSection(i, section) != ELF_OK)
+        {
+            releaseIndex();
+            return false;
+        }
+
+        if (section.sh_type == SHT_SYMTAB)
+        {
+            symbols.table = i;
+        }
+        else if (section.sh_type == SHT_HASH)
+        {
+            hashSection = i;
+        }
+        else if (section.sh_type == SHT_GNU_HASH)
+        {
+            gnuHashSection = i;
+        }
+
+        if (hashName(header.e_shstrndx, section.sh_name, hash))
+        {
+            sections.entries[sections.count++] = IndexEntry{hash, i};
+        }
+    }
+
+    std::sort(sections.entries, sections.entries + sections.count,
+              [](const IndexEntry &a, const IndexEntry &b) { return a.hash < b.hash; });
+
+    return true;
+}
+
+bool ElfFile::buildSymbolIndex(void)
+{
+    static constexpr uint32_t BATCH = 16u;
+
+    if (symbols.entries != nullptr)
+    {
+        return true;
+    }
+
+    Elf32_Shdr symtab;
+    if (symbols.table == 0u || readSection(symbols.table, symtab) != ELF_OK)
+    {
+        return false;
+    }
+
+    uint32_t symCount = symtab.sh_size / sizeof(Elf32_Sym);
+    if (symCount == 0u)
+    {
+        return false;
+    }
+
+    symbols.entries = (IndexEntry *)allocate(symCount * sizeof(IndexEntry));
+    if (symbols.entries == nullptr)
+    {
+        return false;
+    }
+    symbols.count = 0u;
+
+    Elf32_Sym batch[BATCH];
+    for (uint32_t i = 0u; i < symCount; i++)
+    {
+        if ((i % BATCH) == 0u)
+        {
+            uint32_t length = (symCount - i < BATCH) ? (symCount - i) : BATCH;
+            if (read(symtab.sh_offset + i * sizeof(Elf32_Sym), batch, length * sizeof(Elf32_Sym)) != ELF_OK)
+            {
+                deallocate(symbols.entries);
+                symbols.entries = nullptr;
+                return false;
+            }
+        }
+
+        const Elf32_Sym &sym = batch[i % BATCH];
+        uint32_t hash = 0u;
+
+        // Only definitions can be looked up
+        if (sym.st_name == 0u || sym.st_shndx == SHN_UNDEF || !hashName(symtab.sh_link, sym.st_name, hash))
+        {
+            continue;
+        }
+
+        symbols.entries[symbols.count++] = IndexEntry{hash, i};
+    }
+
+    std::sort(symbols.entries, symbols.entries + symbols.count,
+              [](const IndexEntry &a, const IndexEntry &b) { return a.hash < b.hash; });
+
+    return true;
+}
+
+// Hashes a NUL terminated string of a string table, reading it in small chunks
+bool ElfFile::hashName(uint32_t strtab, uint32_t offset, uint32_t &hash) const
+{
+    static constexpr uint32_t CHUNK = 16u;
+
+    Elf32_Shdr table;
+    if (readSection(strtab, table) != ELF_OK || offset >= table.sh_size)
+    {
+        return false;
+    }
+
+    hash = 5381u;
+    while (offset < table.sh_size)
+    {
+        char chunk[CHUNK];
+        uint32_t length = (table.sh_size - offset < CHUNK) ? (table.sh_size - offset) : CHUNK;
+
+        if (read(table.sh_offset + offset, chunk, length) != ELF_OK)
+        {
+            return false;
+        }
+
+        const char *end = static_cast<const char *>(memchr_optimized(chunk, '\0', length));
+        uint32_t count = (end != nullptr) ? (uint32_t)(end - chunk) : length;
+
+        for (uint32_t i = 0u; i < count; i++)
+        {
+            hash = (hash * 33u) + (uint8_t)chunk[i];
+        }
+        if (end != nullptr)
+        {
+            return true;
+        }
+        offset += length;
+    }
+
+    // Unterminated string
+    return false;
+}
+
+bool ElfFile::nameEquals(uint32_t strtab, uint32_t offset, const char *name) const
+{
+    static constexpr uint32_t CHUNK = 16u;
+
+    Elf32_Shdr table;
+    uint32_t length = strlen_optimized(name) + 1u;
+
+    if (readSection(strtab, table) != ELF_OK || offset >= table.sh_size || table.sh_size - offset < length)
+    {
+        return false;
+    }
+
+    for (uint32_t done = 0u; done < length; done += CHUNK)
+    {
+        char chunk[CHUNK];
+        uint32_t part = (length - done < CHUNK) ? (length - done) : CHUNK;
+
+        if (read(table.sh_offset + offset + done, chunk, part) != ELF_OK || memcmp_optimized(chunk, name + done, part) != 0)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void ElfFile::releaseIndex(void)
+{
+    deallocate(sections.entries);
+    deallocate(symbols.entries);
+
+    sections.entries = nullptr;
+    symbols.entries = nullptr;
+    sections.count = 0u;
+    symbols.count = 0u;
+}
+
+int ElfFile::parse_elf()
+{
+    int status = read(0u, &header, sizeof(Elf32_Ehdr));
+    if (status != ELF_OK)
+    {
+        return status;
+    }
+
+    // Only 32-bit little endian ARM executables
+    if (header.e_ident[0] != 0x7Fu || header.e_ident[1] != 'E' || header.e_ident[2] != 'L' || header.e_ident[3] != 'F' ||
+        header.e_ident[4] != 1u || header.e_ident[5] != 1u ||
+        (header.e_type != ET_EXEC && header.e_type != ET_DYN) || header.e_machine != EM_ARM ||
+        header.e_phentsize != sizeof(Elf32_Phdr) || header.e_phnum == 0u ||
+        (header.e_shnum != 0u && header.e_shentsize != sizeof(Elf32_Shdr)))
+    {
+        return ELF_ERROR_BAD_FORMAT;
+    }
+
+    // Reject before allocating anything for the tables
+    if (!inFile(header.e_phoff, header.e_phnum * sizeof(Elf32_Phdr)) ||
+        (header.e_shnum != 0u && !inFile(header.e_shoff, header.e_shnum * sizeof(Elf32_Shdr))))
+    {
+        return ELF_ERROR_TRUNCATED;
+    }
+
+    phdr = (Elf32_Phdr *)allocate(header.e_phnum * sizeof(Elf32_Phdr));
+    if (phdr == nullptr)
+    {
+        return ELF_ERROR_NO_MEMORY;
+    }
+
+    status = read(header.e_phoff, phdr, header.e_phnum * sizeof(Elf32_Phdr));
+    if (status != ELF_OK)
+    {
+        return status;
+    }
+
+    status = validate();
+    if (status != ELF_OK)
+    {
+        return status;
+    }
+
+    return parse_sections();
+}
+
+// One pass over the program and section headers. Later stages index tables and
+// segments through these headers without checking them again.
+int ElfFile::validate(void) const
+{
+    static constexpr uint32_t BATCH = 8u;
+
+    for (uint32_t i = 0u; i < header.e_phnum; i++)
+    {
+        const Elf32_Phdr &segment = phdr[i];
+        if (segment.p_type != PT_LOAD)
+        {
+            continue;
+        }
+
+        if (segment.p_filesz > segment.p_memsz || segment.p_vaddr > 0xFFFFFFFFu - segment.p_memsz)
+        {
+            return ELF_ERROR_BAD_PROGRAM_HEADER;
+        }
+        if (!inFile(segment.p_offset, segment.p_filesz))
+        {
+            return ELF_ERROR_TRUNCATED;
+        }
+    }
+
+    if (header.e_shnum == 0u)
+    {
+        return (header.e_shoff == 0u) ? ELF_OK : ELF_ERROR_BAD_SECTION_HEADER;
+    }
+    if (header.e_shoff == 0u || header.e_shstrndx >= header.e_shnum)
+    {
+        return ELF_ERROR_BAD_SECTION_HEADER;
+    }
+
+    Elf32_Shdr batch[BATCH];
+    for (uint32_t i = 0u; i < header.e_shnum; i++)
+    {
+        if ((i % BATCH) == 0u)
+        {
+            uint32_t count = (header.e_shnum - i < BATCH) ? (header.e_shnum - i) : BATCH;
+            int status = read(header.e_shoff + i * sizeof(Elf32_Shdr), batch, count * sizeof(Elf32_Shdr));
+            if (status != ELF_OK)
+            {
+                return status;
+            }
+        }
+
+        const Elf32_Shdr &section = batch[i % BATCH];
+
+        if (section.sh_type != SHT_NULL && section.sh_type != SHT_NOBITS && !inFile(section.sh_offset, section.sh_size))
+        {
+            return ELF_ERROR_TRUNCATED;
+        }
+
+        bool valid = true;
+        switch (section.sh_type)
+        {
+            case SHT_SYMTAB:
+            case SHT_DYNSYM:
+                valid = (section.sh_size % sizeof(Elf32_Sym)) == 0u && section.sh_link != 0u && section.sh_link < header.e_shnum;
+                break;
+            case SHT_REL:
+                valid = (section.sh_size % sizeof(Elf32_Rel)) == 0u && section.sh_link < header.e_shnum && section.sh_info < header.e_shnum;
+                break;
+            case SHT_HASH:
+            case SHT_GNU_HASH:
+                valid = section.sh_link != 0u && section.sh_link < header.e_shnum;
+                break;
+            default:
+                break;
+        }
+        if (i == header.e_shstrndx && section.sh_type != SHT_STRTAB)
+        {
+            valid = false;
+        }
+
+        if (!valid)
+        {
+            return ELF_ERROR_BAD_SECTION_HEADER;
+        }
+    }
+
+    return ELF_OK;
+}
+
+void *ElfFile::allocate(uint32_t size) const
+{
+    return (allocateFn != nullptr) ? allocateFn(size) : malloc(size);
+}
+
+void ElfFile::deallocate(void *ptr) const
+{
+    if (deallocateFn != nullptr)
+    {
+        deallocateFn(ptr);
+    }
+    else
+    {
+        free(ptr);
+    }
 }
 
-void ElfFile::parse_elf()
+// A span is inside the file when it does not wrap and, if the size is known, ends within it
+bool ElfFile::inFile(uint32_t offset, uint32_t length) const
 {
-    ehdr = reinterpret_cast<const Elf32_Ehdr*>(binary);
-    phdr = reinterpret_cast<const Elf32_Phdr*>(binary + ehdr->e_phoff);
-    shdr = reinterpret_cast<const Elf32_Shdr*>(binary + ehdr->e_shoff);
+    if (offset > 0xFFFFFFFFu - length)
+    {
+        return false;
+    }
+
+    return (fileSize == 0u) || (offset + length <= fileSize);
+}
+
+int ElfFile::read(uint32_t offset, void *dst, uint32_t length) const
+{
+    if (length == 0u)
+    {
+        return ELF_OK;
+    }
+    if (!inFile(offset, length))
+    {
+        return ELF_ERROR_TRUNCATED;
+    }
+
+    return (reader(readerContext, offset, dst, length) == 0) ? ELF_OK : ELF_ERROR_READ;
+}
+
+int ElfFile::readSection(uint32_t index, Elf32_Shdr &section) const
+{
+    if (index >= header.e_shnum)
+    {
+        return ELF_ERROR_BAD_FORMAT;
+    }
 
-    parse_sections();
-    parse_symbols();
-//    print_program_headers();
+    return read(header.e_shoff + index * sizeof(Elf32_Shdr), &section, sizeof(Elf32_Shdr));
 }
@@ -26,6 +26,61 @@
 #define PT_PHDR    6
 #define PT_TLS     7
 
+#define PF_X       1
+#define PF_W       2
+#define PF_R       4
+
+#define ET_EXEC    2
+#define ET_DYN     3
+#define EM_ARM     40
+
+#define SHT_NULL     0
+#define SHT_SYMTAB   2
+#define SHT_STRTAB   3
+#define SHT_HASH     5
+#define SHT_NOBITS   8
+#define SHT_REL      9
+#define SHT_DYNSYM   11
+#define SHT_GNU_HASH 0x6FFFFFF6
+
+#define SHF_ALLOC  2
+
+#define SHN_UNDEF  0
+#define SHN_ABS    0xFFF1
+
+#define STB_WEAK   2
+
+#define R_ARM_NONE              0
+#define R_ARM_ABS32             2
+#define R_ARM_REL32             3
+#define R_ARM_THM_CALL          10
+#define R_ARM_GLOB_DAT          21
+#define R_ARM_JUMP_SLOT         22
+#define R_ARM_RELATIVE          23
+#define R_ARM_GOTOFF32          24
+#define R_ARM_BASE_PREL         25
+#define R_ARM_GOT_BREL          26
+#define R_ARM_THM_JUMP24        30
+#define R_ARM_TARGET1           38
+#define R_ARM_V4BX              40
+#define R_ARM_THM_MOVW_ABS_NC   47
+#define R_ARM_THM_MOVT_ABS      48
+
+enum ElfStatus : int
+{
+    ELF_OK = 0,
+    ELF_ERROR_BAD_FORMAT = -1,
+    ELF_ERROR_NO_LOAD_SEGMENT = -2,
+    ELF_ERROR_NO_MEMORY = -3,
+    ELF_ERROR_BAD_RELOCATION = -4,
+    ELF_ERROR_UNSUPPORTED_RELOCATION = -5,
+    ELF_ERROR_UNDEFINED_SYMBOL = -6,
+    ELF_ERROR_READ = -7,
+    ELF_ERROR_TRUNCATED = -8,            // Header, table or segment past the end of the file
+    ELF_ERROR_BAD_PROGRAM_HEADER = -9,
+    ELF_ERROR_BAD_SECTION_HEADER = -10
+};
+
 struct Elf32_Ehdr {
     uint8_t e_ident[16];
     uint16_t e_type;
@@ -105,35 +160,137 @@ struct Elf32_Sym {
     uint16_t st_shndx;
 };
 
+// Relocation entry without explicit addend, ARM uses REL only
+struct Elf32_Rel {
+    uint32_t r_offset;
+    uint32_t r_info;
+};
+
+// Reads length bytes at offset of the ELF file into dst, returns 0 on success
+typedef int (*ElfReader)(void *context, uint32_t offset, void *dst, uint32_t length);
+
+// Memory for the loaded regions and the program headers, malloc/free by default
+typedef void *(*ElfAllocate)(uint32_t size);
+typedef void (*ElfDeallocate)(void *ptr);
+
+// Provides the address of a symbol the module leaves undefined, false when unknown
+typedef bool (*ElfResolver)(const char *name, uint32_t &address);
+
+// Loads an ARM ELF module into freshly allocated memory.
+// Read-only PT_LOAD segments (code, rodata, ProgramInfo) form the image region and
+// writable ones (.data, .bss) plus the module stack form the RAM region. Each region
+// is moved as a whole and SHT_REL sections are applied against the new addresses,
+// so both PIE modules and executables linked with --emit-relocs can be loaded.
+// The file is pulled through an ElfReader, only the ELF header and the program
+// headers are buffered, segments are read straight into their destination.
+// All headers are validated in one pass before anything is allocated for the
+// module; with a known file size no read can leave the file.
 class ElfFile {
 public:
-    ElfFile() : entry_point(nullptr) {}
+    ElfFile() : entry_point(nullptr), reader(nullptr), readerContext(nullptr), allocateFn(nullptr), deallocateFn(nullptr), resolver(nullptr), fileSize(0u), phdr(nullptr),
+                image{0u, 0u, nullptr}, ram{0u, 0u, nullptr},
+                stackLinkBase(0u), stackLinkTop(0u), gotLink(0u),
+                sections{nullptr, 0u, 0u}, symbols{nullptr, 0u, 0u}, hashSection(0u), gnuHashSection(0u) {}
+    ~ElfFile();
+    ElfFile(const ElfFile &) = delete;
+    ElfFile &operator=(const ElfFile &) = delete;
+    // ELF file already in memory. Reads are bounded only by setFileSize, leave it
+    // unset for trusted files only.
     int parse(const uint8_t *buffer);
     int parse(const uint8_t *elf, uint32_t **stack, uint32_t *stackSize, uint32_t *vtor_offset);
+    int parse(ElfReader elfReader, void *context, uint32_t **stack, uint32_t *stackSize, uint32_t *vtor_offset);
+
+    // Must be set before parse, the caller owns the loaded regions afterwards
+    void setAllocator(ElfAllocate allocate, ElfDeallocate deallocate);
+    // Without a resolver only weak symbols may stay undefined
+    void setResolver(ElfResolver symbolResolver);
+    // Size of the ELF file, 0 when unknown. Must be set before parse.
+    void setFileSize(uint32_t size);
+    uint8_t *getImage(void) const;
+    uint8_t *getRam(void) const;
+
+    // Lookup by name while the ELF file is still readable. Symbols are found through
+    // .gnu.hash or .hash when the module has them, otherwise through a sorted hash
+    // index of .symtab built on first use with the allocator.
+    bool findSymbol(const char *name, Elf32_Sym &symbol);
+    bool findSection(const char *name, Elf32_Shdr &section);
+
+    // Total memory used by the loaded module (image + RAM region)
     uint32_t getMemSize(void);
+    uint32_t getImageSize(void);
+    uint32_t getRamSize(void);
 
     void (*entry_point)(void *);
 
 private:
-    uint8_t *binary;
-    Elf32_Ehdr *header;
-    Elf32_Phdr *program_header;
+    struct Region
+    {
+        uint32_t linkBase;
+        uint32_t linkEnd;
+        uint8_t *load;
+    };
+
+    struct IndexEntry
+    {
+        uint32_t hash;
+        uint32_t index;
+    };
+
+    struct Index
+    {
+        IndexEntry *entries;
+        uint32_t count;
+        uint32_t table; // Section holding the indexed entries
+    };
+
+    ElfReader reader;
+    void *readerContext;
+    ElfAllocate allocateFn;
+    ElfDeallocate deallocateFn;
+    ElfResolver resolver;
+    uint32_t fileSize;
 
-    const Elf32_Ehdr* ehdr;
-    const Elf32_Phdr* phdr;
-    const Elf32_Shdr* shdr;
+    Elf32_Ehdr header;
+    Elf32_Phdr *phdr;
 
-//    void print_program_headers() const;
+    Region image;
+    Region ram;
+    uint32_t stackLinkBase;
+    uint32_t stackLinkTop;
+    uint32_t gotLink;
 
-//    void print_section_info(const char* section_name, uint32_t addr, uint32_t size) const;
+    Index sections;
+    Index symbols;
+    uint32_t hashSection;
+    uint32_t gnuHashSection;
 
-//    void print_symbol_info(const char* symbol_name, uint32_t addr, uint32_t size) const;
+    void *allocate(uint32_t size) const;
+    void deallocate(void *ptr) const;
+    int read(uint32_t offset, void *dst, uint32_t length) const;
+    int readSection(uint32_t index, Elf32_Shdr &section) const;
+    bool inFile(uint32_t offset, uint32_t length) const;
+    int validate(void) const;
 
-    void parse_symbols() const;
+    int parse_sections();
 
-    void parse_sections() const;
+    int parse_elf();
 
-    void parse_elf();
+    int load(void);
+    int layout(void);
+    int relocate(void);
+    int relocateSection(const Elf32_Shdr &rel);
+    int resolveSymbol(const Elf32_Shdr &symtab, uint32_t index, uint32_t &S, uint32_t &dS) const;
+    bool buildSectionIndex(void);
+    bool buildSymbolIndex(void);
+    bool hashName(uint32_t strtab, uint32_t offset, uint32_t &hash) const;
+    bool nameEquals(uint32_t strtab, uint32_t offset, const char *name) const;
+    bool lookupHash(const char *name, Elf32_Sym &symbol) const;
+    bool lookupGnuHash(const char *name, Elf32_Sym &symbol) const;
+    void releaseIndex(void);
+    bool translate(uint32_t linkAddr, uint32_t &loadAddr) const;
+    bool place(uint32_t linkAddr, uint32_t &loadAddr) const;
+    uint32_t delta(uint32_t linkAddr) const;
+    void release(void);
 };
 
 
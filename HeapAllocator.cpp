@@ -13,14 +13,21 @@
  */
 
 #include <HeapAllocator.hpp>
+#include <MemoryOps.hpp>
 #include <cstdint>
 #include <cstdio>
+#include <cstring>
 #include <cassert>
 
 static constexpr uint32_t MARKER = 0xDEADBEEFul;
 
 HeapAllocator::HeapAllocator() : head(nullptr), tail(nullptr),
-                                 mPool(nullptr), mPoolSize(0u)
+                                 mPool(nullptr), mPoolSize(0u),
+                                 mHandles(nullptr), mMovableCount(0u), mNeedsCompaction(false)
+#if HEAP_ALLOCATOR_TRACE
+                                 , mTrace(nullptr), mTraceCapacity(0u), mTraceWritten(0u), mTraceEnabled(false),
+                                 mTraceClock(nullptr), mTraceContext(nullptr)
+#endif
 {
 }
 
@@ -29,6 +36,7 @@ void HeapAllocator::init(void *memoryPool, uint32_t totalSize)
     head = (Block *)memoryPool;
     head->size = totalSize - sizeof(Block) - 2 * sizeof(uint32_t);
     head->free = true;
+    head->handle = INVALID_HANDLE;
     head->prev = nullptr;
     head->next = nullptr;
     head->startMarker = MARKER;
@@ -37,9 +45,38 @@ void HeapAllocator::init(void *memoryPool, uint32_t totalSize)
     mPool = memoryPool;
     mPoolSize = totalSize;
     tail = head;
+
+    mHandles = nullptr;
+    mMovableCount = 0u;
+    mNeedsCompaction = false;
+}
+
+uint32_t HeapAllocator::getMinimumPoolSize(void)
+{
+    return sizeof(Block) + 2 * sizeof(uint32_t);
 }
 
 void* HeapAllocator::allocate(uint32_t size)
+{
+    void *ptr = allocateBlock(size);
+
+    if (ptr == nullptr && size != 0u && mMovableCount != 0u && HEAP_ALLOCATOR_ALLOCATE_MOVES != 0u)
+    {
+        // Free space may be scattered between movable blocks, merge some of it and retry
+        if (compact(HEAP_ALLOCATOR_ALLOCATE_MOVES) != 0u)
+        {
+            ptr = allocateBlock(size);
+        }
+    }
+
+#if HEAP_ALLOCATOR_TRACE
+    trace(TraceOp::TRACE_ALLOCATE, size, ptr);
+#endif
+
+    return ptr;
+}
+
+void* HeapAllocator::allocateBlock(uint32_t size)
 {
     if (size == 0)
     {
@@ -62,6 +99,7 @@ void* HeapAllocator::allocate(uint32_t size)
                     split(forward, size);
                 }
                 forward->free = false;
+                forward->handle = INVALID_HANDLE;
                 return (void*)((char*)forward + sizeof(Block) + sizeof(uint32_t));
             }
             forward = forward->next;
@@ -76,6 +114,7 @@ void* HeapAllocator::allocate(uint32_t size)
                     split(backward, size);
                 }
                 backward->free = false;
+                backward->handle = INVALID_HANDLE;
                 return (void*)((char*)backward + sizeof(Block) + sizeof(uint32_t));
             }
             backward = backward->prev;
@@ -99,6 +138,24 @@ void HeapAllocator::deallocate(void *ptr)
         assert(false && "Memory corruption detected\r\n");
         return;
     }
+
+#if HEAP_ALLOCATOR_TRACE
+    trace(TraceOp::TRACE_DEALLOCATE, block->size, ptr);
+#endif
+
+    if (block->handle != INVALID_HANDLE)
+    {
+        mHandles[block->handle - 1u].ptr = nullptr;
+        mHandles[block->handle - 1u].locks = 0u;
+        block->handle = INVALID_HANDLE;
+        mMovableCount--;
+    }
+
+    if (mMovableCount != 0u)
+    {
+        mNeedsCompaction = true;
+    }
+
     block->free = true;
 
     if (block->prev && block->prev->free)
@@ -170,6 +227,220 @@ uint32_t HeapAllocator::getAllocatedMemory() const
     return allocatedMemory;
 }
 
+uint32_t HeapAllocator::getLargestFreeBlock() const
+{
+    uint32_t largest = 0u;
+    Block *current = head;
+
+    while (current)
+    {
+        if (current->free && current->size > largest)
+        {
+            largest = current->size;
+        }
+        current = current->next;
+    }
+    return largest;
+}
+
+bool HeapAllocator::owns(const void *ptr) const
+{
+    return (mPool != nullptr) && ((const char *)ptr >= (const char *)mPool) &&
+           ((const char *)ptr < (const char *)mPool + mPoolSize);
+}
+
+HeapAllocator::Handle HeapAllocator::allocateMovable(uint32_t size)
+{
+    if (mHandles == nullptr)
+    {
+        mHandles = (HandleEntry *)allocate(HEAP_ALLOCATOR_MAX_HANDLES * sizeof(HandleEntry));
+        if (mHandles == nullptr)
+        {
+            return INVALID_HANDLE;
+        }
+        memset(mHandles, 0, HEAP_ALLOCATOR_MAX_HANDLES * sizeof(HandleEntry));
+    }
+
+    uint32_t slot = 0u;
+    while (slot < HEAP_ALLOCATOR_MAX_HANDLES && mHandles[slot].ptr != nullptr)
+    {
+        slot++;
+    }
+    if (slot == HEAP_ALLOCATOR_MAX_HANDLES)
+    {
+        return INVALID_HANDLE;
+    }
+
+    void *ptr = allocate(size);
+    if (ptr == nullptr)
+    {
+        return INVALID_HANDLE;
+    }
+
+    Block *block = (Block *)((char *)ptr - sizeof(Block) - sizeof(uint32_t));
+    block->handle = (Handle)(slot + 1u);
+
+    mHandles[slot].ptr = ptr;
+    mHandles[slot].locks = 0u;
+    mMovableCount++;
+
+    return block->handle;
+}
+
+bool HeapAllocator::deallocateMovable(Handle handle)
+{
+    if (handle == INVALID_HANDLE || handle > HEAP_ALLOCATOR_MAX_HANDLES || mHandles == nullptr)
+    {
+        return false;
+    }
+
+    // Whoever locked it still uses the memory
+    HandleEntry *entry = &mHandles[handle - 1u];
+    if (entry->ptr == nullptr || entry->locks != 0u)
+    {
+        return false;
+    }
+
+    deallocate(entry->ptr);
+    return true;
+}
+
+void* HeapAllocator::lock(Handle handle)
+{
+    if (handle == INVALID_HANDLE || handle > HEAP_ALLOCATOR_MAX_HANDLES || mHandles == nullptr)
+    {
+        return nullptr;
+    }
+
+    HandleEntry *entry = &mHandles[handle - 1u];
+    if (entry->ptr != nullptr)
+    {
+        entry->locks++;
+    }
+
+    return entry->ptr;
+}
+
+void HeapAllocator::unlock(Handle handle)
+{
+    if (handle == INVALID_HANDLE || handle > HEAP_ALLOCATOR_MAX_HANDLES || mHandles == nullptr)
+    {
+        return;
+    }
+
+    HandleEntry *entry = &mHandles[handle - 1u];
+    if (entry->locks != 0u)
+    {
+        entry->locks--;
+    }
+}
+
+bool HeapAllocator::isLocked(Handle handle) const
+{
+    if (handle == INVALID_HANDLE || handle > HEAP_ALLOCATOR_MAX_HANDLES || mHandles == nullptr)
+    {
+        return false;
+    }
+
+    return mHandles[handle - 1u].locks != 0u;
+}
+
+uint32_t HeapAllocator::compact(uint32_t maxMoves)
+{
+    uint32_t moves = 0u;
+    Block *block = head;
+
+    if (mMovableCount == 0u)
+    {
+        mNeedsCompaction = false;
+        return 0u;
+    }
+
+    while (block && moves < maxMoves)
+    {
+        Block *next = block->next;
+
+        if (block->free && next && !next->free && next->handle != INVALID_HANDLE &&
+            mHandles[next->handle - 1u].locks == 0u)
+        {
+            // Continue from the free block left behind the moved one
+            block = slide(block, next);
+            moves++;
+            continue;
+        }
+
+        block = next;
+    }
+
+    if (block == nullptr)
+    {
+        mNeedsCompaction = false;
+    }
+
+    return moves;
+}
+
+bool HeapAllocator::needsCompaction() const
+{
+    return mNeedsCompaction;
+}
+
+#if HEAP_ALLOCATOR_TRACE
+void HeapAllocator::enableTrace(TraceRecord *buffer, uint32_t capacity, TraceClock clock, TraceContext context)
+{
+    mTraceCapacity = capacity;
+    mTraceWritten = 0u;
+    mTraceClock = clock;
+    mTraceContext = context;
+    mTrace = (capacity != 0u) ? buffer : nullptr;
+    mTraceEnabled = (mTrace != nullptr);
+}
+
+void HeapAllocator::disableTrace(void)
+{
+    mTraceEnabled = false;
+}
+
+uint32_t HeapAllocator::getTraceCount(void) const
+{
+    return mTraceWritten;
+}
+
+const HeapAllocator::TraceRecord* HeapAllocator::getTraceRecord(uint32_t index) const
+{
+    if (mTrace == nullptr || mTraceCapacity == 0u)
+    {
+        return nullptr;
+    }
+
+    uint32_t retained = (mTraceWritten < mTraceCapacity) ? mTraceWritten : mTraceCapacity;
+    if (index >= retained)
+    {
+        return nullptr;
+    }
+
+    uint32_t oldest = mTraceWritten - retained;
+    return &mTrace[(oldest + index) % mTraceCapacity];
+}
+
+void HeapAllocator::trace(TraceOp op, uint32_t size, void *ptr)
+{
+    if (!mTraceEnabled)
+    {
+        return;
+    }
+
+    TraceRecord *record = &mTrace[mTraceWritten % mTraceCapacity];
+    record->cycles = mTraceClock ? mTraceClock() : 0u;
+    record->size = size;
+    record->ptr = (uintptr_t)ptr;
+    record->task = mTraceContext ? (uintptr_t)mTraceContext() : 0u;
+    record->op = op;
+
+    mTraceWritten++;
+}
+#endif
+
 uint32_t HeapAllocator::align8(uint32_t size)
 {
     return (size + 7) & ~7;
@@ -180,6 +451,7 @@ void HeapAllocator::split(Block *block, uint32_t size)
     Block *newBlock = (Block *)((char *)block + sizeof(Block) + size + 2 * sizeof(uint32_t));
     newBlock->size = block->size - size - sizeof(Block) - 2 * sizeof(uint32_t);
     newBlock->free = true;
+    newBlock->handle = INVALID_HANDLE;
     newBlock->prev = block;
     newBlock->next = block->next;
     newBlock->startMarker = MARKER;
@@ -233,3 +505,45 @@ void HeapAllocator::join(Block *block)
     }
 }
 
+HeapAllocator::Block* HeapAllocator::slide(Block *freeBlock, Block *block)
+{
+    // Read the header first, the data move below may overwrite it
+    uint32_t freeSize = freeBlock->size;
+    uint32_t size = block->size;
+    Handle handle = block->handle;
+    Block *next = block->next;
+
+    char *src = (char *)block + sizeof(Block) + sizeof(uint32_t);
+    char *dst = (char *)freeBlock + sizeof(Block) + sizeof(uint32_t);
+    memmove_optimized(dst, src, size);
+
+    freeBlock->size = size;
+    freeBlock->free = false;
+    freeBlock->handle = handle;
+    freeBlock->endMarker = MARKER;
+
+    Block *newBlock = (Block *)((char *)freeBlock + sizeof(Block) + size + 2 * sizeof(uint32_t));
+    newBlock->startMarker = MARKER;
+    newBlock->size = freeSize;
+    newBlock->free = true;
+    newBlock->handle = INVALID_HANDLE;
+    newBlock->prev = freeBlock;
+    newBlock->next = next;
+    newBlock->endMarker = MARKER;
+
+    freeBlock->next = newBlock;
+    if (next)
+    {
+        next->prev = newBlock;
+    }
+    else
+    {
+        tail = newBlock;
+    }
+
+    mHandles[handle - 1u].ptr = dst;
+
+    join(newBlock);
+
+    return newBlock;
+}
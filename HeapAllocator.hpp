@@ -17,18 +17,85 @@
 
 #include <cstdint>
 
+// Set to 1 to record every allocate/deallocate into a user supplied ring buffer
+#ifndef HEAP_ALLOCATOR_TRACE
+#define HEAP_ALLOCATOR_TRACE 0
+#endif
+
+// Number of handles available for movable allocations
+#ifndef HEAP_ALLOCATOR_MAX_HANDLES
+#define HEAP_ALLOCATOR_MAX_HANDLES 16u
+#endif
+
+// Blocks allocate() may move to satisfy a request that found no fit. Each move copies
+// one movable block, so this bounds the extra latency of a failed allocation. 0 makes
+// allocate() fail at once and leaves compaction to explicit compact() calls.
+#ifndef HEAP_ALLOCATOR_ALLOCATE_MOVES
+#define HEAP_ALLOCATOR_ALLOCATE_MOVES 2u
+#endif
+
 class HeapAllocator
 {
     public:
+        enum class TraceOp : uint8_t
+        {
+            TRACE_ALLOCATE = 0u,
+            TRACE_DEALLOCATE
+        };
+
+        struct TraceRecord
+        {
+            uint32_t cycles;   // Timestamp taken from the trace clock
+            uint32_t size;     // Requested size (allocate) or block size (deallocate)
+            uintptr_t ptr;     // Returned or released pointer, 0 for a failed allocation
+            uintptr_t task;    // Caller context, e.g. current TCB
+            TraceOp op;
+        };
+
+        // Movable allocations are referenced through handles, 0 is never a valid handle
+        typedef uint16_t Handle;
+        static constexpr Handle INVALID_HANDLE = 0u;
+
+        typedef uint32_t (*TraceClock)(void);
+        typedef void* (*TraceContext)(void);
+
         HeapAllocator();
 
         void init(void *memoryPool, uint32_t totalSize);
+        // Smallest totalSize init accepts, the header of the first free block
+        static uint32_t getMinimumPoolSize(void);
         void* allocate(uint32_t size);
         void deallocate(void *ptr);
         void getMemoryPool(void **memoryPool, uint32_t &totalSize);
 
         uint32_t getFreeMemory() const;
         uint32_t getAllocatedMemory() const;
+        uint32_t getLargestFreeBlock() const;
+        bool owns(const void *ptr) const;
+
+        // Movable allocations may be relocated by compact() while they are not locked
+        Handle allocateMovable(uint32_t size);
+        // Refuses, returning false, while the allocation is locked or the handle is unknown
+        bool deallocateMovable(Handle handle);
+        void* lock(Handle handle);
+        void unlock(Handle handle);
+        bool isLocked(Handle handle) const;
+
+        // Slides unlocked movable blocks towards the pool start to merge free space.
+        // Stops after maxMoves relocations, returns the number of moved blocks.
+        uint32_t compact(uint32_t maxMoves = 0xFFFFFFFFu);
+        bool needsCompaction() const;
+
+#if HEAP_ALLOCATOR_TRACE
+        void enableTrace(TraceRecord *buffer, uint32_t capacity, TraceClock clock, TraceContext context);
+        // Stops recording, the records written so far stay readable until enableTrace
+        void disableTrace(void);
+
+        // Total number of records written since enableTrace, may exceed capacity
+        uint32_t getTraceCount(void) const;
+        // Retained records, index 0 is the oldest one still in the ring buffer
+        const TraceRecord* getTraceRecord(uint32_t index) const;
+#endif
 
     private:
         struct Block
@@ -36,19 +103,44 @@ class HeapAllocator
         	uint32_t startMarker;
             uint32_t size;
             bool free;
+            uint8_t reserved;
+            Handle handle;
             Block *prev;
             Block *next;
             uint32_t endMarker;
         };
 
+        struct HandleEntry
+        {
+            void *ptr;
+            uint16_t locks;
+        };
+
         Block *head;
         Block *tail;
         void *mPool;
         uint32_t mPoolSize;
 
+        HandleEntry *mHandles;
+        uint32_t mMovableCount;
+        bool mNeedsCompaction;
+
+#if HEAP_ALLOCATOR_TRACE
+        TraceRecord *mTrace;
+        uint32_t mTraceCapacity;
+        uint32_t mTraceWritten;
+        bool mTraceEnabled;
+        TraceClock mTraceClock;
+        TraceContext mTraceContext;
+
+        void trace(TraceOp op, uint32_t size, void *ptr);
+#endif
+
+        void* allocateBlock(uint32_t size);
         uint32_t align8(uint32_t size);
         void split(Block *block, uint32_t size);
         void join(Block *block);
+        Block* slide(Block *freeBlock, Block *block);
 };
 
 #endif /* HEAPALLOCATOR_HPP */
@@ -0,0 +1,242 @@
+/*
+ * Lz4
+ * Author: Arkadiusz Szlanta
+ * Date: 17 Oct 2026
+ *
+ * License:
+ * This source code is provided for hobbyist and private use only.
+ * Any commercial or industrial use, including distribution, reproduction, or
+ * incorporation in commercial or industrial products or services is prohibited.
+ * Use at your own risk. The author(s) hold no responsibility for any damages
+ * or losses resulting from the use of this software.
+ *
+ */
+
+#include <Lz4.hpp>
+
+#include <cstring>
+
+namespace
+{
+    static constexpr uint32_t MIN_MATCH = 4u;
+
+    // Compressed stream pulled through a small window
+    class Input
+    {
+        public:
+            Input(Lz4Reader reader, void *context, uint32_t offset, uint32_t size)
+                : mReader(reader), mContext(context), mOffset(offset), mRemaining(size), mPos(0u), mLen(0u) {}
+
+            bool empty(void) const
+            {
+                return (mPos == mLen) && (mRemaining == 0u);
+            }
+
+            int byte(uint8_t &value)
+            {
+                if (mPos == mLen)
+                {
+                    int status = refill();
+                    if (status != LZ4_OK)
+                    {
+                        return status;
+                    }
+                }
+
+                value = mWindow[mPos++];
+                return LZ4_OK;
+            }
+
+            // Length extension: 255 continues, any other byte ends it
+            int length(uint32_t &value)
+            {
+                uint8_t part = 255u;
+                while (part == 255u)
+                {
+                    int status = byte(part);
+                    if (status != LZ4_OK)
+                    {
+                        return status;
+                    }
+                    if (value > 0xFFFFFFFFu - part)
+                    {
+                        return LZ4_ERROR_BAD_FORMAT;
+                    }
+                    value += part;
+                }
+
+                return LZ4_OK;
+            }
+
+            int copy(uint8_t *dst, uint32_t length)
+            {
+                uint32_t buffered = mLen - mPos;
+                uint32_t part = (length < buffered) ? length : buffered;
+
+                if (part != 0u)
+                {
+                    std::memcpy(dst, &mWindow[mPos], part);
+                }
+                mPos += part;
+                dst += part;
+                length -= part;
+
+                if (length == 0u)
+                {
+                    return LZ4_OK;
+                }
+                if (length > mRemaining)
+                {
+                    return LZ4_ERROR_BAD_FORMAT;
+                }
+
+                // Window is drained, the rest of the run goes straight to its place
+                if (mReader(mContext, mOffset, dst, length) != 0)
+                {
+                    return LZ4_ERROR_READ;
+                }
+                mOffset += length;
+                mRemaining -= length;
+
+                return LZ4_OK;
+            }
+
+        private:
+            int refill(void)
+            {
+                if (mRemaining == 0u)
+                {
+                    return LZ4_ERROR_BAD_FORMAT;
+                }
+
+                mLen = (mRemaining < LZ4_INPUT_WINDOW) ? mRemaining : LZ4_INPUT_WINDOW;
+                mPos = 0u;
+                if (mReader(mContext, mOffset, mWindow, mLen) != 0)
+                {
+                    mLen = 0u;
+                    return LZ4_ERROR_READ;
+                }
+                mOffset += mLen;
+                mRemaining -= mLen;
+
+                return LZ4_OK;
+            }
+
+            Lz4Reader mReader;
+            void *mContext;
+            uint32_t mOffset;
+            uint32_t mRemaining;
+            uint32_t mPos;
+            uint32_t mLen;
+            uint8_t mWindow[LZ4_INPUT_WINDOW];
+    };
+
+    // Match source may overlap the destination, short distances repeat a pattern
+    void copyMatch(uint8_t *dst, uint32_t distance, uint32_t length)
+    {
+        const uint8_t *src = dst - distance;
+
+        if (distance >= sizeof(uint32_t))
+        {
+            while (length >= sizeof(uint32_t))
+            {
+                uint32_t word;
+                std::memcpy(&word, src, sizeof(uint32_t));
+                std::memcpy(dst, &word, sizeof(uint32_t));
+                src += sizeof(uint32_t);
+                dst += sizeof(uint32_t);
+                length -= sizeof(uint32_t);
+            }
+        }
+
+        while (length-- > 0u)
+        {
+            *dst++ = *src++;
+        }
+    }
+}
+
+int Lz4::Decode(Lz4Reader reader, void *context, uint32_t offset, uint32_t packedSize,
+                uint8_t *dst, uint32_t dstSize, uint32_t &produced)
+{
+    produced = 0u;
+
+    if (reader == nullptr || (dst == nullptr && dstSize != 0u))
+    {
+        return LZ4_ERROR_BAD_FORMAT;
+    }
+
+    Input input(reader, context, offset, packedSize);
+    uint32_t out = 0u;
+
+    while (!input.empty())
+    {
+        uint8_t token = 0u;
+        int status = input.byte(token);
+        if (status != LZ4_OK)
+        {
+            return status;
+        }
+
+        uint32_t literals = token >> 4u;
+        if (literals == 15u)
+        {
+            status = input.length(literals);
+            if (status != LZ4_OK)
+            {
+                return status;
+            }
+        }
+        if (literals > dstSize - out)
+        {
+            return LZ4_ERROR_OVERFLOW;
+        }
+
+        status = input.copy(dst + out, literals);
+        if (status != LZ4_OK)
+        {
+            return status;
+        }
+        out += literals;
+
+        // The last sequence carries literals only
+        if (input.empty())
+        {
+            break;
+        }
+
+        uint8_t low = 0u;
+        uint8_t high = 0u;
+        if ((status = input.byte(low)) != LZ4_OK || (status = input.byte(high)) != LZ4_OK)
+        {
+            return status;
+        }
+
+        uint32_t distance = (uint32_t)low | ((uint32_t)high << 8u);
+        if (distance == 0u || distance > out)
+        {
+            return LZ4_ERROR_BAD_FORMAT;
+        }
+
+        uint32_t length = token & 0x0Fu;
+        if (length == 15u)
+        {
+            status = input.length(length);
+            if (status != LZ4_OK)
+            {
+                return status;
+            }
+        }
+        if ((dstSize - out) < MIN_MATCH || length > (dstSize - out - MIN_MATCH))
+        {
+            return LZ4_ERROR_OVERFLOW;
+        }
+        length += MIN_MATCH;
+
+        copyMatch(dst + out, distance, length);
+        out += length;
+    }
+
+    produced = out;
+    return LZ4_OK;
+}
@@ -0,0 +1,45 @@
+/*
+ * Lz4
+ * Author: Arkadiusz Szlanta
+ * Date: 17 Oct 2026
+ *
+ * License:
+ * This source code is provided for hobbyist and private use only.
+ * Any commercial or industrial use, including distribution, reproduction, or
+ * incorporation in commercial or industrial products or services is prohibited.
+ * Use at your own risk. The author(s) hold no responsibility for any damages
+ * or losses resulting from the use of this software.
+ *
+ */
+
+#ifndef LZ4_HPP
+#define LZ4_HPP
+
+#include <cstdint>
+
+// Size of the input window, the only buffer used by the decoder
+#ifndef LZ4_INPUT_WINDOW
+#define LZ4_INPUT_WINDOW 64u
+#endif
+
+enum Lz4Status : int
+{
+    LZ4_OK = 0,
+    LZ4_ERROR_READ = -1,
+    LZ4_ERROR_BAD_FORMAT = -2,
+    LZ4_ERROR_OVERFLOW = -3
+};
+
+// Same contract as ElfReader, returns 0 on success
+typedef int (*Lz4Reader)(void *context, uint32_t offset, void *dst, uint32_t length);
+
+namespace Lz4
+{
+    // Decodes one LZ4 block (no frame header) of packedSize bytes found at offset.
+    // Matches are copied from the already decoded output, so dst is the only
+    // full-size buffer; long literal runs are read straight into dst.
+    int Decode(Lz4Reader reader, void *context, uint32_t offset, uint32_t packedSize,
+               uint8_t *dst, uint32_t dstSize, uint32_t &produced);
+}
+
+#endif /* LZ4_HPP */
@@ -0,0 +1,319 @@
+/*
+ * MemoryOps
+ * Author: Arkadiusz Szlanta
+ * Date: 17 Oct 2026
+ *
+ * License:
+ * This source code is provided for hobbyist and private use only.
+ * Any commercial or industrial use, including distribution, reproduction, or
+ * incorporation in commercial or industrial products or services is prohibited.
+ * Use at your own risk. The author(s) hold no responsibility for any damages
+ * or losses resulting from the use of this software.
+ *
+ */
+
+// Portable reference of the assembly memory routines, built only where memcpy.s,
+// memset.s and string.s are not. It follows the same strategy: align the destination,
+// then whole words, then the remaining bytes.
+
+#include <MemoryOps.hpp>
+
+#include <cstring>
+
+#if !defined(__arm__)
+
+// strlen and strcmp load the whole word holding the terminator. That never faults, an
+// aligned word does not cross a page, but AddressSanitizer reports the bytes past the
+// string, so sanitized builds scan strings byte by byte.
+#if defined(__SANITIZE_ADDRESS__)
+#define STRING_WORD_SCAN 0
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define STRING_WORD_SCAN 0
+#endif
+#endif
+#ifndef STRING_WORD_SCAN
+#define STRING_WORD_SCAN 1
+#endif
+
+namespace
+{
+    inline uint32_t loadWord(const uint8_t *src)
+    {
+        uint32_t word;
+        std::memcpy(&word, src, sizeof(word));
+        return word;
+    }
+
+    inline void storeWord(uint8_t *dst, uint32_t word)
+    {
+        std::memcpy(dst, &word, sizeof(word));
+    }
+
+    // 0x80 in every byte of a little-endian word that is zero. Bytes above the first
+    // zero one may be flagged as well, the lowest flag is always exact.
+    inline uint32_t zeroBytes(uint32_t word)
+    {
+        return (word - 0x01010101u) & ~word & 0x80808080u;
+    }
+
+    // Index in memory order of the lowest flagged byte
+    inline uint32_t firstByte(uint32_t flags)
+    {
+        return (uint32_t)__builtin_ctz(flags) / 8u;
+    }
+}
+
+extern "C" void *memcpy_optimized(void *dst, const void *src, uint32_t len)
+{
+    uint8_t *d = static_cast<uint8_t *>(dst);
+    const uint8_t *s = static_cast<const uint8_t *>(src);
+
+    if (len >= 8u)
+    {
+        while (((uintptr_t)d & 3u) != 0u)
+        {
+            *d++ = *s++;
+            len--;
+        }
+
+        while (len >= sizeof(uint32_t))
+        {
+            storeWord(d, loadWord(s));
+            d += sizeof(uint32_t);
+            s += sizeof(uint32_t);
+            len -= sizeof(uint32_t);
+        }
+    }
+
+    while (len-- > 0u)
+    {
+        *d++ = *s++;
+    }
+
+    return dst;
+}
+
+extern "C" void *memmove_optimized(void *dst, const void *src, uint32_t len)
+{
+    // Forward copy is safe unless dst lies inside [src, src + len)
+    if ((uintptr_t)dst - (uintptr_t)src >= len)
+    {
+        return memcpy_optimized(dst, src, len);
+    }
+
+    uint8_t *d = static_cast<uint8_t *>(dst) + len;
+    const uint8_t *s = static_cast<const uint8_t *>(src) + len;
+
+    if (len >= 8u)
+    {
+        while (((uintptr_t)d & 3u) != 0u)
+        {
+            *--d = *--s;
+            len--;
+        }
+
+        // A word is loaded completely before it is stored, overlap within it is fine
+        while (len >= sizeof(uint32_t))
+        {
+            d -= sizeof(uint32_t);
+            s -= sizeof(uint32_t);
+            storeWord(d, loadWord(s));
+            len -= sizeof(uint32_t);
+        }
+    }
+
+    while (len-- > 0u)
+    {
+        *--d = *--s;
+    }
+
+    return dst;
+}
+
+extern "C" void *memset_optimized(void *dst, uint32_t val, uint32_t len)
+{
+    uint8_t *d = static_cast<uint8_t *>(dst);
+    uint32_t pattern = (val & 0xFFu) * 0x01010101u;
+
+    if (len >= 8u)
+    {
+        while (((uintptr_t)d & 3u) != 0u)
+        {
+            *d++ = (uint8_t)val;
+            len--;
+        }
+
+        while (len >= sizeof(uint32_t))
+        {
+            storeWord(d, pattern);
+            d += sizeof(uint32_t);
+            len -= sizeof(uint32_t);
+        }
+    }
+
+    while (len-- > 0u)
+    {
+        *d++ = (uint8_t)val;
+    }
+
+    return dst;
+}
+
+extern "C" uint32_t *memset32_optimized(uint32_t *dst, uint32_t pattern, uint32_t count)
+{
+    for (uint32_t i = 0u; i < count; i++)
+    {
+        dst[i] = pattern;
+    }
+
+    return dst;
+}
+
+extern "C" uint32_t strlen_optimized(const char *str)
+{
+    const uint8_t *s = reinterpret_cast<const uint8_t *>(str);
+
+    while (((uintptr_t)s & 3u) != 0u)
+    {
+        if (*s == 0u)
+        {
+            return (uint32_t)(s - reinterpret_cast<const uint8_t *>(str));
+        }
+        s++;
+    }
+
+#if STRING_WORD_SCAN
+    // Aligned words never reach past the one holding the terminator
+    uint32_t flags;
+    while ((flags = zeroBytes(loadWord(s))) == 0u)
+    {
+        s += sizeof(uint32_t);
+    }
+
+    return (uint32_t)(s - reinterpret_cast<const uint8_t *>(str)) + firstByte(flags);
+#else
+    while (*s != 0u)
+    {
+        s++;
+    }
+
+    return (uint32_t)(s - reinterpret_cast<const uint8_t *>(str));
+#endif
+}
+
+extern "C" void *memchr_optimized(const void *buf, uint32_t val, uint32_t len)
+{
+    const uint8_t *s = static_cast<const uint8_t *>(buf);
+    uint8_t c = (uint8_t)val;
+
+    if (len >= 8u)
+    {
+        while (((uintptr_t)s & 3u) != 0u)
+        {
+            if (*s == c)
+            {
+                return const_cast<uint8_t *>(s);
+            }
+            s++;
+            len--;
+        }
+
+        uint32_t pattern = c * 0x01010101u;
+        while (len >= sizeof(uint32_t))
+        {
+            uint32_t flags = zeroBytes(loadWord(s) ^ pattern);
+            if (flags != 0u)
+            {
+                return const_cast<uint8_t *>(s + firstByte(flags));
+            }
+            s += sizeof(uint32_t);
+            len -= sizeof(uint32_t);
+        }
+    }
+
+    for (; len > 0u; len--, s++)
+    {
+        if (*s == c)
+        {
+            return const_cast<uint8_t *>(s);
+        }
+    }
+
+    return nullptr;
+}
+
+extern "C" int32_t memcmp_optimized(const void *a, const void *b, uint32_t len)
+{
+    const uint8_t *x = static_cast<const uint8_t *>(a);
+    const uint8_t *y = static_cast<const uint8_t *>(b);
+
+    if (len >= 8u && (((uintptr_t)x ^ (uintptr_t)y) & 3u) == 0u)
+    {
+        while (((uintptr_t)x & 3u) != 0u)
+        {
+            if (*x != *y)
+            {
+                return (int32_t)*x - (int32_t)*y;
+            }
+            x++;
+            y++;
+            len--;
+        }
+
+        // Differing words fall through to the byte loop, which finds the byte
+        while (len >= sizeof(uint32_t) && loadWord(x) == loadWord(y))
+        {
+            x += sizeof(uint32_t);
+            y += sizeof(uint32_t);
+            len -= sizeof(uint32_t);
+        }
+    }
+
+    for (; len > 0u; len--, x++, y++)
+    {
+        if (*x != *y)
+        {
+            return (int32_t)*x - (int32_t)*y;
+        }
+    }
+
+    return 0;
+}
+
+extern "C" int32_t strcmp_optimized(const char *a, const char *b)
+{
+    const uint8_t *x = reinterpret_cast<const uint8_t *>(a);
+    const uint8_t *y = reinterpret_cast<const uint8_t *>(b);
+
+    if (STRING_WORD_SCAN && (((uintptr_t)x ^ (uintptr_t)y) & 3u) == 0u)
+    {
+        while (((uintptr_t)x & 3u) != 0u)
+        {
+            if (*x != *y || *x == 0u)
+            {
+                return (int32_t)*x - (int32_t)*y;
+            }
+            x++;
+            y++;
+        }
+
+        // Stops at the word holding the terminator or a difference, resolved below
+        uint32_t word;
+        while ((word = loadWord(x)) == loadWord(y) && zeroBytes(word) == 0u)
+        {
+            x += sizeof(uint32_t);
+            y += sizeof(uint32_t);
+        }
+    }
+
+    while (*x == *y && *x != 0u)
+    {
+        x++;
+        y++;
+    }
+
+    return (int32_t)*x - (int32_t)*y;
+}
+
+#endif
@@ -0,0 +1,52 @@
+/*
+ * MemoryOps
+ * Author: Arkadiusz Szlanta
+ * Date: 17 Oct 2026
+ *
+ * License:
+ * This source code is provided for hobbyist and private use only.
+ * Any commercial or industrial use, including distribution, reproduction, or
+ * incorporation in commercial or industrial products or services is prohibited.
+ * Use at your own risk. The author(s) hold no responsibility for any damages
+ * or losses resulting from the use of this software.
+ *
+ */
+
+#ifndef MEMORY_OPS_HPP
+#define MEMORY_OPS_HPP
+
+#include <cstdint>
+
+// Set to 1 to count kernel memcpy/memset calls by size, see Config::DumpCopyHistogram
+#ifndef MEMORY_OPS_HISTOGRAM
+#define MEMORY_OPS_HISTOGRAM 0
+#endif
+
+// Set to 1 to build the LPC55S69 DMA0 backend of Memory::CopyAsync, see Memory::UseDmaCopyEngine
+#ifndef MEMORY_OPS_DMA
+#define MEMORY_OPS_DMA 0
+#endif
+
+// Implemented in memcpy.s, memset.s and string.s on target. MemoryOps.cpp provides
+// portable versions of the same symbols for host builds.
+extern "C"
+{
+    // Any alignment of dst and src, the buffers must not overlap. Returns dst.
+    void *memcpy_optimized(void *dst, const void *src, uint32_t len);
+    // Overlapping buffers allowed. Returns dst.
+    void *memmove_optimized(void *dst, const void *src, uint32_t len);
+    // Fills len bytes with the low byte of val. Returns dst.
+    void *memset_optimized(void *dst, uint32_t val, uint32_t len);
+    // Fills count words with pattern, dst must be word aligned. Returns dst.
+    uint32_t *memset32_optimized(uint32_t *dst, uint32_t pattern, uint32_t count);
+
+    // Number of bytes before the terminating NUL
+    uint32_t strlen_optimized(const char *str);
+    // First of len bytes equal to the low byte of val, nullptr if there is none
+    void *memchr_optimized(const void *buf, uint32_t val, uint32_t len);
+    // Sign of the first differing byte pair as unsigned chars, 0 if equal
+    int32_t memcmp_optimized(const void *a, const void *b, uint32_t len);
+    int32_t strcmp_optimized(const char *a, const char *b);
+}
+
+#endif /* MEMORY_OPS_HPP */
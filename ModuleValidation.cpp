@@ -0,0 +1,54 @@
+/*
+ * ModuleValidation
+ * Author: Arkadiusz Szlanta
+ * Date: 17 Oct 2026
+ *
+ * License:
+ * This source code is provided for hobbyist and private use only.
+ * Any commercial or industrial use, including distribution, reproduction, or
+ * incorporation in commercial or industrial products or services is prohibited.
+ * Use at your own risk. The author(s) hold no responsibility for any damages
+ * or losses resulting from the use of this software.
+ *
+ */
+
+#include "ModuleValidation.hpp"
+
+bool ModuleValidation::IsApiCompatible(const ModuleDescriptorBin &md)
+{
+    return (md.api_version == 0u) ||
+           (((md.api_version >> 16u) == CRTOS_API_VERSION_MAJOR) && ((md.api_version & 0xFFFFu) <= CRTOS_API_VERSION_MINOR));
+}
+
+CRTOS::Result ModuleValidation::CheckDescriptor(const ModuleDescriptorBin &md)
+{
+    if (!IsApiCompatible(md) || md.image_size < MODULE_HEADER_SIZE)
+    {
+        return CRTOS::Result::RESULT_MODULE_INVALID;
+    }
+    if ((md.flags & MODULE_FLAG_COMPRESSED) != 0u && md.packed_size == 0u)
+    {
+        return CRTOS::Result::RESULT_MODULE_INVALID;
+    }
+    if (md.import_offset > 0xFFFFFFFFu - (uint32_t)md.import_count * sizeof(ModuleImportBin) ||
+        md.reloc_offset > 0xFFFFFFFFu - (uint32_t)md.reloc_count * sizeof(uint32_t))
+    {
+        return CRTOS::Result::RESULT_MODULE_INVALID;
+    }
+
+    return CRTOS::Result::RESULT_SUCCESS;
+}
+
+CRTOS::Result ModuleValidation::CheckProgramInfo(const ProgramInfoBin *pinfo, uint32_t imageSize)
+{
+    if (imageSize < sizeof(ProgramInfoBin) || (pinfo->entryPoint & ~1u) >= imageSize ||
+        pinfo->section_data_start_addr > imageSize || pinfo->section_data_size > imageSize - pinfo->section_data_start_addr)
+    {
+        return CRTOS::Result::RESULT_MODULE_INVALID;
+    }
+
+    uint32_t stackSize = (pinfo->stackPointer > pinfo->msp_limit) ? (pinfo->stackPointer - pinfo->msp_limit) : MODULE_DEFAULT_STACK_SIZE;
+    uint64_t ramSize = (uint64_t)pinfo->section_data_size + pinfo->section_bss_size + 7u + stackSize;
+
+    return (ramSize <= 0xFFFFFFFFu) ? CRTOS::Result::RESULT_SUCCESS : CRTOS::Result::RESULT_MODULE_INVALID;
+}
@@ -0,0 +1,57 @@
+/*
+ * ModuleValidation
+ * Author: Arkadiusz Szlanta
+ * Date: 17 Oct 2026
+ *
+ * License:
+ * This source code is provided for hobbyist and private use only.
+ * Any commercial or industrial use, including distribution, reproduction, or
+ * incorporation in commercial or industrial products or services is prohibited.
+ * Use at your own risk. The author(s) hold no responsibility for any damages
+ * or losses resulting from the use of this software.
+ *
+ */
+
+#ifndef MODULE_VALIDATION_HPP
+#define MODULE_VALIDATION_HPP
+
+#include <cstdint>
+
+#include "CRTOS.hpp"
+#include "module_api.h"
+
+// Must match module ProgramInfo
+typedef struct ProgramInfoBin
+{
+    uint32_t stackPointer;
+    uint32_t entryPoint; // offset from image base; code is Thumb PIE
+    uint32_t vectors[74];
+    uint32_t section_data_start_addr; // offset in image of .data load
+    uint32_t section_data_dest_addr;
+    uint32_t section_data_size;
+    uint32_t section_bss_start_addr;
+    uint32_t section_bss_size;
+    uint32_t reserved[22];
+    uint32_t vtor_offset;
+    uint32_t msp_limit;
+} ProgramInfoBin;
+
+// Headers stored in front of every BIN image, never compressed nor covered by image_crc
+static constexpr uint32_t MODULE_HEADER_SIZE = sizeof(ProgramInfoBin) + sizeof(ModuleDescriptorBin);
+
+// Checks of BIN module headers taken from an untrusted file. They only look at the
+// structures passed in, so they also run on the host, see tools/ElfFuzz.cpp.
+namespace ModuleValidation
+{
+    // Modules built before api_version was filled in carry 0
+    bool IsApiCompatible(const ModuleDescriptorBin &md);
+
+    // Structural checks of a descriptor, done before anything is allocated for the module
+    CRTOS::Result CheckDescriptor(const ModuleDescriptorBin &md);
+
+    // The entry point and the .data initializers must lie inside the image and the
+    // RAM size derived from ProgramInfo must not wrap
+    CRTOS::Result CheckProgramInfo(const ProgramInfoBin *pinfo, uint32_t imageSize);
+}
+
+#endif /* MODULE_VALIDATION_HPP */
@@ -1,9 +1,13 @@
 // Memcpy implementation ARM optimized.
-// This implementation breaks down copying into several blocks: 128, 32, 8, 4, and 1 byte.
+// The destination is aligned first with byte copies. A word aligned source is then copied in
+// 32 byte ldm/stm bursts, a misaligned one is loaded as aligned words and shifted together.
+// Remaining words and bytes are copied one by one. memmove_optimized copies backwards the
+// same way when the destination overlaps the end of the source.
 // Author: Arkadiusz Szlanta
 
 .syntax unified
-.arch	armv7-m
+.arch   armv8-m.main
+.thumb
 
 .text
 .global     memcpy_optimized
@@ -11,134 +15,214 @@
 .align      4
 
 memcpy_optimized:
-    cmp     r2, #0                  // Nothing to copy. Don't play with me.
-    beq     stop
-
-    push    {r1, r3, r4}
-    cmp     r2, #127
-	bhi		copy128
-	cmp     r2, #31
-	bhi		copy32
-    cmp     r2, #7
-	bhi		copy8
-    cmp     r2, #3
-    bhi     copy4
-    bls     copybytes
-
-copy128:
-    ldrd    r3, r4, [r1]
-    strd    r3, r4, [r0]
-    ldrd    r3, r4, [r1, #8]
-    strd    r3, r4, [r0, #8]
-    ldrd    r3, r4, [r1, #16]
-    strd    r3, r4, [r0, #16]
-    ldrd    r3, r4, [r1, #24]
-    strd    r3, r4, [r0, #24]
-    ldrd    r3, r4, [r1, #32]
-    strd    r3, r4, [r0, #32]
-    ldrd    r3, r4, [r1, #40]
-    strd    r3, r4, [r0, #40]
-    ldrd    r3, r4, [r1, #48]
-    strd    r3, r4, [r0, #48]
-    ldrd    r3, r4, [r1, #56]
-    strd    r3, r4, [r0, #56]
-    ldrd    r3, r4, [r1, #64]
-    strd    r3, r4, [r0, #64]
-    ldrd    r3, r4, [r1, #72]
-    strd    r3, r4, [r0, #72]
-    ldrd    r3, r4, [r1, #80]
-    strd    r3, r4, [r0, #80]
-    ldrd    r3, r4, [r1, #88]
-    strd    r3, r4, [r0, #88]
-    ldrd    r3, r4, [r1, #96]
-    strd    r3, r4, [r0, #96]
-    ldrd    r3, r4, [r1, #104]
-    strd    r3, r4, [r0, #104]
-    ldrd    r3, r4, [r1, #112]
-    strd    r3, r4, [r0, #112]
-    ldrd    r3, r4, [r1, #120]
-    strd    r3, r4, [r0, #120]
-    add     r1, r1, #128
-    add     r0, r0, #128
-	subs    r2, r2, #128
-    cmp     r2, #127
-	bhi     copy128
-    cmp     r2, #0
-    beq     stop
-	cmp     r2, #31
-    bhi     copy32
-    cmp     r2, #7
-    bhi     copy8
-    cmp     r2, #3
-    bhi     copy4
-    b       copybytes
+    push    {r0, r4, r5, r6, r7, r8, lr}
+    cmp     r2, #8                  // Short copies are not worth aligning
+    blo     copybytes
 
-copy32:
-    ldr     r3, [r1], #4
-	str     r3, [r0], #4
-    ldr     r3, [r1], #4
-	str     r3, [r0], #4
-    ldr     r3, [r1], #4
-	str     r3, [r0], #4
-    ldr     r3, [r1], #4
-	str     r3, [r0], #4
-    ldr     r3, [r1], #4
-	str     r3, [r0], #4
-    ldr     r3, [r1], #4
-	str     r3, [r0], #4
-    ldr     r3, [r1], #4
-	str     r3, [r0], #4
-    ldr     r3, [r1], #4
-	str     r3, [r0], #4
-	subs    r2, r2, #32
-    cmp     r2, #31
-	bhi     copy32
-    cmp     r2, #0
-    beq     stop
-    cmp     r2, #7
-    bhi     copy8
-    cmp     r2, #3
-    bhi     copy4
-    b       copybytes
+    ands    r3, r0, #3
+    beq     dstaligned
+    rsb     r3, r3, #4              // Bytes up to the next word boundary
+    sub     r2, r2, r3
+head:
+    ldrb    r4, [r1], #1
+    strb    r4, [r0], #1
+    subs    r3, r3, #1
+    bne     head
 
-copy8:
-    ldr     r3, [r1], #4
-	str     r3, [r0], #4
-    ldr     r3, [r1], #4
-	str     r3, [r0], #4
-	subs    r2, r2, #8
-    cmp     r2, #7
-    bhi     copy8
-    cmp     r2, #0
-    beq     stop
-    cmp     r2, #3
-    bhi     copy4
-    b       copybytes
+dstaligned:
+    ands    r3, r1, #3
+    bne     srcmisaligned
 
+    subs    r2, r2, #32
+    blo     copy32done
+copy32:
+    ldmia   r1!, {r3, r4, r5, r6, r7, r8, r12, lr}
+    stmia   r0!, {r3, r4, r5, r6, r7, r8, r12, lr}
+    subs    r2, r2, #32
+    bhs     copy32
+copy32done:
+    adds    r2, r2, #32
+
+copywords:
+    subs    r2, r2, #4
+    blo     copywordsdone
 copy4:
-	ldr     r3, [r1], #4
-	str     r3, [r0], #4
-	subs    r2, r2, #4
-    cmp     r2, #3
-    bhi     copy4
-    cmp     r2, #0
-    beq     stop
-	b       copybytes
+    ldr     r3, [r1], #4
+    str     r3, [r0], #4
+    subs    r2, r2, #4
+    bhs     copy4
+copywordsdone:
+    adds    r2, r2, #4
 
 copybytes:
+    cbz     r2, stop
+copy1:
     ldrb    r3, [r1], #1
-	strb    r3, [r0], #1
-	subs    r2, r2, #1
-    cmp     r2, #0
-	bne     copybytes
-    b       stop
+    strb    r3, [r0], #1
+    subs    r2, r2, #1
+    bne     copy1
 
 stop:
-    pop     {r1, r3, r4}
-
     // Return address of destination buffer
-    mov     r0, r1
-    bx      lr
+    pop     {r0, r4, r5, r6, r7, r8, pc}
+
+    // Source is r3 bytes past a word boundary. Aligned words are loaded and every
+    // destination word is merged from two of them, r4 carries the upper part over.
+    // Loads never cross the word holding the last source byte.
+srcmisaligned:
+    lsl     r7, r3, #3              // Right shift of the older word
+    rsb     r8, r7, #32             // Left shift of the newer word
+    bic     r1, r1, #3
+    ldr     r4, [r1], #4
+
+    subs    r2, r2, #16
+    blo     merge16done
+merge16:
+    ldmia   r1!, {r5, r6, r12, lr}
+    lsr     r4, r4, r7
+    lsl     r3, r5, r8
+    orr     r3, r3, r4
+    lsr     r5, r5, r7
+    lsl     r4, r6, r8
+    orr     r4, r4, r5
+    lsr     r6, r6, r7
+    lsl     r5, r12, r8
+    orr     r5, r5, r6
+    lsr     r12, r12, r7
+    lsl     r6, lr, r8
+    orr     r6, r6, r12
+    stmia   r0!, {r3, r4, r5, r6}
+    mov     r4, lr
+    subs    r2, r2, #16
+    bhs     merge16
+merge16done:
+    adds    r2, r2, #16
+
+    subs    r2, r2, #4
+    blo     merge4done
+merge4:
+    ldr     r5, [r1], #4
+    lsr     r4, r4, r7
+    lsl     r3, r5, r8
+    orr     r3, r3, r4
+    str     r3, [r0], #4
+    mov     r4, r5
+    subs    r2, r2, #4
+    bhs     merge4
+merge4done:
+    adds    r2, r2, #4
+
+    sub     r1, r1, r8, lsr #3      // Back to the first source byte not copied yet
+    b       copybytes
+
+.size   memcpy_optimized, . - memcpy_optimized
+
+
+.global     memmove_optimized
+.type       memmove_optimized, %function
+.align      4
+
+memmove_optimized:
+    sub     r3, r0, r1              // Forward copy is safe unless dst lies inside [src, src + len)
+    cmp     r3, r2
+    bhs     memcpy_optimized
+
+    push    {r0, r4, r5, r6, r7, r8, lr}
+    add     r0, r0, r2
+    add     r1, r1, r2
+    cmp     r2, #8
+    blo     backbytes
+
+    ands    r3, r0, #3
+    beq     backdstaligned
+    sub     r2, r2, r3
+backhead:
+    ldrb    r4, [r1, #-1]!
+    strb    r4, [r0, #-1]!
+    subs    r3, r3, #1
+    bne     backhead
+
+backdstaligned:
+    ands    r3, r1, #3
+    bne     backsrcmisaligned
+
+    subs    r2, r2, #32
+    blo     back32done
+back32:
+    ldmdb   r1!, {r3, r4, r5, r6, r7, r8, r12, lr}
+    stmdb   r0!, {r3, r4, r5, r6, r7, r8, r12, lr}
+    subs    r2, r2, #32
+    bhs     back32
+back32done:
+    adds    r2, r2, #32
+
+backwords:
+    subs    r2, r2, #4
+    blo     backwordsdone
+back4:
+    ldr     r3, [r1, #-4]!
+    str     r3, [r0, #-4]!
+    subs    r2, r2, #4
+    bhs     back4
+backwordsdone:
+    adds    r2, r2, #4
+
+backbytes:
+    cbz     r2, backstop
+back1:
+    ldrb    r3, [r1, #-1]!
+    strb    r3, [r0, #-1]!
+    subs    r2, r2, #1
+    bne     back1
+
+backstop:
+    pop     {r0, r4, r5, r6, r7, r8, pc}
+
+    // Mirror of srcmisaligned, lr carries the lower part of the word above
+backsrcmisaligned:
+    lsl     r7, r3, #3
+    rsb     r8, r7, #32
+    bic     r1, r1, #3
+    ldr     lr, [r1]
+
+    subs    r2, r2, #16
+    blo     backmerge16done
+backmerge16:
+    ldmdb   r1!, {r3, r4, r5, r6}
+    lsl     lr, lr, r8
+    lsr     r12, r6, r7
+    orr     lr, lr, r12
+    lsl     r6, r6, r8
+    lsr     r12, r5, r7
+    orr     r6, r6, r12
+    lsl     r5, r5, r8
+    lsr     r12, r4, r7
+    orr     r5, r5, r12
+    lsl     r4, r4, r8
+    lsr     r12, r3, r7
+    orr     r4, r4, r12
+    stmdb   r0!, {r4, r5, r6, lr}
+    mov     lr, r3
+    subs    r2, r2, #16
+    bhs     backmerge16
+backmerge16done:
+    adds    r2, r2, #16
+
+    subs    r2, r2, #4
+    blo     backmerge4done
+backmerge4:
+    ldr     r3, [r1, #-4]!
+    lsl     lr, lr, r8
+    lsr     r12, r3, r7
+    orr     lr, lr, r12
+    str     lr, [r0, #-4]!
+    mov     lr, r3
+    subs    r2, r2, #4
+    bhs     backmerge4
+backmerge4done:
+    adds    r2, r2, #4
 
-.size	memcpy_optimized, . - memcpy_optimized
+    add     r1, r1, r7, lsr #3      // Back to the end of the source bytes not copied yet
+    b       backbytes
 
+.size   memmove_optimized, . - memmove_optimized
@@ -1,9 +1,12 @@
 // MEMSET implementation ARM optimized.
-// This implementation breaks down set value into several blocks: 32, 8, 4, and 1 byte.
+// The destination is aligned with byte stores, whole words are then written in 32 byte
+// stm bursts followed by a 16/8/4 byte tail and the remaining bytes.
+// memset32_optimized fills words with a 32-bit pattern, e.g. to paint task stacks.
 // Author: Arkadiusz Szlanta
 
 .syntax unified
-.arch   armv7-m
+.arch   armv8-m.main
+.thumb
 
 .text
 .global     memset_optimized
@@ -11,62 +14,76 @@
 .align      4
 
 memset_optimized:
-    cbz     r2, stop                  // Nothing to copy.
-    push    {r0, r3, r4}
-    bfi     r3, r1, #0, #8
-    bfi     r3, r1, #8, #8
-    bfi     r3, r1, #16, #8
-    bfi     r3, r1, #24, #8
-    mov     r4, r3
-    cmp     r2, #31
-    bhi     set32
-    cmp     r2, #7
-    bhi     set8
-    cmp     r2, #3
-    bhi     set4
-    b       set1
+    push    {r0, r4, r5, r6, r7, lr}
+    and     r1, r1, #0xFF           // Byte replicated over the word
+    orr     r1, r1, r1, lsl #8
+    orr     r1, r1, r1, lsl #16
+    cmp     r2, #8                  // Short fills are not worth aligning
+    blo     setbytes
 
+    ands    r3, r0, #3
+    beq     setwords
+    rsb     r3, r3, #4              // Bytes up to the next word boundary
+    sub     r2, r2, r3
+head:
+    strb    r1, [r0], #1
+    subs    r3, r3, #1
+    bne     head
+
+    // r0 word aligned, r1 pattern, r2 bytes left
+setwords:
+    mov     r3, r1
+    mov     r4, r1
+    mov     r5, r1
+    mov     r6, r1
+    mov     r7, r1
+    mov     r12, r1
+    mov     lr, r1
+
+    subs    r2, r2, #32
+    blo     set32done
 set32:
-    strd    r3, r4, [r0]!
-    strd    r3, r4, [r0]!
-    strd    r3, r4, [r0]!
-    strd    r3, r4, [r0]!
+    stmia   r0!, {r1, r3, r4, r5, r6, r7, r12, lr}
     subs    r2, r2, #32
-    cmp     r2, #31
-    bhi     set32
-    cbz     r2, stop
-    cmp     r2, #7
-    bhi     set8
-    cmp     r2, #3
-    bhi     set4
-    b       set1
+    bhs     set32
+set32done:
+    adds    r2, r2, #32             // 0 to 31 bytes left
 
+    tst     r2, #16
+    beq     set8
+    stmia   r0!, {r1, r3, r4, r5}
 set8:
-    strd    r3, r4, [r0]!
-    subs    r2, r2, #8
-    cmp     r2, #7
-    bhi     set8
-    cbz     r2, stop
-    cmp     r2, #3
-    bhi     set4
-    b       set1
-
+    tst     r2, #8
+    beq     set4
+    stmia   r0!, {r1, r3}
 set4:
-    str     r3, [r0]!
-    subs    r2, r2, #4
-    cmp     r2, #3
-    bhi     set4
-    cbz     r2, stop
-    b       set1
+    tst     r2, #4
+    beq     set4done
+    str     r1, [r0], #4
+set4done:
+    and     r2, r2, #3
 
+setbytes:
+    cbz     r2, stop
 set1:
-    strb    r3, [r0]!
+    strb    r1, [r0], #1
     subs    r2, r2, #1
-    cbz     r2, stop
-    b       set1
+    bne     set1
 
 stop:
-    pop     {r0, r3, r4}
-    bx      lr
+    pop     {r0, r4, r5, r6, r7, pc}
+
 .size   memset_optimized, .-memset_optimized
 
+
+// r0 word aligned destination, r1 pattern, r2 number of words
+.global     memset32_optimized
+.type       memset32_optimized, %function
+.align      4
+
+memset32_optimized:
+    push    {r0, r4, r5, r6, r7, lr}
+    lsl     r2, r2, #2
+    b       setwords
+
+.size   memset32_optimized, .-memset32_optimized
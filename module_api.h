@@ -0,0 +1,115 @@
+/*
+ * module_api.h
+ * Author: Arkadiusz Szlanta
+ * Date: 17 Oct 2026
+ *
+ * License:
+ * This source code is provided for hobbyist and private use only.
+ * Any commercial or industrial use, including distribution, reproduction, or
+ * incorporation in commercial or industrial products or services is prohibited.
+ * Use at your own risk. The author(s) hold no responsibility for any damages
+ * or losses resulting from the use of this software.
+ *
+ */
+
+// BIN module format and kernel services exported to loaded modules. A module
+// declares the crtos_* functions, leaves them undefined at link time and the loader
+// binds them to the running kernel. Calls must go through the GOT or use
+// -mlong-calls, the kernel is usually out of direct branch range of a module
+// loaded to RAM.
+
+#ifndef MODULE_API_H_
+#define MODULE_API_H_
+
+#include "stdint.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+// Major version changes break existing modules, minor version adds exports only
+#define CRTOS_API_VERSION_MAJOR 1u
+#define CRTOS_API_VERSION_MINOR 1u
+#define CRTOS_API_VERSION       ((CRTOS_API_VERSION_MAJOR << 16u) | CRTOS_API_VERSION_MINOR)
+
+#define MODULE_MAGIC 0x4D4F4455u // 'MODU'
+
+// Stack given to a module whose ProgramInfo does not describe one
+#define MODULE_DEFAULT_STACK_SIZE 1024u
+
+// Module reaches .data/.bss only through r9 (-msingle-pic-base -mpic-register=r9
+// -mno-pic-data-is-text-relative) and leaves their initialization to the loader.
+// Its image is never patched, so it can execute in place from flash.
+#define MODULE_FLAG_STATIC_BASE (1u << 0u)
+// Image and .data are rebased to 0 and carry a relocation table
+#define MODULE_FLAG_RELOCATIONS (1u << 1u)
+// image_crc is valid
+#define MODULE_FLAG_IMAGE_CRC   (1u << 2u)
+// Everything after the descriptor up to image_size is stored as one LZ4 block of
+// packed_size bytes. It is decoded straight into RAM, so it cannot execute in place.
+#define MODULE_FLAG_COMPRESSED  (1u << 3u)
+
+// Optional descriptor directly following ProgramInfo in our module format
+typedef struct __attribute__((packed)) ModuleDescriptorBin
+{
+    uint32_t magic; // 'MODU' 0x4D4F4455
+    uint16_t desc_version;
+    uint16_t _r0;
+    uint32_t api_version;
+    uint8_t name[32];
+    uint8_t semver_major;
+    uint8_t semver_minor;
+    uint16_t semver_patch;
+    uint32_t build_timestamp;
+    uint32_t image_size; // total size of BIN
+    uint32_t entry;      // address; ignore for BIN loader
+    uint32_t flags;      // MODULE_FLAG_*
+    uint32_t import_offset; // file offset of the ModuleImportBin table
+    uint16_t import_count;
+    uint16_t reloc_count;
+    uint32_t reloc_offset;  // file offset of the relocation table
+    uint32_t image_crc;     // CRC32 of the image following this descriptor, before compression
+    uint32_t packed_size;   // size of the compressed block, 0 when not compressed
+} ModuleDescriptorBin;
+
+// Kernel symbol imported by a BIN module, the table follows the image in the file
+typedef struct __attribute__((packed)) ModuleImportBin
+{
+    uint32_t slot; // offset of the word receiving the address, in .data when MODULE_IMPORT_RAM is set
+    char name[28];
+} ModuleImportBin;
+
+#define MODULE_IMPORT_RAM (1u << 31u)
+
+// Relocation entry: word offset of the place with region bits in the low bits.
+// The base address of the target region is added to the word at the place.
+#define MODULE_RELOC_PLACE_RAM  (1u << 0u) // place is in .data, otherwise in the image
+#define MODULE_RELOC_TARGET_RAM (1u << 1u) // word points into RAM, otherwise into the image
+#define MODULE_RELOC_OFFSET(e)  ((e) & ~3u)
+
+// Functions returning int report a CRTOS::Result value, 0 on success
+void crtos_delay(uint32_t ticks);
+void crtos_yield(void);
+int crtos_task_create(void (*function)(void *), const char *name, uint32_t stackDepth, void *args, uint32_t prio, void **handle);
+// Deletes the calling task when handle is NULL
+int crtos_task_delete(void **handle);
+const char *crtos_task_name(void);
+uint32_t crtos_enter_critical(void);
+void crtos_exit_critical(uint32_t mask);
+void *crtos_malloc(uint32_t size);
+void crtos_free(void *ptr);
+uint32_t crtos_free_memory(void);
+
+// Live replacement (API 1.1). The main task calls crtos_swap_point where it holds no
+// half-processed message. It returns at once unless Module::Replace is waiting; then
+// size bytes of state are handed to the new instance and the call never returns.
+void crtos_swap_point(const void *state, uint32_t size);
+// Copies the state handed over by the replaced instance and returns its length, 0 when
+// the module was started fresh. With dst NULL only the length is returned.
+uint32_t crtos_swap_state(void *dst, uint32_t size);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* MODULE_API_H_ */
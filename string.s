@@ -0,0 +1,261 @@
+// String and memory search/compare routines ARM optimized.
+// Whole words are examined at once. UADD8 adds 0xFF to every byte, which sets the GE flag
+// of each non-zero byte, and SEL then turns every zero byte into 0xFF. REV and CLZ give
+// the first such byte in memory order. Word loads stay aligned, so they never cross into
+// a word that holds no byte of the buffer.
+// Author: Arkadiusz Szlanta
+
+.syntax unified
+.arch   armv8-m.main
+.arch_extension dsp
+.thumb
+
+.text
+.global     strlen_optimized
+.type       strlen_optimized, %function
+.align      4
+
+strlen_optimized:
+    mov     r1, r0
+lenhead:
+    tst     r0, #3
+    beq     lenwords
+    ldrb    r2, [r0], #1
+    cmp     r2, #0
+    bne     lenhead
+    sub     r0, r0, r1              // r0 is one past the terminator
+    sub     r0, r0, #1
+    bx      lr
+
+lenwords:
+    mvn     r12, #0
+    mov     r3, #0
+len4:
+    ldr     r2, [r0], #4
+    uadd8   r2, r2, r12             // GE set for every non-zero byte
+    sel     r2, r3, r12             // 0xFF where the byte was zero
+    cmp     r2, #0
+    beq     len4
+
+    rev     r2, r2
+    clz     r2, r2
+    sub     r0, r0, r1
+    sub     r0, r0, #4
+    add     r0, r0, r2, lsr #3
+    bx      lr
+
+.size   strlen_optimized, . - strlen_optimized
+
+
+.global     memchr_optimized
+.type       memchr_optimized, %function
+.align      4
+
+memchr_optimized:
+    and     r1, r1, #0xFF
+    cmp     r2, #8                  // Short buffers are not worth aligning
+    blo     chrbytes
+
+chrhead:
+    tst     r0, #3
+    beq     chrwords
+    ldrb    r3, [r0], #1
+    cmp     r3, r1
+    beq     chrfoundbyte
+    sub     r2, r2, #1
+    b       chrhead
+
+chrwords:
+    push    {r4, lr}
+    orr     r4, r1, r1, lsl #8      // Byte replicated over the word
+    orr     r4, r4, r4, lsl #16
+    mvn     r12, #0
+    mov     lr, #0
+
+    subs    r2, r2, #4
+    blo     chrwordsdone
+chr4:
+    ldr     r3, [r0], #4
+    eor     r3, r3, r4              // Matching bytes become zero
+    uadd8   r3, r3, r12
+    sel     r3, lr, r12
+    cbnz    r3, chrfoundword
+    subs    r2, r2, #4
+    bhs     chr4
+chrwordsdone:
+    adds    r2, r2, #4
+    pop     {r4, lr}
+
+chrbytes:
+    cbz     r2, chrnone
+chr1:
+    ldrb    r3, [r0], #1
+    cmp     r3, r1
+    beq     chrfoundbyte
+    subs    r2, r2, #1
+    bne     chr1
+chrnone:
+    mov     r0, #0
+    bx      lr
+
+chrfoundbyte:
+    sub     r0, r0, #1
+    bx      lr
+
+chrfoundword:
+    rev     r3, r3
+    clz     r3, r3
+    sub     r0, r0, #4
+    add     r0, r0, r3, lsr #3
+    pop     {r4, pc}
+
+.size   memchr_optimized, . - memchr_optimized
+
+
+// Buffers with the same offset within a word are compared a word at a time once aligned,
+// others byte by byte.
+.global     memcmp_optimized
+.type       memcmp_optimized, %function
+.align      4
+
+memcmp_optimized:
+    push    {r4, lr}
+    cmp     r2, #8
+    blo     cmpbytes
+    eor     r3, r0, r1
+    tst     r3, #3
+    bne     cmpbytes
+
+cmphead:
+    tst     r0, #3
+    beq     cmpwords
+    ldrb    r3, [r0], #1
+    ldrb    r4, [r1], #1
+    subs    r3, r3, r4
+    bne     cmpdiffer
+    sub     r2, r2, #1
+    b       cmphead
+
+cmpwords:
+    subs    r2, r2, #8
+    blo     cmp8done
+cmp8:
+    ldrd    r3, r4, [r0], #8
+    ldrd    r12, lr, [r1], #8
+    cmp     r3, r12
+    bne     cmpfirstword
+    cmp     r4, lr
+    bne     cmpsecondword
+    subs    r2, r2, #8
+    bhs     cmp8
+cmp8done:
+    adds    r2, r2, #8
+
+    subs    r2, r2, #4
+    blo     cmp4done
+    ldr     r3, [r0], #4
+    ldr     r12, [r1], #4
+    cmp     r3, r12
+    bne     cmpwordsdiffer
+    sub     r2, r2, #4
+cmp4done:
+    and     r2, r2, #3
+
+cmpbytes:
+    cbz     r2, cmpequal
+cmp1:
+    ldrb    r3, [r0], #1
+    ldrb    r4, [r1], #1
+    subs    r3, r3, r4
+    bne     cmpdiffer
+    subs    r2, r2, #1
+    bne     cmp1
+cmpequal:
+    mov     r0, #0
+    pop     {r4, pc}
+
+cmpdiffer:
+    mov     r0, r3
+    pop     {r4, pc}
+
+cmpsecondword:
+    mov     r3, r4
+    mov     r12, lr
+cmpfirstword:
+cmpwordsdiffer:
+    // r3 and r12 differ, the lowest differing byte decides
+    eor     r4, r3, r12
+    rev     r4, r4
+    clz     r4, r4
+    bic     r4, r4, #7
+    lsr     r3, r3, r4
+    lsr     r12, r12, r4
+    and     r3, r3, #0xFF
+    and     r12, r12, #0xFF
+    sub     r0, r3, r12
+    pop     {r4, pc}
+
+.size   memcmp_optimized, . - memcmp_optimized
+
+
+// Strings with the same offset within a word are compared a word at a time once aligned,
+// a word pair ends the loop when it differs or the first one holds the terminator.
+.global     strcmp_optimized
+.type       strcmp_optimized, %function
+.align      4
+
+strcmp_optimized:
+    eor     r2, r0, r1
+    tst     r2, #3
+    bne     strbytes
+
+strhead:
+    tst     r0, #3
+    beq     strwords
+    ldrb    r2, [r0], #1
+    ldrb    r3, [r1], #1
+    subs    r2, r2, r3
+    bne     strdiffer
+    cmp     r3, #0
+    bne     strhead
+    mov     r0, #0
+    bx      lr
+
+strwords:
+    push    {r4, r5, lr}
+    mvn     r12, #0
+    mov     lr, #0
+str4:
+    ldr     r2, [r0], #4
+    ldr     r3, [r1], #4
+    uadd8   r4, r2, r12
+    sel     r4, lr, r12             // 0xFF where the first string ends
+    eor     r5, r2, r3
+    orrs    r4, r4, r5
+    beq     str4
+
+    rev     r4, r4
+    clz     r4, r4
+    bic     r4, r4, #7
+    lsr     r2, r2, r4
+    lsr     r3, r3, r4
+    and     r2, r2, #0xFF
+    and     r3, r3, #0xFF
+    sub     r0, r2, r3
+    pop     {r4, r5, pc}
+
+strbytes:
+    ldrb    r2, [r0], #1
+    ldrb    r3, [r1], #1
+    subs    r2, r2, r3
+    bne     strdiffer
+    cmp     r3, #0
+    bne     strbytes
+    mov     r0, #0
+    bx      lr
+
+strdiffer:
+    mov     r0, r2
+    bx      lr
+
+.size   strcmp_optimized, . - strcmp_optimized
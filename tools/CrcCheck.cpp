@@ -0,0 +1,199 @@
+/*
+ * CrcCheck
+ * Author: Arkadiusz Szlanta
+ * Date: 17 Oct 2026
+ *
+ * License:
+ * This source code is provided for hobbyist and private use only.
+ * Any commercial or industrial use, including distribution, reproduction, or
+ * incorporation in commercial or industrial products or services is prohibited.
+ * Use at your own risk. The author(s) hold no responsibility for any damages
+ * or losses resulting from the use of this software.
+ *
+ */
+
+// Host side check of Crc.hpp against a bit at a time reference.
+//
+// Build (Linux), preferably with sanitizers:
+//   g++ -std=c++17 -O1 -g -fsanitize=address,undefined -I.. CrcCheck.cpp -o crc_check
+//   crc_check
+//
+// Buffers start at every offset within a word and have random lengths, so the aligned
+// head, the slicing-by-8 loop and the tail are all taken. Calculate and CopyAndUpdate
+// must match the reference, Combine must give the CRC of both parts for a random split,
+// and a Context fed in random chunks, with parts appended through Append, must match
+// the whole buffer and every prefix it was finalized at. Crc32Iso is what the kernel
+// uses; the other catalogue CRCs cover non-reflected, 8-bit bytewise and 64-bit
+// registers. Prints the number of failed checks and returns non-zero if there was any.
+
+#include <Crc.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace
+{
+    uint32_t sChecks = 0u;
+    uint32_t sFailures = 0u;
+
+    void check(bool condition, const char *crc, const char *what, uint32_t sample)
+    {
+        sChecks++;
+        if (!condition)
+        {
+            sFailures++;
+            std::printf("FAIL %s %s, sample %lu\n", crc, what, (unsigned long)sample);
+        }
+    }
+
+    // Catalogue parameters, the same ones the Crc template takes
+    struct Model
+    {
+        uint32_t width;
+        uint64_t poly;
+        uint64_t init;
+        bool refIn;
+        bool refOut;
+        uint64_t xorOut;
+    };
+
+    uint64_t reflect(uint64_t value, uint32_t bits)
+    {
+        uint64_t result = 0u;
+        for (uint32_t i = 0u; i < bits; i++)
+        {
+            result = (result << 1u) | ((value >> i) & 1u);
+        }
+        return result;
+    }
+
+    uint64_t modelMask(const Model &model)
+    {
+        return (model.width == 64u) ? ~0ull : ((1ull << model.width) - 1u);
+    }
+
+    // Textbook shift register, one bit per step, no tables. Starts from model.init.
+    uint64_t referenceUpdate(const Model &model, uint64_t crc, const uint8_t *data, size_t length)
+    {
+        uint64_t top = 1ull << (model.width - 1u);
+
+        for (size_t i = 0u; i < length; i++)
+        {
+            uint64_t byte = model.refIn ? reflect(data[i], 8u) : data[i];
+            crc ^= byte << (model.width - 8u);
+            for (uint32_t bit = 0u; bit < 8u; bit++)
+            {
+                crc = ((crc & top) != 0u) ? ((crc << 1u) ^ model.poly) : (crc << 1u);
+                crc &= modelMask(model);
+            }
+        }
+
+        return crc;
+    }
+
+    uint64_t referenceFinish(const Model &model, uint64_t crc)
+    {
+        if (model.refOut)
+        {
+            crc = reflect(crc, model.width);
+        }
+        return (crc ^ model.xorOut) & modelMask(model);
+    }
+
+    uint64_t reference(const Model &model, const uint8_t *data, size_t length)
+    {
+        return referenceFinish(model, referenceUpdate(model, model.init & modelMask(model), data, length));
+    }
+
+    template <typename CrcType>
+    void checkModel(const char *name, const Model &model, std::mt19937 &random)
+    {
+        typedef typename CrcType::Value Value;
+        static constexpr size_t SIZE = 4096u;
+        static constexpr size_t SLACK = 8u;
+
+        // Reference and template agree on the catalogue check value first
+        const uint8_t digits[] = { '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+        check(reference(model, digits, sizeof(digits)) == (uint64_t)CrcType::Check(), name, "check value", 0u);
+
+        std::vector<uint8_t> buffer(SIZE + SLACK);
+        std::vector<uint8_t> copy(SIZE + SLACK);
+        for (uint8_t &value : buffer)
+        {
+            value = (uint8_t)random();
+        }
+
+        for (uint32_t sample = 0u; sample < 20000u; sample++)
+        {
+            // Short buffers are the interesting ones, every third sample may be long
+            size_t offset = random() % SLACK;
+            size_t length = ((sample % 3u) == 0u) ? (random() % (SIZE + 1u)) : (random() % 64u);
+            const uint8_t *data = buffer.data() + offset;
+            uint64_t expected = reference(model, data, length);
+
+            check((uint64_t)CrcType::Calculate(data, length) == expected, name, "calculate", sample);
+
+            size_t dstOffset = random() % SLACK;
+            std::memset(copy.data(), 0, copy.size());
+            Value copied = CrcType::Finish(CrcType::CopyAndUpdate(CrcType::Begin(), copy.data() + dstOffset, data, length));
+            check((uint64_t)copied == expected && std::memcmp(copy.data() + dstOffset, data, length) == 0, name, "copy and update", sample);
+
+            // Any split, empty parts included
+            size_t split = (length == 0u) ? 0u : (random() % (length + 1u));
+            Value crcA = CrcType::Calculate(data, split);
+            Value crcB = CrcType::Calculate(data + split, length - split);
+            check((uint64_t)CrcType::Combine(crcA, crcB, length - split) == expected, name, "combine", sample);
+
+            // Chunks as they would arrive from DMA, some checksummed elsewhere and appended
+            typename CrcType::Context context;
+            size_t done = 0u;
+            uint64_t prefix = model.init & modelMask(model);
+            bool prefixes = true;
+            while (done < length)
+            {
+                size_t chunk = 1u + random() % (length - done);
+                if ((random() % 4u) == 0u)
+                {
+                    context.Append(CrcType::Calculate(data + done, chunk), chunk);
+                }
+                else
+                {
+                    context.Update(data + done, chunk);
+                }
+                prefix = referenceUpdate(model, prefix, data + done, chunk);
+                done += chunk;
+                prefixes = prefixes && (uint64_t)context.Finalize() == referenceFinish(model, prefix);
+            }
+            check(prefixes, name, "context prefix", sample);
+            check((uint64_t)context.Finalize() == expected && context.GetLength() == length, name, "context", sample);
+        }
+
+        // Lengths the 64-bit count of Combine exists for, appended zeros are cheap to model
+        for (uint64_t zeros : { 1ull << 20u, (1ull << 20u) + 7u })
+        {
+            std::vector<uint8_t> zero((size_t)zeros, 0u);
+            Value crcA = CrcType::Calculate(buffer.data(), 100u);
+            Value crcB = CrcType::Calculate(zero.data(), zero.size());
+            std::vector<uint8_t> whole(buffer.begin(), buffer.begin() + 100);
+            whole.insert(whole.end(), zero.begin(), zero.end());
+            check((uint64_t)CrcType::Combine(crcA, crcB, zeros) == reference(model, whole.data(), whole.size()), name, "long combine", (uint32_t)zeros);
+        }
+    }
+}
+
+int main(void)
+{
+    std::mt19937 random(2026u);
+
+    checkModel<CRTOS::Crc32Iso>("Crc32Iso", { 32u, 0x04C11DB7u, 0xFFFFFFFFu, true, true, 0xFFFFFFFFu }, random);
+    checkModel<CRTOS::Crc32C>("Crc32C", { 32u, 0x1EDC6F41u, 0xFFFFFFFFu, true, true, 0xFFFFFFFFu }, random);
+    checkModel<CRTOS::Crc16Ccitt>("Crc16Ccitt", { 16u, 0x1021u, 0xFFFFu, false, false, 0x0000u }, random);
+    checkModel<CRTOS::Crc8>("Crc8", { 8u, 0x07u, 0x00u, false, false, 0x00u }, random);
+    checkModel<CRTOS::Crc64Xz>("Crc64Xz", { 64u, 0x42F0E1EBA9EA3693ull, ~0ull, true, true, ~0ull }, random);
+
+    std::printf("%lu checks, %lu failed\n", (unsigned long)sChecks, (unsigned long)sFailures);
+    return (sFailures == 0u) ? 0 : 1;
+}
@@ -0,0 +1,489 @@
+/*
+ * ElfFuzz
+ * Author: Arkadiusz Szlanta
+ * Date: 17 Oct 2026
+ *
+ * License:
+ * This source code is provided for hobbyist and private use only.
+ * Any commercial or industrial use, including distribution, reproduction, or
+ * incorporation in commercial or industrial products or services is prohibited.
+ * Use at your own risk. The author(s) hold no responsibility for any damages
+ * or losses resulting from the use of this software.
+ *
+ */
+
+// Fuzz target for the module loaders' handling of untrusted files: ElfFile::parse
+// and the BIN ModuleDescriptorBin/ProgramInfoBin checks.
+//
+// Build with libFuzzer (clang):
+//   clang++ -std=c++17 -g -O1 -fsanitize=fuzzer,address,undefined -I.. ElfFuzz.cpp ../ELFParser.cpp ../MemoryOps.cpp ../ModuleValidation.cpp -o elf_fuzz
+//   elf_fuzz -max_len=4096 corpus
+//
+// Build without libFuzzer (gcc), inputs are mutated from built-in seeds:
+//   g++ -std=c++17 -g -O1 -fsanitize=address,undefined -DELF_FUZZ_STANDALONE -I.. ElfFuzz.cpp ../ELFParser.cpp ../MemoryOps.cpp ../ModuleValidation.cpp -o elf_fuzz
+//   elf_fuzz [iterations] [file...]
+//   elf_fuzz --seeds <directory>      writes the seeds, a starting corpus for libFuzzer
+//
+// Every input is parsed with its size passed to ElfFile::setFileSize, as
+// CreateTaskForExecutable(elf, size, ...) does, and once more with the size unknown.
+// The reader fails past the end of the input. ElfFile rewrites 32-bit addresses,
+// so the regions it loads are mapped below 4 GiB, each one ending at a page the
+// process cannot access. Every region must be released or handed over on return.
+
+#include <ELFParser.hpp>
+#include <ModuleValidation.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace
+{
+    // Larger regions are refused, parse must report ELF_ERROR_NO_MEMORY
+    constexpr uint32_t MAX_REGION = 1u << 20u;
+
+    struct Mapping
+    {
+        void *base;
+        size_t length;
+    };
+
+    std::unordered_map<void *, Mapping> sMappings;
+
+    void *fuzzAllocate(uint32_t size)
+    {
+        if (size > MAX_REGION)
+        {
+            return nullptr;
+        }
+
+        size_t page = (size_t)sysconf(_SC_PAGESIZE);
+        size_t used = (size + page - 1u) & ~(page - 1u);
+        int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#if defined(MAP_32BIT)
+        flags |= MAP_32BIT;
+#endif
+        void *base = mmap(nullptr, used + page, PROT_READ | PROT_WRITE, flags, -1, 0);
+        if (base == MAP_FAILED)
+        {
+            return nullptr;
+        }
+        if ((uintptr_t)base + used + page > 0xFFFFFFFFu)
+        {
+            munmap(base, used + page);
+            return nullptr;
+        }
+        mprotect((uint8_t *)base + used, page, PROT_NONE);
+
+        // Word aligned like the kernel heap, as close to the guard page as that allows
+        uint8_t *block = (uint8_t *)base + ((used - size) & ~(size_t)7u);
+        sMappings[block] = { base, used + page };
+        return block;
+    }
+
+    void fuzzDeallocate(void *ptr)
+    {
+        if (ptr == nullptr)
+        {
+            return;
+        }
+
+        auto found = sMappings.find(ptr);
+        if (found == sMappings.end())
+        {
+            std::fprintf(stderr, "deallocate of %p not allocated by ElfFile\n", ptr);
+            std::abort();
+        }
+        munmap(found->second.base, found->second.length);
+        sMappings.erase(found);
+    }
+
+    bool fuzzResolve(const char *name, uint32_t &address)
+    {
+        if (std::strncmp(name, "crtos_", 6u) != 0)
+        {
+            return false;
+        }
+
+        address = 0x00080000u + (uint32_t)std::strlen(name);
+        return true;
+    }
+
+    struct Input
+    {
+        const uint8_t *data;
+        uint32_t size;
+    };
+
+    int inputReader(void *context, uint32_t offset, void *dst, uint32_t length)
+    {
+        const Input &input = *static_cast<const Input *>(context);
+        if (offset > input.size || input.size - offset < length)
+        {
+            return -1;
+        }
+
+        std::memcpy(dst, input.data + offset, length);
+        return 0;
+    }
+
+    void parseElf(const Input &input, uint32_t fileSize)
+    {
+        uint8_t *image = nullptr;
+        uint8_t *ram = nullptr;
+        {
+            ElfFile elf;
+            elf.setAllocator(fuzzAllocate, fuzzDeallocate);
+            elf.setResolver(fuzzResolve);
+            elf.setFileSize(fileSize);
+
+            uint32_t *stack = nullptr;
+            uint32_t stackSize = 0u;
+            uint32_t vtorOffset = 0u;
+            if (elf.parse(inputReader, (void *)&input, &stack, &stackSize, &vtorOffset) == ELF_OK)
+            {
+                image = elf.getImage();
+                ram = elf.getRam();
+
+                Elf32_Sym symbol;
+                Elf32_Shdr section;
+                elf.findSymbol("counter", symbol);
+                elf.findSymbol("crtos_task_delay", symbol);
+                elf.findSection(".data", section);
+            }
+            else if (elf.getImage() != nullptr || elf.getRam() != nullptr)
+            {
+                std::fprintf(stderr, "failed parse kept its regions\n");
+                std::abort();
+            }
+        }
+
+        // The loaded regions belong to the caller, everything else is gone with elf
+        fuzzDeallocate(image);
+        fuzzDeallocate(ram);
+        if (!sMappings.empty())
+        {
+            std::fprintf(stderr, "%zu regions leaked\n", sMappings.size());
+            std::abort();
+        }
+    }
+
+    // A header the checks accept must describe a module the loader can place safely
+    void checkBin(const Input &input)
+    {
+
+        if (input.size < MODULE_HEADER_SIZE)
+        {
+            return;
+        }
+
+        ProgramInfoBin pinfo;
+        ModuleDescriptorBin md;
+        std::memcpy(&pinfo, input.data, sizeof(pinfo));
+        std::memcpy(&md, input.data + sizeof(pinfo), sizeof(md));
+
+        bool valid = true;
+        if (ModuleValidation::CheckDescriptor(md) == CRTOS::Result::RESULT_SUCCESS)
+        {
+            valid = ModuleValidation::IsApiCompatible(md) && md.image_size >= MODULE_HEADER_SIZE &&
+                    (uint64_t)md.import_offset + (uint64_t)md.import_count * sizeof(ModuleImportBin) <= 0xFFFFFFFFu &&
+                    (uint64_t)md.reloc_offset + (uint64_t)md.reloc_count * sizeof(uint32_t) <= 0xFFFFFFFFu;
+        }
+
+        for (uint32_t imageSize : { md.image_size, input.size })
+        {
+            if (ModuleValidation::CheckProgramInfo(&pinfo, imageSize) == CRTOS::Result::RESULT_SUCCESS)
+            {
+                valid = valid && (pinfo.entryPoint & ~1u) < imageSize &&
+                        (uint64_t)pinfo.section_data_start_addr + pinfo.section_data_size <= imageSize;
+            }
+        }
+
+        if (!valid)
+        {
+            std::fprintf(stderr, "BIN header accepted with out of range fields\n");
+            std::abort();
+        }
+    }
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    if (size > 0xFFFFFFFFu)
+    {
+        return 0;
+    }
+
+    Input input = { data, (uint32_t)size };
+    parseElf(input, (uint32_t)size);
+    parseElf(input, 0u);
+    checkBin(input);
+
+    return 0;
+}
+
+#if defined(ELF_FUZZ_STANDALONE)
+
+namespace
+{
+    template <typename T>
+    void put(std::vector<uint8_t> &file, uint32_t offset, const T &value)
+    {
+        if (file.size() < offset + sizeof(T))
+        {
+            file.resize(offset + sizeof(T), 0u);
+        }
+        std::memcpy(&file[offset], &value, sizeof(T));
+    }
+
+    // Module with an image and a RAM segment, an absolute relocation against .data and
+    // one against a kernel import, laid out as arm-none-eabi-ld does with --emit-relocs
+    std::vector<uint8_t> elfSeed(void)
+    {
+        static constexpr uint32_t PHDR = sizeof(Elf32_Ehdr);
+        static constexpr uint32_t TEXT = 0x80u;
+        static constexpr uint32_t TEXT_SIZE = 0x200u;
+        static constexpr uint32_t DATA = TEXT + TEXT_SIZE;
+        static constexpr uint32_t DATA_ADDR = 0x10000000u;
+        static constexpr uint32_t DATA_SIZE = 0x10u;
+        static constexpr uint32_t BSS_SIZE = 0x30u;
+        static const char SHSTRTAB[] = "\0.shstrtab\0.text\0.data\0.symtab\0.strtab\0.rel.text";
+        static const char STRTAB[] = "\0counter\0crtos_task_delay";
+
+        std::vector<uint8_t> file;
+
+        ProgramInfo info = {};
+        info.entryPoint = 0x1E1u;
+        info.section_data_start_addr = TEXT_SIZE;
+        info.section_data_dest_addr = DATA_ADDR;
+        info.section_data_size = DATA_SIZE;
+        info.section_bss_start_addr = DATA_ADDR + DATA_SIZE;
+        info.section_bss_size = BSS_SIZE;
+        put(file, TEXT, info);
+        put(file, TEXT + 0x1C0u, DATA_ADDR + 4u);
+        put(file, TEXT + 0x1C4u, 0u);
+        put(file, TEXT + 0x1E0u, (uint32_t)0xBF00BF00u);
+        put(file, DATA, (uint32_t)0x12345678u);
+        put(file, DATA + DATA_SIZE - 4u, 0u);
+
+        uint32_t shstrtab = (uint32_t)file.size();
+        file.insert(file.end(), SHSTRTAB, SHSTRTAB + sizeof(SHSTRTAB));
+        uint32_t strtab = (uint32_t)file.size();
+        file.insert(file.end(), STRTAB, STRTAB + sizeof(STRTAB));
+        file.resize((file.size() + 3u) & ~3u, 0u);
+
+        uint32_t symtab = (uint32_t)file.size();
+        Elf32_Sym symbols[3] = {};
+        symbols[1] = { 1u, DATA_ADDR + 4u, 4u, 0x11u, 0u, 2u };     // counter, global object in .data
+        symbols[2] = { 9u, 0u, 0u, 0x12u, 0u, SHN_UNDEF };         // crtos_task_delay, kernel import
+        put(file, symtab, symbols);
+
+        uint32_t reltext = (uint32_t)file.size();
+        Elf32_Rel relocations[2] = { { 0x1C0u, (1u << 8u) | R_ARM_ABS32 }, { 0x1C4u, (2u << 8u) | R_ARM_ABS32 } };
+        put(file, reltext, relocations);
+
+        uint32_t shoff = (uint32_t)file.size();
+        Elf32_Shdr sections[7] = {};
+        sections[1] = { 11u, 1u, SHF_ALLOC | 4u, 0u, TEXT, TEXT_SIZE, 0u, 0u, 4u, 0u };
+        sections[2] = { 17u, 1u, SHF_ALLOC | 1u, DATA_ADDR, DATA, DATA_SIZE, 0u, 0u, 4u, 0u };
+        sections[3] = { 23u, SHT_SYMTAB, 0u, 0u, symtab, sizeof(symbols), 4u, 1u, 4u, sizeof(Elf32_Sym) };
+        sections[4] = { 31u, SHT_STRTAB, 0u, 0u, strtab, sizeof(STRTAB), 0u, 0u, 1u, 0u };
+        sections[5] = { 39u, SHT_REL, 0u, 0u, reltext, sizeof(relocations), 3u, 1u, 4u, sizeof(Elf32_Rel) };
+        sections[6] = { 1u, SHT_STRTAB, 0u, 0u, shstrtab, sizeof(SHSTRTAB), 0u, 0u, 1u, 0u };
+        put(file, shoff, sections);
+
+        Elf32_Phdr segments[2] = {
+            { PT_LOAD, TEXT, 0u, 0u, TEXT_SIZE, TEXT_SIZE, PF_R | PF_X, 4u },
+            { PT_LOAD, DATA, DATA_ADDR, DATA_ADDR, DATA_SIZE, DATA_SIZE + BSS_SIZE, PF_R | PF_W, 4u },
+        };
+        put(file, PHDR, segments);
+
+        Elf32_Ehdr header = {};
+        const uint8_t ident[] = { 0x7Fu, 'E', 'L', 'F', 1u, 1u, 1u };
+        std::memcpy(header.e_ident, ident, sizeof(ident));
+        header.e_type = ET_EXEC;
+        header.e_machine = EM_ARM;
+        header.e_version = 1u;
+        header.e_entry = 0x1E1u;
+        header.e_phoff = PHDR;
+        header.e_shoff = shoff;
+        header.e_ehsize = sizeof(Elf32_Ehdr);
+        header.e_phentsize = sizeof(Elf32_Phdr);
+        header.e_phnum = 2u;
+        header.e_shentsize = sizeof(Elf32_Shdr);
+        header.e_shnum = 7u;
+        header.e_shstrndx = 6u;
+        put(file, 0u, header);
+
+        return file;
+    }
+
+    // BIN module as written by ModulePacker, with one import and one relocation
+    std::vector<uint8_t> binSeed(void)
+    {
+        static constexpr uint32_t IMAGE_SIZE = MODULE_HEADER_SIZE + 0x40u;
+
+        std::vector<uint8_t> file;
+
+        ProgramInfoBin pinfo = {};
+        pinfo.entryPoint = MODULE_HEADER_SIZE | 1u;
+        pinfo.section_data_start_addr = IMAGE_SIZE - 0x10u;
+        pinfo.section_data_size = 0x10u;
+        pinfo.section_bss_size = 0x20u;
+        put(file, 0u, pinfo);
+
+        ModuleDescriptorBin md = {};
+        md.magic = MODULE_MAGIC;
+        md.api_version = CRTOS_API_VERSION;
+        md.image_size = IMAGE_SIZE;
+        md.flags = MODULE_FLAG_RELOCATIONS;
+        md.import_offset = IMAGE_SIZE;
+        md.import_count = 1u;
+        md.reloc_offset = IMAGE_SIZE + sizeof(ModuleImportBin);
+        md.reloc_count = 1u;
+        put(file, sizeof(ProgramInfoBin), md);
+
+        ModuleImportBin import = {};
+        import.slot = MODULE_IMPORT_RAM | 4u;
+        std::strcpy(import.name, "crtos_task_delay");
+        put(file, md.import_offset, import);
+        put(file, md.reloc_offset, (uint32_t)MODULE_HEADER_SIZE);
+
+        return file;
+    }
+
+    // Flips, interesting values and cuts, roughly what libFuzzer starts with
+    void mutate(std::vector<uint8_t> &input, std::mt19937 &random)
+    {
+        static const uint32_t INTERESTING[] = { 0u, 1u, 0x7Fu, 0x80u, 0xFFu, 0x7FFFu, 0xFFFFu, 0x10000000u, 0x7FFFFFFFu, 0xFFFFFFF0u, 0xFFFFFFFFu };
+
+        uint32_t count = 1u + random() % 4u;
+        for (uint32_t i = 0u; i < count && !input.empty(); i++)
+        {
+            uint32_t at = random() % (uint32_t)input.size();
+            switch (random() % 5u)
+            {
+                case 0u:
+                    input[at] ^= (uint8_t)(1u << (random() % 8u));
+                    break;
+                case 1u:
+                    input[at] = (uint8_t)random();
+                    break;
+                case 2u:
+                case 3u:
+                {
+                    uint32_t value = INTERESTING[random() % (sizeof(INTERESTING) / sizeof(INTERESTING[0]))];
+                    at &= ~3u;
+                    for (uint32_t b = 0u; b < 4u && at + b < input.size(); b++)
+                    {
+                        input[at + b] = (uint8_t)(value >> (8u * b));
+                    }
+                    break;
+                }
+                default:
+                    input.resize(at);
+                    break;
+            }
+        }
+    }
+
+    bool readFile(const char *path, std::vector<uint8_t> &data)
+    {
+        FILE *file = std::fopen(path, "rb");
+        if (file == nullptr)
+        {
+            return false;
+        }
+
+        uint8_t buffer[4096];
+        size_t got = 0u;
+        data.clear();
+        while ((got = std::fread(buffer, 1u, sizeof(buffer), file)) != 0u)
+        {
+            data.insert(data.end(), buffer, buffer + got);
+        }
+        std::fclose(file);
+        return true;
+    }
+
+    bool writeFile(const std::string &path, const std::vector<uint8_t> &data)
+    {
+        FILE *file = std::fopen(path.c_str(), "wb");
+        if (file == nullptr)
+        {
+            return false;
+        }
+
+        bool written = std::fwrite(data.data(), 1u, data.size(), file) == data.size();
+        return (std::fclose(file) == 0) && written;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::vector<std::vector<uint8_t>> seeds = { elfSeed(), binSeed() };
+
+    if (argc == 3 && std::strcmp(argv[1], "--seeds") == 0)
+    {
+        std::string directory = argv[2];
+        bool written = writeFile(directory + "/module.elf", seeds[0]) && writeFile(directory + "/module.bin", seeds[1]);
+        std::printf("%s\n", written ? "seeds written" : "cannot write seeds");
+        return written ? 0 : 1;
+    }
+
+    uint32_t iterations = (argc > 1) ? (uint32_t)std::strtoul(argv[1], nullptr, 0) : 200000u;
+    for (int i = 2; i < argc; i++)
+    {
+        std::vector<uint8_t> data;
+        if (!readFile(argv[i], data))
+        {
+            std::fprintf(stderr, "cannot read %s\n", argv[i]);
+            return 1;
+        }
+        seeds.push_back(data);
+    }
+
+    // The seeds themselves must load, otherwise the mutations explore nothing
+    int status = ELF_OK;
+    {
+        Input seed = { seeds[0].data(), (uint32_t)seeds[0].size() };
+        ElfFile elf;
+        elf.setAllocator(fuzzAllocate, fuzzDeallocate);
+        elf.setResolver(fuzzResolve);
+        elf.setFileSize(seed.size);
+
+        uint32_t *stack = nullptr;
+        uint32_t stackSize = 0u;
+        uint32_t vtorOffset = 0u;
+        status = elf.parse(inputReader, &seed, &stack, &stackSize, &vtorOffset);
+        fuzzDeallocate(elf.getImage());
+        fuzzDeallocate(elf.getRam());
+    }
+    if (status != ELF_OK)
+    {
+        std::fprintf(stderr, "ELF seed does not load: %d\n", status);
+        return 1;
+    }
+
+    std::mt19937 random(2026u);
+    for (uint32_t i = 0u; i < iterations; i++)
+    {
+        std::vector<uint8_t> input = seeds[i % seeds.size()];
+        mutate(input, random);
+        LLVMFuzzerTestOneInput(input.data(), input.size());
+    }
+
+    std::printf("%lu inputs\n", (unsigned long)iterations);
+    return 0;
+}
+
+#endif
@@ -0,0 +1,274 @@
+/*
+ * HeapReplay
+ * Author: Arkadiusz Szlanta
+ * Date: 17 Oct 2026
+ *
+ * License:
+ * This source code is provided for hobbyist and private use only.
+ * Any commercial or industrial use, including distribution, reproduction, or
+ * incorporation in commercial or industrial products or services is prohibited.
+ * Use at your own risk. The author(s) hold no responsibility for any damages
+ * or losses resulting from the use of this software.
+ *
+ */
+
+// Host side replay of allocation traces captured with CRTOS::Config::DumpHeapTrace.
+//
+// Build (Linux):
+//   g++ -std=c++17 -O2 -I.. HeapReplay.cpp ../HeapAllocator.cpp ../MemoryOps.cpp -o heap_replay
+//
+// Usage:
+//   heap_replay <trace.csv> [pool_size_bytes] [iterations]
+//
+// Every trace line has the form "op,size,ptr,task,cycles" where op is 'A' or 'D'.
+// The trace is replayed against each allocator below, reporting time per operation,
+// failed allocations, peak usage and fragmentation of the free space.
+
+#include <HeapAllocator.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct TraceOp
+{
+    bool allocate;
+    uint32_t size;
+    uint64_t ptr;
+};
+
+class ReplayAllocator
+{
+    public:
+        virtual ~ReplayAllocator() = default;
+
+        virtual const char* name(void) const = 0;
+        virtual void reset(void) = 0;
+        virtual void* allocate(uint32_t size) = 0;
+        virtual void deallocate(void *ptr) = 0;
+
+        // Return false when the allocator cannot report its internal state
+        virtual bool usage(uint32_t &allocated, uint32_t &freeBytes, uint32_t &largestFree) const = 0;
+};
+
+class CrtosHeap : public ReplayAllocator
+{
+    public:
+        explicit CrtosHeap(uint32_t poolSize) : mPool(poolSize / sizeof(uint64_t) + 1u), mPoolSize(poolSize) {}
+
+        const char* name(void) const override { return "HeapAllocator"; }
+        void reset(void) override { mHeap = HeapAllocator(); mHeap.init(mPool.data(), mPoolSize); }
+        void* allocate(uint32_t size) override { return mHeap.allocate(size); }
+        void deallocate(void *ptr) override { mHeap.deallocate(ptr); }
+
+        bool usage(uint32_t &allocated, uint32_t &freeBytes, uint32_t &largestFree) const override
+        {
+            allocated = mHeap.getAllocatedMemory();
+            freeBytes = mHeap.getFreeMemory();
+            largestFree = mHeap.getLargestFreeBlock();
+            return true;
+        }
+
+    private:
+        std::vector<uint64_t> mPool;
+        uint32_t mPoolSize;
+        HeapAllocator mHeap;
+};
+
+class LibcHeap : public ReplayAllocator
+{
+    public:
+        const char* name(void) const override { return "libc malloc"; }
+        void reset(void) override {}
+        void* allocate(uint32_t size) override { return std::malloc(size); }
+        void deallocate(void *ptr) override { std::free(ptr); }
+
+        bool usage(uint32_t &, uint32_t &, uint32_t &) const override
+        {
+            return false;
+        }
+};
+
+static bool loadTrace(const char *path, std::vector<TraceOp> &ops)
+{
+    FILE *file = std::fopen(path, "r");
+    if (file == nullptr)
+    {
+        std::perror(path);
+        return false;
+    }
+
+    char line[256];
+    while (std::fgets(line, sizeof(line), file) != nullptr)
+    {
+        char op = 0;
+        unsigned long size = 0u;
+        unsigned long long ptr = 0u;
+        unsigned long long task = 0u;
+        unsigned long cycles = 0u;
+
+        if (std::sscanf(line, " %c,%lu,%llx,%llx,%lu", &op, &size, &ptr, &task, &cycles) != 5)
+        {
+            continue;
+        }
+        if (op != 'A' && op != 'D')
+        {
+            continue;
+        }
+
+        ops.push_back(TraceOp{op == 'A', (uint32_t)size, ptr});
+    }
+
+    std::fclose(file);
+    return true;
+}
+
+static void replay(ReplayAllocator &allocator, const std::vector<TraceOp> &ops, uint32_t iterations)
+{
+    std::unordered_map<uint64_t, void*> live;
+    uint64_t totalNs = 0u;
+    uint32_t failed = 0u;
+    uint32_t peakAllocated = 0u;
+    uint32_t peakRequested = 0u;
+    uint32_t worstLargest = UINT32_MAX;
+    double worstFragmentation = 0.0;
+    bool hasUsage = false;
+
+    for (uint32_t it = 0u; it < iterations; it++)
+    {
+        allocator.reset();
+        live.clear();
+        uint32_t requested = 0u;
+        std::unordered_map<uint64_t, uint32_t> sizes;
+
+        for (const TraceOp &op : ops)
+        {
+            if (op.allocate)
+            {
+                // Failed allocations on target have ptr == 0, replay them anyway
+                auto start = std::chrono::steady_clock::now();
+                void *ptr = allocator.allocate(op.size);
+                totalNs += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+                if (ptr == nullptr)
+                {
+                    failed++;
+                    continue;
+                }
+                if (op.ptr != 0u)
+                {
+                    live[op.ptr] = ptr;
+                    sizes[op.ptr] = op.size;
+                    requested += op.size;
+                }
+                else
+                {
+                    allocator.deallocate(ptr);
+                }
+            }
+            else
+            {
+                auto found = live.find(op.ptr);
+                if (found == live.end())
+                {
+                    // Allocated before the trace window started
+                    continue;
+                }
+
+                auto start = std::chrono::steady_clock::now();
+                allocator.deallocate(found->second);
+                totalNs += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+                requested -= sizes[op.ptr];
+                sizes.erase(op.ptr);
+                live.erase(found);
+            }
+
+            if (requested > peakRequested)
+            {
+                peakRequested = requested;
+            }
+
+            uint32_t allocated, freeBytes, largestFree;
+            if (allocator.usage(allocated, freeBytes, largestFree))
+            {
+                hasUsage = true;
+                if (allocated > peakAllocated)
+                {
+                    peakAllocated = allocated;
+                }
+                if (largestFree < worstLargest)
+                {
+                    worstLargest = largestFree;
+                }
+                if (freeBytes != 0u)
+                {
+                    double fragmentation = 1.0 - (double)largestFree / (double)freeBytes;
+                    if (fragmentation > worstFragmentation)
+                    {
+                        worstFragmentation = fragmentation;
+                    }
+                }
+            }
+        }
+
+        for (auto &entry : live)
+        {
+            allocator.deallocate(entry.second);
+        }
+    }
+
+    uint64_t opCount = (uint64_t)ops.size() * iterations;
+
+    std::printf("%s\n", allocator.name());
+    std::printf("  time per op      : %.1f ns\n", opCount ? (double)totalNs / (double)opCount : 0.0);
+    std::printf("  failed allocs    : %u in %u iterations\n", failed, iterations);
+    std::printf("  peak requested   : %u bytes\n", peakRequested);
+    if (hasUsage)
+    {
+        std::printf("  peak allocated   : %u bytes\n", peakAllocated);
+        std::printf("  min largest free : %u bytes\n", worstLargest);
+        std::printf("  max fragmentation: %.1f %%\n", worstFragmentation * 100.0);
+    }
+    else
+    {
+        std::printf("  usage            : not reported by this allocator\n");
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        std::fprintf(stderr, "usage: %s <trace.csv> [pool_size_bytes] [iterations]\n", argv[0]);
+        return 1;
+    }
+
+    uint32_t poolSize = (argc > 2) ? (uint32_t)std::strtoul(argv[2], nullptr, 0) : 64u * 1024u;
+    uint32_t iterations = (argc > 3) ? (uint32_t)std::strtoul(argv[3], nullptr, 0) : 10u;
+
+    std::vector<TraceOp> ops;
+    if (!loadTrace(argv[1], ops))
+    {
+        return 1;
+    }
+
+    std::printf("%zu operations, pool %u bytes, %u iterations\n\n", ops.size(), poolSize, iterations);
+
+    std::vector<std::unique_ptr<ReplayAllocator>> allocators;
+    allocators.emplace_back(new CrtosHeap(poolSize));
+    allocators.emplace_back(new LibcHeap());
+
+    for (auto &allocator : allocators)
+    {
+        replay(*allocator, ops, iterations);
+    }
+
+    return 0;
+}
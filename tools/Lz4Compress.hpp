@@ -0,0 +1,106 @@
+/*
+ * Lz4Compress
+ * Author: Arkadiusz Szlanta
+ * Date: 17 Oct 2026
+ *
+ * License:
+ * This source code is provided for hobbyist and private use only.
+ * Any commercial or industrial use, including distribution, reproduction, or
+ * incorporation in commercial or industrial products or services is prohibited.
+ * Use at your own risk. The author(s) hold no responsibility for any damages
+ * or losses resulting from the use of this software.
+ *
+ */
+
+// Host side LZ4 block encoder shared by ModulePacker and Lz4RoundTrip. The device
+// only decodes, see Lz4.hpp.
+
+#ifndef LZ4_COMPRESS_HPP
+#define LZ4_COMPRESS_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Greedy LZ4 block compressor, output follows the reference end of block rules
+inline std::vector<uint8_t> lz4Compress(const uint8_t *src, uint32_t size)
+{
+    static constexpr uint32_t HASH_BITS = 14u;
+    static constexpr uint32_t MIN_MATCH = 4u;
+    static constexpr uint32_t LAST_LITERALS = 5u;
+    static constexpr uint32_t MATCH_LIMIT = 12u; // No match starts in the last 12 bytes
+    static constexpr uint32_t MAX_DISTANCE = 0xFFFFu;
+
+    std::vector<uint8_t> out;
+    std::vector<int64_t> table(1u << HASH_BITS, -1);
+    uint32_t anchor = 0u;
+
+    auto hash = [src](uint32_t pos)
+    {
+        uint32_t value;
+        std::memcpy(&value, src + pos, sizeof(value));
+        return (value * 2654435761u) >> (32u - HASH_BITS);
+    };
+
+    auto length = [&out](uint32_t value)
+    {
+        for (; value >= 255u; value -= 255u)
+        {
+            out.push_back(255u);
+        }
+        out.push_back((uint8_t)value);
+    };
+
+    auto literals = [&](uint32_t count, uint8_t matchNibble)
+    {
+        out.push_back((uint8_t)(((count < 15u) ? count : 15u) << 4u) | matchNibble);
+        if (count >= 15u)
+        {
+            length(count - 15u);
+        }
+        out.insert(out.end(), src + anchor, src + anchor + count);
+    };
+
+    for (uint32_t pos = 0u; size > MATCH_LIMIT && pos < size - MATCH_LIMIT;)
+    {
+        uint32_t h = hash(pos);
+        int64_t candidate = table[h];
+        table[h] = pos;
+
+        if (candidate < 0 || pos - candidate > MAX_DISTANCE || std::memcmp(src + candidate, src + pos, MIN_MATCH) != 0)
+        {
+            pos++;
+            continue;
+        }
+
+        uint32_t match = (uint32_t)candidate;
+        uint32_t matchLength = MIN_MATCH;
+        while (pos + matchLength < size - LAST_LITERALS && src[match + matchLength] == src[pos + matchLength])
+        {
+            matchLength++;
+        }
+        while (pos > anchor && match > 0u && src[pos - 1u] == src[match - 1u])
+        {
+            pos--;
+            match--;
+            matchLength++;
+        }
+
+        uint32_t extra = matchLength - MIN_MATCH;
+        literals(pos - anchor, (uint8_t)((extra < 15u) ? extra : 15u));
+        out.push_back((uint8_t)(pos - match));
+        out.push_back((uint8_t)((pos - match) >> 8u));
+        if (extra >= 15u)
+        {
+            length(extra - 15u);
+        }
+
+        pos += matchLength;
+        anchor = pos;
+    }
+
+    literals(size - anchor, 0u);
+    return out;
+}
+
+#endif /* LZ4_COMPRESS_HPP */
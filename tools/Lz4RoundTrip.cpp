@@ -0,0 +1,219 @@
+/*
+ * Lz4RoundTrip
+ * Author: Arkadiusz Szlanta
+ * Date: 17 Oct 2026
+ *
+ * License:
+ * This source code is provided for hobbyist and private use only.
+ * Any commercial or industrial use, including distribution, reproduction, or
+ * incorporation in commercial or industrial products or services is prohibited.
+ * Use at your own risk. The author(s) hold no responsibility for any damages
+ * or losses resulting from the use of this software.
+ *
+ */
+
+// Host side check of the module image decoder against the ModulePacker encoder.
+//
+// Build (Linux), preferably with sanitizers:
+//   g++ -std=c++17 -O1 -g -fsanitize=address,undefined -I.. Lz4RoundTrip.cpp ../Lz4.cpp -o lz4_round_trip
+//   lz4_round_trip
+//
+// Every encoded sample must decode back bit exact. Decoding into a buffer one byte
+// short must report LZ4_ERROR_OVERFLOW, truncated blocks must never produce the full
+// output, and hand made corrupt blocks must hit their error paths. Random input only
+// has to decode without touching memory outside the buffers. Prints the number of
+// failed checks and returns non-zero if there was any.
+
+#include <Lz4.hpp>
+
+#include "Lz4Compress.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace
+{
+    uint32_t sChecks = 0u;
+    uint32_t sFailures = 0u;
+
+    void check(bool condition, const char *what, uint32_t sample)
+    {
+        sChecks++;
+        if (!condition)
+        {
+            sFailures++;
+            std::printf("FAIL %s, sample %lu\n", what, (unsigned long)sample);
+        }
+    }
+
+    struct Block
+    {
+        const std::vector<uint8_t> *data;
+        uint32_t readable;     // Reads past this offset fail like a broken flash
+    };
+
+    int blockReader(void *context, uint32_t offset, void *dst, uint32_t length)
+    {
+        const Block &block = *static_cast<const Block *>(context);
+        if (offset > block.readable || block.readable - offset < length)
+        {
+            return -1;
+        }
+
+        std::memcpy(dst, block.data->data() + offset, length);
+        return 0;
+    }
+
+    // Decodes into a buffer of exactly dstSize bytes so ASan sees every overrun
+    int decode(const std::vector<uint8_t> &packed, uint32_t packedSize, uint32_t dstSize, std::vector<uint8_t> &out, uint32_t &produced)
+    {
+        Block block = { &packed, (uint32_t)packed.size() };
+        out.assign(dstSize, 0u);
+        return Lz4::Decode(blockReader, &block, 0u, packedSize, out.empty() ? nullptr : out.data(), dstSize, produced);
+    }
+
+    // Samples like the ones found in module images: runs, short periods, text and noise
+    std::vector<uint8_t> makeSample(uint32_t kind, uint32_t size, std::mt19937 &random)
+    {
+        static const char TEXT[] = "CRTOS module image, .text .rodata .data and relocations. ";
+        std::vector<uint8_t> sample(size);
+
+        for (uint32_t i = 0u; i < size; i++)
+        {
+            switch (kind)
+            {
+                case 0u: sample[i] = (uint8_t)random(); break;
+                case 1u: sample[i] = 0u; break;
+                case 2u: sample[i] = (uint8_t)(i % (1u + size % 7u)); break;
+                case 3u: sample[i] = (uint8_t)TEXT[i % (sizeof(TEXT) - 1u)]; break;
+                default: sample[i] = ((random() & 3u) == 0u) ? (uint8_t)random() : (uint8_t)(i >> 3u); break;
+            }
+        }
+
+        return sample;
+    }
+
+    void roundTrip(const std::vector<uint8_t> &sample, uint32_t id)
+    {
+        std::vector<uint8_t> packed = lz4Compress(sample.data(), (uint32_t)sample.size());
+        std::vector<uint8_t> out;
+        uint32_t produced = 0u;
+        uint32_t size = (uint32_t)sample.size();
+
+        int status = decode(packed, (uint32_t)packed.size(), size, out, produced);
+        check(status == LZ4_OK && produced == size && out == sample, "round trip", id);
+
+        if (size != 0u)
+        {
+            status = decode(packed, (uint32_t)packed.size(), size - 1u, out, produced);
+            check(status == LZ4_ERROR_OVERFLOW, "short output", id);
+
+            // Cutting a block must never pass for the whole image
+            uint32_t step = (packed.size() > 256u) ? (uint32_t)packed.size() / 97u : 1u;
+            for (uint32_t cut = 0u; cut < packed.size(); cut += step)
+            {
+                status = decode(packed, cut, size, out, produced);
+                check((status == LZ4_OK && produced < size) || status == LZ4_ERROR_BAD_FORMAT, "truncated", id);
+            }
+        }
+
+        // The reader failing mid block is reported as such
+        if (packed.size() > LZ4_INPUT_WINDOW)
+        {
+            Block block = { &packed, LZ4_INPUT_WINDOW };
+            out.assign(size, 0u);
+            status = Lz4::Decode(blockReader, &block, 0u, (uint32_t)packed.size(), out.data(), size, produced);
+            check(status == LZ4_ERROR_READ, "read error", id);
+        }
+    }
+
+    void corruptBlocks(void)
+    {
+        struct Corrupt
+        {
+            const char *name;
+            std::vector<uint8_t> block;
+            uint32_t dstSize;
+            int expected;
+        };
+
+        const Corrupt cases[] =
+        {
+            // Literal 'a', then a match 0 bytes back
+            { "zero distance", { 0x10u, 'a', 0x00u, 0x00u, 0x00u }, 64u, LZ4_ERROR_BAD_FORMAT },
+            // Match reaching before the start of the output
+            { "distance before start", { 0x10u, 'a', 0x02u, 0x00u, 0x00u }, 64u, LZ4_ERROR_BAD_FORMAT },
+            // Offset cut after its first byte
+            { "cut offset", { 0x10u, 'a', 0x01u }, 64u, LZ4_ERROR_BAD_FORMAT },
+            // 15 literals announced, length extension missing
+            { "missing literal length", { 0xF0u }, 64u, LZ4_ERROR_BAD_FORMAT },
+            // 4 literals announced, 2 present
+            { "short literals", { 0x40u, 'a', 'b' }, 64u, LZ4_ERROR_BAD_FORMAT },
+            // 3 literals into 2 bytes
+            { "literal overflow", { 0x30u, 'a', 'b', 'c' }, 2u, LZ4_ERROR_OVERFLOW },
+            // 'a' repeated 4 + 15 + 200 times into 64 bytes
+            { "match overflow", { 0x1Fu, 'a', 0x01u, 0x00u, 200u, 0x00u }, 64u, LZ4_ERROR_OVERFLOW },
+            // Match length extension missing
+            { "missing match length", { 0x1Fu, 'a', 0x01u, 0x00u }, 64u, LZ4_ERROR_BAD_FORMAT },
+        };
+
+        uint32_t id = 0u;
+        for (const Corrupt &corrupt : cases)
+        {
+            std::vector<uint8_t> out;
+            uint32_t produced = 0u;
+            int status = decode(corrupt.block, (uint32_t)corrupt.block.size(), corrupt.dstSize, out, produced);
+            if (status != corrupt.expected)
+            {
+                std::printf("%s: got %d, expected %d\n", corrupt.name, status, corrupt.expected);
+            }
+            check(status == corrupt.expected, "corrupt block", id++);
+        }
+    }
+
+    // Any answer is fine, the sanitizers catch accesses outside the buffers
+    void randomBlocks(std::mt19937 &random)
+    {
+        for (uint32_t i = 0u; i < 20000u; i++)
+        {
+            std::vector<uint8_t> block(random() % 64u);
+            for (uint8_t &value : block)
+            {
+                value = (uint8_t)random();
+            }
+
+            std::vector<uint8_t> out;
+            uint32_t produced = 0u;
+            uint32_t dstSize = random() % 512u;
+            int status = decode(block, (uint32_t)block.size(), dstSize, out, produced);
+            check(status != LZ4_OK || produced <= dstSize, "random block", i);
+        }
+    }
+}
+
+int main(void)
+{
+    std::mt19937 random(2026u);
+    uint32_t id = 0u;
+
+    for (uint32_t kind = 0u; kind < 5u; kind++)
+    {
+        for (uint32_t size = 0u; size < 300u; size++)
+        {
+            roundTrip(makeSample(kind, size, random), id++);
+        }
+        for (uint32_t size : { 4096u, 65535u, 65536u, 65537u, 200000u })
+        {
+            roundTrip(makeSample(kind, size, random), id++);
+        }
+    }
+
+    corruptBlocks();
+    randomBlocks(random);
+
+    std::printf("%lu checks, %lu failed\n", (unsigned long)sChecks, (unsigned long)sFailures);
+    return (sFailures == 0u) ? 0 : 1;
+}
@@ -0,0 +1,218 @@
+/*
+ * MemBench
+ * Author: Arkadiusz Szlanta
+ * Date: 17 Oct 2026
+ *
+ * License:
+ * This source code is provided for hobbyist and private use only.
+ * Any commercial or industrial use, including distribution, reproduction, or
+ * incorporation in commercial or industrial products or services is prohibited.
+ * Use at your own risk. The author(s) hold no responsibility for any damages
+ * or losses resulting from the use of this software.
+ *
+ */
+
+// Micro-benchmark of the memory routines against the C library ones, sweeping sizes
+// from 1 byte to MEMBENCH_MAX_SIZE and every source/destination offset within a word.
+//
+// Build (Linux), timed with a monotonic clock:
+//   g++ -std=c++17 -O2 -I.. MemBench.cpp ../MemoryOps.cpp -o mem_bench
+//   mem_bench > bench.csv
+//
+// On target add this file to the firmware and call MemBenchRun from a task with an
+// output writing to the console. Time is taken from DWT->CYCCNT.
+//
+// Every line is "function,size,src_align,dst_align,bytes_per_unit" where the unit is
+// a cycle on target and a nanosecond on host, see the header line. The best of
+// MEMBENCH_RUNS runs is reported, each run repeats the call until about
+// MEMBENCH_BYTES_PER_RUN bytes were processed.
+
+#include <MemoryOps.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#ifndef MEMBENCH_MAX_SIZE
+#define MEMBENCH_MAX_SIZE 65536u
+#endif
+
+#ifndef MEMBENCH_RUNS
+#define MEMBENCH_RUNS 5u
+#endif
+
+#if defined(__arm__)
+
+#ifndef MEMBENCH_BYTES_PER_RUN
+#define MEMBENCH_BYTES_PER_RUN 16384u
+#endif
+
+#define MEMBENCH_DEMCR      (*(volatile uint32_t *)0xE000EDFCul)
+#define MEMBENCH_DWT_CTRL   (*(volatile uint32_t *)0xE0001000ul)
+#define MEMBENCH_DWT_CYCCNT (*(volatile uint32_t *)0xE0001004ul)
+
+static const char *const sUnit = "cycle";
+
+static void clockInit(void)
+{
+    MEMBENCH_DEMCR |= (1ul << 24u);  // TRCENA
+    MEMBENCH_DWT_CTRL |= 1ul;        // CYCCNTENA
+}
+
+static uint64_t clockNow(void)
+{
+    return MEMBENCH_DWT_CYCCNT;
+}
+
+// Elapsed cycles, the counter wraps every few tens of seconds
+static uint64_t clockElapsed(uint64_t start, uint64_t end)
+{
+    return (uint32_t)((uint32_t)end - (uint32_t)start);
+}
+
+#else
+
+#include <chrono>
+
+#ifndef MEMBENCH_BYTES_PER_RUN
+#define MEMBENCH_BYTES_PER_RUN (1024u * 1024u)
+#endif
+
+static const char *const sUnit = "ns";
+
+static void clockInit(void)
+{
+}
+
+static uint64_t clockNow(void)
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static uint64_t clockElapsed(uint64_t start, uint64_t end)
+{
+    return end - start;
+}
+
+#endif
+
+namespace
+{
+    struct BenchFunction
+    {
+        const char *name;
+        bool usesSource;
+        void (*call)(uint8_t *dst, const uint8_t *src, uint32_t len);
+    };
+
+    // Called through pointers so the library calls cannot be inlined or elided
+    void libMemcpy(uint8_t *dst, const uint8_t *src, uint32_t len) { std::memcpy(dst, src, len); }
+    void optMemcpy(uint8_t *dst, const uint8_t *src, uint32_t len) { memcpy_optimized(dst, src, len); }
+    void libMemmove(uint8_t *dst, const uint8_t *src, uint32_t len) { std::memmove(dst, src, len); }
+    void optMemmove(uint8_t *dst, const uint8_t *src, uint32_t len) { memmove_optimized(dst, src, len); }
+    void libMemset(uint8_t *dst, const uint8_t *, uint32_t len) { std::memset(dst, 0x5A, len); }
+    void optMemset(uint8_t *dst, const uint8_t *, uint32_t len) { memset_optimized(dst, 0x5Au, len); }
+
+    volatile BenchFunction sFunctions[] =
+    {
+        { "memcpy", true, libMemcpy },
+        { "memcpy_optimized", true, optMemcpy },
+        { "memmove", true, libMemmove },
+        { "memmove_optimized", true, optMemmove },
+        { "memset", false, libMemset },
+        { "memset_optimized", false, optMemset },
+    };
+
+    // Around every power of two, where block thresholds change
+    const int32_t sSizeSteps[] = { -1, 0, 1 };
+
+    alignas(32) uint8_t sSource[MEMBENCH_MAX_SIZE + 32u];
+    alignas(32) uint8_t sDestination[MEMBENCH_MAX_SIZE + 32u];
+
+    uint64_t measure(const volatile BenchFunction &function, uint32_t size, uint32_t srcAlign, uint32_t dstAlign)
+    {
+        void (*call)(uint8_t *, const uint8_t *, uint32_t) = function.call;
+        uint32_t repeats = (size < MEMBENCH_BYTES_PER_RUN) ? (MEMBENCH_BYTES_PER_RUN / size) : 1u;
+        uint64_t best = ~0ull;
+
+        for (uint32_t run = 0u; run < MEMBENCH_RUNS; run++)
+        {
+            uint64_t start = clockNow();
+            for (uint32_t i = 0u; i < repeats; i++)
+            {
+                call(&sDestination[dstAlign], &sSource[srcAlign], size);
+            }
+            uint64_t elapsed = clockElapsed(start, clockNow());
+
+            if (elapsed < best)
+            {
+                best = elapsed;
+            }
+        }
+
+        // Per call, in thousandths of a unit to keep small sizes readable
+        return (best * 1000u) / repeats;
+    }
+
+    void report(void (*output)(const char *line), const char *name, uint32_t size, uint32_t srcAlign, uint32_t dstAlign, uint64_t milliUnits)
+    {
+        char line[96];
+        uint64_t bytesPerKiloUnit = (milliUnits == 0u) ? 0u : ((uint64_t)size * 1000000u) / milliUnits;
+
+        snprintf(line, sizeof(line), "%s,%lu,%lu,%lu,%lu.%03lu\r\n", name, (unsigned long)size,
+                 (unsigned long)srcAlign, (unsigned long)dstAlign,
+                 (unsigned long)(bytesPerKiloUnit / 1000u), (unsigned long)(bytesPerKiloUnit % 1000u));
+        output(line);
+    }
+}
+
+extern "C" void MemBenchRun(void (*output)(const char *line))
+{
+    char header[64];
+
+    clockInit();
+    for (uint32_t i = 0u; i < sizeof(sSource); i++)
+    {
+        sSource[i] = (uint8_t)(i * 7u);
+    }
+
+    snprintf(header, sizeof(header), "function,size,src_align,dst_align,bytes_per_%s\r\n", sUnit);
+    output(header);
+
+    for (uint32_t power = 1u; power <= MEMBENCH_MAX_SIZE; power <<= 1u)
+    {
+        for (int32_t step : sSizeSteps)
+        {
+            uint32_t size = power + step;
+            if (size > MEMBENCH_MAX_SIZE || (step != 0 && power < 4u))
+            {
+                continue;
+            }
+
+            for (const volatile BenchFunction &function : sFunctions)
+            {
+                for (uint32_t srcAlign = 0u; srcAlign < (function.usesSource ? 4u : 1u); srcAlign++)
+                {
+                    for (uint32_t dstAlign = 0u; dstAlign < 4u; dstAlign++)
+                    {
+                        report(output, function.name, size, srcAlign, dstAlign, measure(function, size, srcAlign, dstAlign));
+                    }
+                }
+            }
+        }
+    }
+}
+
+#if !defined(__arm__)
+static void printLine(const char *line)
+{
+    std::fputs(line, stdout);
+}
+
+int main(void)
+{
+    MemBenchRun(printLine);
+    return 0;
+}
+#endif
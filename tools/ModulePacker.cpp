@@ -0,0 +1,693 @@
+/*
+ * ModulePacker
+ * Author: Arkadiusz Szlanta
+ * Date: 17 Oct 2026
+ *
+ * License:
+ * This source code is provided for hobbyist and private use only.
+ * Any commercial or industrial use, including distribution, reproduction, or
+ * incorporation in commercial or industrial products or services is prohibited.
+ * Use at your own risk. The author(s) hold no responsibility for any damages
+ * or losses resulting from the use of this software.
+ *
+ */
+
+// Host side converter of ELF modules into CRTOS BIN modules.
+//
+// Build (Linux):
+//   g++ -std=c++17 -O2 -I.. ModulePacker.cpp ../Lz4.cpp -o module_packer
+//
+// Usage:
+//   module_packer [-z] <module.elf> <module.bin> [stack_size_bytes]
+//
+// The module must be linked with --emit-relocs (or as PIE) and reserve a
+// ModuleDescriptorBin right after its ProgramInfo. The read-only segments are
+// rebased to image offset 0 and the writable ones to RAM offset 0, every absolute
+// pointer becomes one relocation entry and undefined symbols become imports.
+// The device then loads the module by linear patching only, see
+// MODULE_FLAG_RELOCATIONS in module_api.h.
+//
+// With -z the image is stored as an LZ4 block (MODULE_FLAG_COMPRESSED). The block
+// is decoded back with the device decoder before the file is written.
+
+#include <Crc.hpp>
+#include <ELFParser.hpp>
+#include <Lz4.hpp>
+#include <ModuleValidation.hpp>
+#include <module_api.h>
+
+#include "Lz4Compress.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+// The packer reads ProgramInfo through the ELF parser, the loader through ProgramInfoBin
+static_assert(sizeof(ProgramInfo) == sizeof(ProgramInfoBin), "ProgramInfo layouts differ");
+
+enum class Region
+{
+    NONE,   // Absolute address outside of the module
+    IMAGE,
+    RAM
+};
+
+struct Layout
+{
+    uint32_t imageBase = 0xFFFFFFFFu;
+    uint32_t imageEnd = 0u;
+    uint32_t ramBase = 0xFFFFFFFFu;
+    uint32_t ramEnd = 0u;
+    uint32_t dataEnd = 0u;   // End of the initialized part of RAM
+};
+
+class Packer
+{
+    public:
+        explicit Packer(std::vector<uint8_t> &&file) : mFile(std::move(file)) {}
+
+        bool pack(uint32_t stackSize, bool compress);
+        bool write(const char *path) const;
+
+    private:
+        std::vector<uint8_t> mFile;
+        Elf32_Ehdr mHeader;
+        Layout mLayout;
+        std::vector<uint8_t> mImage;
+        std::vector<uint8_t> mData;
+        uint32_t mBssSize = 0u;
+        std::vector<std::pair<uint32_t, uint32_t>> mRelocs; // place key, entry
+        std::set<uint32_t> mPatched;
+        std::vector<ModuleImportBin> mImports;
+        std::vector<uint8_t> mOutput;
+
+        template <typename T>
+        bool read(uint32_t offset, T &value) const;
+        bool section(uint32_t index, Elf32_Shdr &shdr) const;
+        Region regionOf(uint32_t address) const;
+        uint32_t *placeOf(uint32_t address, bool &inRam);
+        bool layout(void);
+        bool relocate(void);
+        bool relocateSection(const Elf32_Shdr &rel);
+        bool rebase(uint32_t P, uint32_t value);
+        bool addImport(uint32_t P, const char *name);
+        const char *symbolName(const Elf32_Shdr &symtab, const Elf32_Sym &sym) const;
+        bool compressImage(ModuleDescriptorBin &md);
+};
+
+static int bufferReader(void *context, uint32_t offset, void *dst, uint32_t length)
+{
+    const std::vector<uint8_t> &buffer = *static_cast<const std::vector<uint8_t> *>(context);
+    if (offset > buffer.size() || buffer.size() - offset < length)
+    {
+        return -1;
+    }
+
+    std::memcpy(dst, buffer.data() + offset, length);
+    return 0;
+}
+
+template <typename T>
+bool Packer::read(uint32_t offset, T &value) const
+{
+    if (offset > mFile.size() || mFile.size() - offset < sizeof(T))
+    {
+        return false;
+    }
+
+    std::memcpy(&value, &mFile[offset], sizeof(T));
+    return true;
+}
+
+bool Packer::section(uint32_t index, Elf32_Shdr &shdr) const
+{
+    return (index < mHeader.e_shnum) && read(mHeader.e_shoff + index * sizeof(Elf32_Shdr), shdr);
+}
+
+Region Packer::regionOf(uint32_t address) const
+{
+    // One past the end is still a pointer into the region
+    if (address >= mLayout.imageBase && address <= mLayout.imageEnd)
+    {
+        return Region::IMAGE;
+    }
+    if (address >= mLayout.ramBase && address <= mLayout.ramEnd)
+    {
+        return Region::RAM;
+    }
+
+    return Region::NONE;
+}
+
+// Word of the output that holds the place, nullptr when it has no initial value
+uint32_t *Packer::placeOf(uint32_t address, bool &inRam)
+{
+    if (address >= mLayout.imageBase && address + sizeof(uint32_t) <= mLayout.imageEnd)
+    {
+        inRam = false;
+        return reinterpret_cast<uint32_t *>(&mImage[address - mLayout.imageBase]);
+    }
+    if (address >= mLayout.ramBase && address + sizeof(uint32_t) <= mLayout.dataEnd)
+    {
+        inRam = true;
+        return reinterpret_cast<uint32_t *>(&mData[address - mLayout.ramBase]);
+    }
+
+    return nullptr;
+}
+
+bool Packer::layout(void)
+{
+    if (!read(0u, mHeader) ||
+        mHeader.e_ident[0] != 0x7Fu || mHeader.e_ident[1] != 'E' || mHeader.e_ident[2] != 'L' || mHeader.e_ident[3] != 'F' ||
+        mHeader.e_ident[4] != 1u || mHeader.e_ident[5] != 1u || mHeader.e_machine != EM_ARM ||
+        (mHeader.e_type != ET_EXEC && mHeader.e_type != ET_DYN) || mHeader.e_phentsize != sizeof(Elf32_Phdr))
+    {
+        std::fprintf(stderr, "not a 32-bit little endian ARM executable\n");
+        return false;
+    }
+
+    std::vector<Elf32_Phdr> loads;
+    for (uint32_t i = 0u; i < mHeader.e_phnum; i++)
+    {
+        Elf32_Phdr phdr;
+        if (!read(mHeader.e_phoff + i * sizeof(Elf32_Phdr), phdr))
+        {
+            std::fprintf(stderr, "truncated program headers\n");
+            return false;
+        }
+        if (phdr.p_type != PT_LOAD || phdr.p_memsz == 0u)
+        {
+            continue;
+        }
+        if (phdr.p_filesz > phdr.p_memsz || phdr.p_offset + phdr.p_filesz > mFile.size())
+        {
+            std::fprintf(stderr, "bad PT_LOAD segment\n");
+            return false;
+        }
+
+        if (phdr.p_flags & PF_W)
+        {
+            mLayout.ramBase = std::min(mLayout.ramBase, phdr.p_vaddr);
+            mLayout.ramEnd = std::max(mLayout.ramEnd, phdr.p_vaddr + phdr.p_memsz);
+            mLayout.dataEnd = std::max(mLayout.dataEnd, phdr.p_vaddr + phdr.p_filesz);
+        }
+        else
+        {
+            mLayout.imageBase = std::min(mLayout.imageBase, phdr.p_vaddr);
+            mLayout.imageEnd = std::max(mLayout.imageEnd, phdr.p_vaddr + phdr.p_memsz);
+        }
+        loads.push_back(phdr);
+    }
+
+    if (mLayout.imageEnd == 0u || mLayout.imageEnd - mLayout.imageBase < MODULE_HEADER_SIZE)
+    {
+        std::fprintf(stderr, "no read-only segment with ProgramInfo\n");
+        return false;
+    }
+    if (mLayout.ramEnd == 0u)
+    {
+        mLayout.ramBase = mLayout.ramEnd = mLayout.dataEnd = 0u;
+    }
+    mLayout.dataEnd = std::max(mLayout.dataEnd, mLayout.ramBase);
+
+    mImage.assign(mLayout.imageEnd - mLayout.imageBase, 0u);
+    mData.assign(mLayout.dataEnd - mLayout.ramBase, 0u);
+    mBssSize = mLayout.ramEnd - mLayout.dataEnd;
+
+    for (const Elf32_Phdr &phdr : loads)
+    {
+        std::vector<uint8_t> &out = (phdr.p_flags & PF_W) ? mData : mImage;
+        uint32_t base = (phdr.p_flags & PF_W) ? mLayout.ramBase : mLayout.imageBase;
+        std::copy_n(&mFile[phdr.p_offset], phdr.p_filesz, out.begin() + (phdr.p_vaddr - base));
+    }
+
+    ModuleDescriptorBin md;
+    std::memcpy(&md, &mImage[sizeof(ProgramInfo)], sizeof(md));
+    if (md.magic != MODULE_MAGIC)
+    {
+        std::fprintf(stderr, "module reserves no ModuleDescriptorBin after ProgramInfo\n");
+        return false;
+    }
+
+    return true;
+}
+
+bool Packer::rebase(uint32_t P, uint32_t value)
+{
+    bool inRam = false;
+    uint32_t *place = placeOf(P, inRam);
+    if (place == nullptr)
+    {
+        std::fprintf(stderr, "relocation at 0x%08x has no initial value\n", P);
+        return false;
+    }
+
+    // Both a static and a dynamic relocation may cover the same word
+    uint32_t key = (inRam ? 0x80000000u : 0u) | (P - (inRam ? mLayout.ramBase : mLayout.imageBase));
+    if (!mPatched.insert(key).second)
+    {
+        return true;
+    }
+
+    Region target = regionOf(value);
+    if (target == Region::NONE)
+    {
+        *place = value;
+        return true;
+    }
+
+    uint32_t offset = key & ~0x80000000u;
+    uint32_t entry = offset | (inRam ? MODULE_RELOC_PLACE_RAM : 0u) | ((target == Region::RAM) ? MODULE_RELOC_TARGET_RAM : 0u);
+
+    if ((offset & 3u) != 0u)
+    {
+        std::fprintf(stderr, "unaligned relocation at 0x%08x\n", P);
+        return false;
+    }
+
+    *place = value - ((target == Region::RAM) ? mLayout.ramBase : mLayout.imageBase);
+    mRelocs.emplace_back(key, entry);
+    return true;
+}
+
+bool Packer::addImport(uint32_t P, const char *name)
+{
+    bool inRam = false;
+    uint32_t *place = placeOf(P, inRam);
+    if (place == nullptr || name == nullptr || std::strlen(name) >= sizeof(ModuleImportBin::name))
+    {
+        std::fprintf(stderr, "cannot import %s at 0x%08x\n", name ? name : "?", P);
+        return false;
+    }
+
+    uint32_t key = (inRam ? 0x80000000u : 0u) | (P - (inRam ? mLayout.ramBase : mLayout.imageBase));
+    if (!mPatched.insert(key).second)
+    {
+        return true;
+    }
+
+    ModuleImportBin import;
+    std::memset(&import, 0, sizeof(import));
+    import.slot = (key & ~0x80000000u) | (inRam ? MODULE_IMPORT_RAM : 0u);
+    std::strncpy(import.name, name, sizeof(import.name) - 1u);
+    mImports.push_back(import);
+
+    *place = 0u;
+    return true;
+}
+
+const char *Packer::symbolName(const Elf32_Shdr &symtab, const Elf32_Sym &sym) const
+{
+    Elf32_Shdr strtab;
+    if (!section(symtab.sh_link, strtab) || sym.st_name >= strtab.sh_size || strtab.sh_offset + strtab.sh_size > mFile.size())
+    {
+        return nullptr;
+    }
+
+    return reinterpret_cast<const char *>(&mFile[strtab.sh_offset + sym.st_name]);
+}
+
+bool Packer::relocateSection(const Elf32_Shdr &rel)
+{
+    Elf32_Shdr symtab;
+    bool hasSymtab = section(rel.sh_link, symtab);
+
+    for (uint32_t i = 0u; i < rel.sh_size / sizeof(Elf32_Rel); i++)
+    {
+        Elf32_Rel entry;
+        if (!read(rel.sh_offset + i * sizeof(Elf32_Rel), entry))
+        {
+            return false;
+        }
+
+        uint32_t type = entry.r_info & 0xFFu;
+        uint32_t symIndex = entry.r_info >> 8u;
+        uint32_t P = entry.r_offset;
+
+        if (type == R_ARM_NONE || type == R_ARM_V4BX)
+        {
+            continue;
+        }
+
+        Elf32_Sym sym;
+        std::memset(&sym, 0, sizeof(sym));
+        if (symIndex != 0u && (!hasSymtab || !read(symtab.sh_offset + symIndex * sizeof(Elf32_Sym), sym)))
+        {
+            std::fprintf(stderr, "bad symbol of relocation at 0x%08x\n", P);
+            return false;
+        }
+
+        bool undefined = (symIndex != 0u) && (sym.st_shndx == SHN_UNDEF);
+        Region symRegion = (symIndex == 0u || sym.st_shndx == SHN_ABS || undefined) ? Region::NONE : regionOf(sym.st_value & ~1u);
+        bool inRam = false;
+        uint32_t *place = placeOf(P, inRam);
+        Region placeRegion = (place == nullptr) ? Region::NONE : (inRam ? Region::RAM : Region::IMAGE);
+
+        switch (type)
+        {
+            case R_ARM_ABS32:
+            case R_ARM_TARGET1:
+            case R_ARM_GLOB_DAT:
+            case R_ARM_JUMP_SLOT:
+                if (undefined)
+                {
+                    // A weak reference that cannot be imported stays 0
+                    if (!addImport(P, symbolName(symtab, sym)) && (sym.st_info >> 4u) != STB_WEAK)
+                    {
+                        return false;
+                    }
+                    break;
+                }
+                if (place == nullptr)
+                {
+                    std::fprintf(stderr, "relocation at 0x%08x has no initial value\n", P);
+                    return false;
+                }
+                if (!rebase(P, (type == R_ARM_GLOB_DAT || type == R_ARM_JUMP_SLOT) ? sym.st_value : *place))
+                {
+                    return false;
+                }
+                break;
+            case R_ARM_RELATIVE:
+                if (place == nullptr || !rebase(P, *place))
+                {
+                    return false;
+                }
+                break;
+            case R_ARM_REL32:
+            case R_ARM_BASE_PREL:
+            case R_ARM_THM_CALL:
+            case R_ARM_THM_JUMP24:
+                // PC relative, valid only while both ends move together
+                if (undefined || (symRegion != Region::NONE && symRegion != placeRegion))
+                {
+                    std::fprintf(stderr, "PC relative relocation at 0x%08x crosses regions, use -mlong-calls for imports\n", P);
+                    return false;
+                }
+                break;
+            case R_ARM_GOTOFF32:
+                // The GOT lives in RAM
+                if (undefined || symRegion == Region::IMAGE)
+                {
+                    std::fprintf(stderr, "GOT relative relocation at 0x%08x points out of RAM\n", P);
+                    return false;
+                }
+                break;
+            case R_ARM_GOT_BREL:
+                break;
+            case R_ARM_THM_MOVW_ABS_NC:
+            case R_ARM_THM_MOVT_ABS:
+                if (undefined || symRegion != Region::NONE)
+                {
+                    std::fprintf(stderr, "MOVW/MOVT at 0x%08x cannot be relocated, build with -fPIE\n", P);
+                    return false;
+                }
+                break;
+            default:
+                std::fprintf(stderr, "unsupported relocation type %u at 0x%08x\n", type, P);
+                return false;
+        }
+    }
+
+    return true;
+}
+
+bool Packer::relocate(void)
+{
+    for (uint32_t i = 0u; i < mHeader.e_shnum; i++)
+    {
+        Elf32_Shdr rel;
+        if (!section(i, rel))
+        {
+            return false;
+        }
+        if (rel.sh_type != SHT_REL)
+        {
+            continue;
+        }
+
+        // Skip relocations of debug sections, sh_info is 0 for dynamic relocations
+        if (rel.sh_info != 0u)
+        {
+            Elf32_Shdr target;
+            if (!section(rel.sh_info, target) || (target.sh_flags & SHF_ALLOC) == 0u)
+            {
+                continue;
+            }
+        }
+
+        if (!relocateSection(rel))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool Packer::pack(uint32_t stackSize, bool compress)
+{
+    if (!layout())
+    {
+        return false;
+    }
+
+    ProgramInfo linked;
+    std::memcpy(&linked, &mImage[0u], sizeof(linked));
+
+    // Fields rewritten below and the descriptor are metadata, not patched
+    for (uint32_t offset = 0u; offset < MODULE_HEADER_SIZE; offset += sizeof(uint32_t))
+    {
+        if (offset < offsetof(ProgramInfo, vectors) || offset >= offsetof(ProgramInfo, vectors) + sizeof(linked.vectors))
+        {
+            mPatched.insert(offset);
+        }
+    }
+
+    if (!relocate())
+    {
+        return false;
+    }
+
+    if (stackSize == 0u)
+    {
+        stackSize = (linked.stackPointer > linked.msp_limit && linked.msp_limit != 0u) ? (linked.stackPointer - linked.msp_limit) : MODULE_DEFAULT_STACK_SIZE;
+        // A stack linked at the end of RAM is not part of .bss
+        if (linked.msp_limit >= mLayout.dataEnd && linked.stackPointer == mLayout.ramEnd && stackSize <= mBssSize)
+        {
+            mBssSize -= stackSize;
+        }
+    }
+    stackSize = (stackSize + 7u) & ~7u;
+
+    uint32_t entry = (linked.entryPoint != 0u) ? linked.entryPoint : mHeader.e_entry;
+    if (regionOf(entry & ~1u) != Region::IMAGE)
+    {
+        std::fprintf(stderr, "entry point 0x%08x is outside of the image\n", entry);
+        return false;
+    }
+
+    uint32_t dataOffset = (mImage.size() + 3u) & ~3u;
+    uint32_t dataSize = (mData.size() + 3u) & ~3u;
+    uint32_t ramUsed = (dataSize + mBssSize + 7u) & ~7u;
+
+    ProgramInfo &info = *reinterpret_cast<ProgramInfo *>(&mImage[0u]);
+    info.entryPoint = (entry - mLayout.imageBase) | 1u;
+    info.section_data_start_addr = dataOffset;
+    info.section_data_dest_addr = 0u;
+    info.section_data_size = dataSize;
+    info.section_bss_start_addr = dataSize;
+    info.section_bss_size = mBssSize;
+    info.msp_limit = ramUsed;
+    info.stackPointer = ramUsed + stackSize;
+    info.vtor_offset = 0u;
+
+    // Walk memory linearly on the device: image places first, then .data, both ascending
+    std::sort(mRelocs.begin(), mRelocs.end());
+
+    uint32_t imageSize = dataOffset + dataSize;
+    uint32_t importOffset = (imageSize + 3u) & ~3u;
+    uint32_t relocOffset = importOffset + mImports.size() * sizeof(ModuleImportBin);
+
+    if (mImports.size() > 0xFFFFu || mRelocs.size() > 0xFFFFu)
+    {
+        std::fprintf(stderr, "too many imports or relocations\n");
+        return false;
+    }
+
+    mOutput.assign(relocOffset + mRelocs.size() * sizeof(uint32_t), 0u);
+    std::copy(mImage.begin(), mImage.end(), mOutput.begin());
+    std::copy(mData.begin(), mData.end(), mOutput.begin() + dataOffset);
+    for (uint32_t i = 0u; i < mImports.size(); i++)
+    {
+        std::memcpy(&mOutput[importOffset + i * sizeof(ModuleImportBin)], &mImports[i], sizeof(ModuleImportBin));
+    }
+    for (uint32_t i = 0u; i < mRelocs.size(); i++)
+    {
+        std::memcpy(&mOutput[relocOffset + i * sizeof(uint32_t)], &mRelocs[i].second, sizeof(uint32_t));
+    }
+
+    ModuleDescriptorBin md;
+    std::memcpy(&md, &mOutput[sizeof(ProgramInfo)], sizeof(md));
+    md.image_size = imageSize;
+    md.entry = info.entryPoint;
+    md.flags |= MODULE_FLAG_RELOCATIONS | MODULE_FLAG_IMAGE_CRC;
+    md.import_offset = importOffset;
+    md.import_count = (uint16_t)mImports.size();
+    md.reloc_offset = relocOffset;
+    md.reloc_count = (uint16_t)mRelocs.size();
+    if (md.api_version == 0u)
+    {
+        md.api_version = CRTOS_API_VERSION;
+    }
+    md.image_crc = CRTOS::Crc32Iso::Calculate(&mOutput[MODULE_HEADER_SIZE], imageSize - MODULE_HEADER_SIZE);
+    md.packed_size = 0u;
+    if (compress && !compressImage(md))
+    {
+        return false;
+    }
+    std::memcpy(&mOutput[sizeof(ProgramInfo)], &md, sizeof(md));
+
+    std::printf("image %u bytes, .data %u, .bss %u, stack %u, %zu relocations, %zu imports, crc 0x%08x\n",
+                dataOffset, dataSize, mBssSize, stackSize, mRelocs.size(), mImports.size(), md.image_crc);
+
+    return true;
+}
+
+// Replaces the image after the descriptor with one LZ4 block, the import and
+// relocation tables move behind it
+bool Packer::compressImage(ModuleDescriptorBin &md)
+{
+    static constexpr uint32_t ITERATIONS = 200u;
+
+    uint32_t imageSize = md.image_size;
+    std::vector<uint8_t> block = lz4Compress(&mOutput[MODULE_HEADER_SIZE], imageSize - MODULE_HEADER_SIZE);
+
+    if (MODULE_HEADER_SIZE + block.size() >= imageSize)
+    {
+        std::printf("image does not compress, stored as is\n");
+        return true;
+    }
+
+    // Round trip through the decoder used by the loader
+    std::vector<uint8_t> decoded(imageSize - MODULE_HEADER_SIZE);
+    uint32_t produced = 0u;
+    int status = Lz4::Decode(bufferReader, &block, 0u, block.size(), decoded.data(), decoded.size(), produced);
+    if (status != LZ4_OK || produced != decoded.size() ||
+        !std::equal(decoded.begin(), decoded.end(), mOutput.begin() + MODULE_HEADER_SIZE))
+    {
+        std::fprintf(stderr, "compressed image does not decode back (%d)\n", status);
+        return false;
+    }
+
+    // Host figures only, they show the decoder cost relative to a plain copy
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0u; i < ITERATIONS; i++)
+    {
+        Lz4::Decode(bufferReader, &block, 0u, block.size(), decoded.data(), decoded.size(), produced);
+    }
+    double decodeNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0u; i < ITERATIONS; i++)
+    {
+        std::memcpy(decoded.data(), &mOutput[MODULE_HEADER_SIZE], decoded.size());
+        asm volatile("" : : "r"(decoded.data()) : "memory");
+    }
+    double copyNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    uint32_t blockEnd = MODULE_HEADER_SIZE + block.size();
+    uint32_t importOffset = (blockEnd + 3u) & ~3u;
+    std::vector<uint8_t> output(mOutput.begin(), mOutput.begin() + MODULE_HEADER_SIZE);
+    output.insert(output.end(), block.begin(), block.end());
+    output.resize(importOffset, 0u);
+    output.insert(output.end(), mOutput.begin() + md.import_offset, mOutput.end());
+
+    md.reloc_offset = importOffset + (md.reloc_offset - md.import_offset);
+    md.import_offset = importOffset;
+    md.packed_size = block.size();
+    md.flags |= MODULE_FLAG_COMPRESSED;
+    mOutput.swap(output);
+
+    std::printf("compressed %u -> %u bytes, decode %.0f MB/s, copy %.0f MB/s\n",
+                imageSize - MODULE_HEADER_SIZE, md.packed_size,
+                (double)produced * ITERATIONS * 1e3 / decodeNs, (double)produced * ITERATIONS * 1e3 / copyNs);
+
+    return true;
+}
+
+bool Packer::write(const char *path) const
+{
+    FILE *file = std::fopen(path, "wb");
+    if (file == nullptr)
+    {
+        std::perror(path);
+        return false;
+    }
+
+    bool ok = std::fwrite(mOutput.data(), 1u, mOutput.size(), file) == mOutput.size();
+    ok = (std::fclose(file) == 0) && ok;
+    if (!ok)
+    {
+        std::perror(path);
+    }
+
+    return ok;
+}
+
+static bool loadFile(const char *path, std::vector<uint8_t> &data)
+{
+    FILE *file = std::fopen(path, "rb");
+    if (file == nullptr)
+    {
+        std::perror(path);
+        return false;
+    }
+
+    uint8_t buffer[4096];
+    size_t length;
+    while ((length = std::fread(buffer, 1u, sizeof(buffer), file)) > 0u)
+    {
+        data.insert(data.end(), buffer, buffer + length);
+    }
+
+    std::fclose(file);
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    bool compress = (argc > 1) && (std::strcmp(argv[1], "-z") == 0);
+    int arg = compress ? 2 : 1;
+
+    if (argc < arg + 2)
+    {
+        std::fprintf(stderr, "usage: %s [-z] <module.elf> <module.bin> [stack_size_bytes]\n", argv[0]);
+        return 1;
+    }
+
+    uint32_t stackSize = (argc > arg + 2) ? (uint32_t)std::strtoul(argv[arg + 2], nullptr, 0) : 0u;
+
+    std::vector<uint8_t> elf;
+    if (!loadFile(argv[arg], elf))
+    {
+        return 1;
+    }
+
+    Packer packer(std::move(elf));
+    if (!packer.pack(stackSize, compress) || !packer.write(argv[arg + 1]))
+    {
+        return 1;
+    }
+
+    return 0;
+}